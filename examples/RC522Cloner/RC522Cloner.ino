@@ -94,43 +94,46 @@ bool try_key(MFRC522::MIFARE_Key *key)
 {
     bool result = false;
     
-    for(byte block = 0; block < 64; block++){
-      
-    // Serial.println(F("Authenticating using key A..."));
-    status = mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, block, key, &(mfrc522.uid));
-    if (status != MFRC522::STATUS_OK) {
+    // One authentication per sector, the four blocks of a sector are read in one go.
+    for(byte sector = 0; sector < 16; sector++){
+    
+    byte sectorBuffer[64];
+    uint16_t sectorSize = sizeof(sectorBuffer);
+    MFRC522::StatusCode blockStatus[4];
+    status = mfrc522.MIFARE_ReadSector(sector, MFRC522::PICC_CMD_MF_AUTH_KEY_A, key, &(mfrc522.uid), sectorBuffer, &sectorSize, blockStatus);
+    // A wrong key fails the authentication of the first block already
+    if (status == MFRC522::STATUS_AUTH_FAILED) {
         Serial.print(F("PCD_Authenticate() failed: "));
         Serial.println(mfrc522.GetStatusCodeName(status));
         return false;
     }
 
-    // Read block
-    byte byteCount = sizeof(buffer);
-    status = mfrc522.MIFARE_Read(block, buffer, &byteCount);
-    if (status != MFRC522::STATUS_OK) {
-        Serial.print(F("MIFARE_Read() failed: "));
-        Serial.println(mfrc522.GetStatusCodeName(status));
+    for (byte i = 0; i < 4; i++) {
+      block = sector * 4 + i;
+      if (blockStatus[i] != MFRC522::STATUS_OK) {
+          Serial.print(F("MIFARE_Read() failed: "));
+          Serial.println(mfrc522.GetStatusCodeName(blockStatus[i]));
+          continue;
+      }
+      // Successful read
+      result = true;
+      Serial.print(F("Success with key:"));
+      dump_byte_array((*key).keyByte, MFRC522::MF_KEY_SIZE);
+      Serial.println();
+      
+      // Dump block data
+      Serial.print(F("Block ")); Serial.print(block); Serial.print(F(":"));
+      dump_byte_array1(&sectorBuffer[16 * i], 16); //omzetten van hex naar ASCI
+      Serial.println();
+      
+      for (int p = 0; p < 16; p++) //De 16 bits uit de block uitlezen
+      {
+        waarde [block][p] = sectorBuffer[16 * i + p];
+        Serial.print(waarde[block][p]);
+        Serial.print(" ");
+      }
+      
     }
-    else {
-        // Successful read
-        result = true;
-        Serial.print(F("Success with key:"));
-        dump_byte_array((*key).keyByte, MFRC522::MF_KEY_SIZE);
-        Serial.println();
-        
-        // Dump block data
-        Serial.print(F("Block ")); Serial.print(block); Serial.print(F(":"));
-        dump_byte_array1(buffer, 16); //omzetten van hex naar ASCI
-        Serial.println();
-        
-        for (int p = 0; p < 16; p++) //De 16 bits uit de block uitlezen
-        {
-          waarde [block][p] = buffer[p];
-          Serial.print(waarde[block][p]);
-          Serial.print(" ");
-        }
-        
-        }
     }
     Serial.println();
     
@@ -16,6 +16,7 @@
 
 #include <SPI.h>
 #include <MFRC522.h>
+#include <MFRC522KeySearch.h>
 
 #define RST_PIN         5           // Configurable, see typical pin layout above
 #define SS_PIN          15          // Configurable, see typical pin layout above
@@ -26,7 +27,7 @@ MFRC522 mfrc522(SS_PIN, RST_PIN);   // Create MFRC522 instance.
 // NOTE: Synchronize the NR_KNOWN_KEYS define with the defaultKeys[] array
 #define NR_KNOWN_KEYS   8
 // Known keys, see: https://code.google.com/p/mfcuk/wiki/MifareClassicDefaultKeys
-byte knownKeys[NR_KNOWN_KEYS][MFRC522::MF_KEY_SIZE] =  {
+const byte knownKeys[NR_KNOWN_KEYS][MFRC522::MF_KEY_SIZE] PROGMEM =  {
     {0xff, 0xff, 0xff, 0xff, 0xff, 0xff}, // FF FF FF FF FF FF = factory default
     {0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5}, // A0 A1 A2 A3 A4 A5
     {0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5}, // B0 B1 B2 B3 B4 B5
@@ -37,6 +38,9 @@ byte knownKeys[NR_KNOWN_KEYS][MFRC522::MF_KEY_SIZE] =  {
     {0x00, 0x00, 0x00, 0x00, 0x00, 0x00}  // 00 00 00 00 00 00
 };
 
+// Tries the known keys, remembers which key opened which sector of the last few cards
+MFRC522KeySearch keySearch(mfrc522, knownKeys[0], NR_KNOWN_KEYS);
+
 /*
  * Initialize.
  */
@@ -59,22 +63,24 @@ void dump_byte_array(byte *buffer, byte bufferSize) {
 }
 
 /*
- * Try using the PICC (the tag/card) with the given key to access block 0.
+ * Try the known keys on sector 0 of the PICC (the tag/card) to access block 0.
  * On success, it will show the key details, and dump the block data on Serial.
  *
- * @return true when the given key worked, false otherwise.
+ * @return true when one of the known keys worked, false otherwise.
  */
-bool try_key(MFRC522::MIFARE_Key *key)
+bool try_keys()
 {
     bool result = false;
     byte buffer[18];
     byte block = 0;
+    byte command;
+    MFRC522::MIFARE_Key key;
     MFRC522::StatusCode status;
 
-    // Serial.println(F("Authenticating using key A..."));
-    status = mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, block, key, &(mfrc522.uid));
+    // Serial.println(F("Authenticating..."));
+    status = keySearch.authenticate(0);
     if (status != MFRC522::STATUS_OK) {
-        // Serial.print(F("PCD_Authenticate() failed: "));
+        // Serial.print(F("Authentication failed: "));
         // Serial.println(mfrc522.GetStatusCodeName(status));
         return false;
     }
@@ -89,8 +95,9 @@ bool try_key(MFRC522::MIFARE_Key *key)
     else {
         // Successful read
         result = true;
+        keySearch.knownKey(0, &command, &key);
         Serial.print(F("Success with key:"));
-        dump_byte_array((*key).keyByte, MFRC522::MF_KEY_SIZE);
+        dump_byte_array(key.keyByte, MFRC522::MF_KEY_SIZE);
         Serial.println();
         // Dump block data
         Serial.print(F("Block ")); Serial.print(block); Serial.print(F(":"));
@@ -124,24 +131,7 @@ void loop() {
     MFRC522::PICC_Type piccType = mfrc522.PICC_GetType(mfrc522.uid.sak);
     Serial.println(mfrc522.PICC_GetTypeName(piccType));
     
-    // Try the known default keys
-    MFRC522::MIFARE_Key key;
-    for (byte k = 0; k < NR_KNOWN_KEYS; k++) {
-        // Copy the known key into the MIFARE_Key structure
-        for (byte i = 0; i < MFRC522::MF_KEY_SIZE; i++) {
-            key.keyByte[i] = knownKeys[k][i];
-        }
-        // Try the key
-        if (try_key(&key)) {
-            // Found and reported on the key and block,
-            // no need to try other keys for this PICC
-            break;
-        }
-        
-        // http://arduino.stackexchange.com/a/14316
-        if ( ! mfrc522.PICC_IsNewCardPresent())
-            break;
-        if ( ! mfrc522.PICC_ReadCardSerial())
-            break;
-    }
+    // Try the known default keys. A failed key costs a reselect of the card by its UID,
+    // a card seen before is opened with its key at once.
+    try_keys();
 }
@@ -52,13 +52,31 @@ void setup() {
 
 /**
  * Main loop.
+ * The REQA is started on all readers first, so the RF exchanges (and timeouts on empty readers) overlap
+ * instead of adding up.
  */
 void loop() {
+  bool started[NR_OF_READERS];
 
+  // Look for new cards on all readers at once
   for (uint8_t reader = 0; reader < NR_OF_READERS; reader++) {
-    // Look for new cards
+    started[reader] = (mfrc522[reader].PICC_StartREQA_or_WUPA(MFRC522::PICC_CMD_REQA) == MFRC522::STATUS_OK);
+  }
 
-    if (mfrc522[reader].PICC_IsNewCardPresent() && mfrc522[reader].PICC_ReadCardSerial()) {
+  for (uint8_t reader = 0; reader < NR_OF_READERS; reader++) {
+    if (!started[reader]) {
+      continue;
+    }
+    MFRC522::StatusCode status;
+    while ((status = mfrc522[reader].PCD_PollCommunication()) == MFRC522::STATUS_PENDING) {
+      // The other readers keep working while we wait here
+    }
+    byte bufferATQA[2];
+    byte bufferSize = sizeof(bufferATQA);
+    if (status == MFRC522::STATUS_OK) {
+      status = mfrc522[reader].PICC_FinishREQA_or_WUPA(bufferATQA, &bufferSize);
+    }
+    if ((status == MFRC522::STATUS_OK || status == MFRC522::STATUS_COLLISION) && mfrc522[reader].PICC_ReadCardSerial()) {
       Serial.print(F("Reader "));
       Serial.print(reader);
       // Show some details of the PICC (that is: the tag/card)
@@ -73,7 +91,7 @@ void loop() {
       mfrc522[reader].PICC_HaltA();
       // Stop encryption on PCD
       mfrc522[reader].PCD_StopCrypto1();
-    } //if (mfrc522[reader].PICC_IsNewC
+    } //if (status == MFRC522::STATUS_OK
   } //for(uint8_t reader
 }
 
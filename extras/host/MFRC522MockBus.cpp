@@ -0,0 +1,324 @@
+/*
+ * In-memory MFRC522 transport for host builds.
+ */
+#include "MFRC522MockBus.h"
+
+/**
+ * Constructor.
+ * The register file starts in its reset state with an empty response queue.
+ */
+MFRC522MockBus::MFRC522MockBus() {
+	_queueHead = 0;
+	_queueCount = 0;
+	_addressed = false;
+	_reading = false;
+	_address = 0;
+	reset();
+	resetStats();
+} // End constructor
+
+/**
+ * Loads the reset values of the register file (datasheet chapter 9) and empties the FIFO.
+ * Queued responses and statistics are kept.
+ */
+void MFRC522MockBus::reset() {
+	memset(registers, 0, sizeof(registers));
+	registers[addressOf(MFRC522::CommandReg)]		= 0x20;
+	registers[addressOf(MFRC522::ComIEnReg)]		= 0x80;
+	registers[addressOf(MFRC522::ComIrqReg)]		= 0x14;
+	registers[addressOf(MFRC522::WaterLevelReg)]	= 0x08;
+	registers[addressOf(MFRC522::ControlReg)]		= 0x10;
+	registers[addressOf(MFRC522::ModeReg)]			= 0x3F;
+	registers[addressOf(MFRC522::TxControlReg)]		= 0x80;
+	registers[addressOf(MFRC522::TxSelReg)]			= 0x10;
+	registers[addressOf(MFRC522::RxSelReg)]			= 0x84;
+	registers[addressOf(MFRC522::RxThresholdReg)]	= 0x84;
+	registers[addressOf(MFRC522::DemodReg)]			= 0x4D;
+	registers[addressOf(MFRC522::MfTxReg)]			= 0x62;
+	registers[addressOf(MFRC522::SerialSpeedReg)]	= 0xEB;
+	registers[addressOf(MFRC522::CRCResultRegH)]	= 0xFF;
+	registers[addressOf(MFRC522::CRCResultRegL)]	= 0xFF;
+	registers[addressOf(MFRC522::ModWidthReg)]		= 0x26;
+	registers[addressOf(MFRC522::RFCfgReg)]			= 0x48;
+	registers[addressOf(MFRC522::GsNReg)]			= 0x88;
+	registers[addressOf(MFRC522::CWGsPReg)]			= 0x20;
+	registers[addressOf(MFRC522::ModGsPReg)]		= 0x20;
+	registers[addressOf(MFRC522::AutoTestReg)]		= 0x40;
+	registers[addressOf(MFRC522::VersionReg)]		= 0x92;		// Version 2.0
+	fifoFlush();
+	sentLength = 0;
+	sentLastBits = 0;
+} // End reset()
+
+/**
+ * Clears the bus traffic counters.
+ */
+void MFRC522MockBus::resetStats() {
+	stats.transactions = 0;
+	stats.frames = 0;
+	stats.bytes = 0;
+} // End resetStats()
+
+/**
+ * Queues the answer of the PICC to a future Transceive or MFAuthent command.
+ *
+ * @return false if the queue is full or length exceeds the FIFO size.
+ */
+bool MFRC522MockBus::queueResponse(	const byte *data,	///< The bytes the PICC sends, including CRC_A if the command expects it.
+									byte length,		///< Number of bytes in data
+									byte validBits,		///< Number of valid bits in the last byte, 0 for 8 valid bits
+									byte error			///< ErrorReg value after reception, eg 0x08 for CollErr
+								) {
+	if (_queueCount >= QUEUE_SIZE || length > MFRC522::FIFO_SIZE) {
+		return false;
+	}
+	Response *response = &_queue[(_queueHead + _queueCount) % QUEUE_SIZE];
+	if (length) {
+		memcpy(response->data, data, length);
+	}
+	response->length = length;
+	response->validBits = validBits;
+	response->error = error;
+	response->timeout = false;
+	_queueCount++;
+	return true;
+} // End queueResponse()
+
+/**
+ * Queues a PICC that does not answer the next Transceive or MFAuthent command.
+ *
+ * @return false if the queue is full.
+ */
+bool MFRC522MockBus::queueTimeout() {
+	if (!queueResponse(nullptr, 0)) {
+		return false;
+	}
+	_queue[(_queueHead + _queueCount - 1) % QUEUE_SIZE].timeout = true;
+	return true;
+} // End queueTimeout()
+
+/**
+ * Removes all queued responses.
+ */
+void MFRC522MockBus::clearResponses() {
+	_queueHead = 0;
+	_queueCount = 0;
+} // End clearResponses()
+
+void MFRC522MockBus::beginTransaction() {
+	stats.transactions++;
+} // End beginTransaction()
+
+void MFRC522MockBus::endTransaction() {
+} // End endTransaction()
+
+void MFRC522MockBus::select() {
+	stats.frames++;
+	_addressed = false;
+} // End select()
+
+void MFRC522MockBus::deselect() {
+	_addressed = false;
+} // End deselect()
+
+/**
+ * Decodes one byte of the SPI protocol described in datasheet section 8.1.2.
+ * The first byte of a frame is the address byte. A write frame writes all following bytes to that address.
+ * In a read frame every following byte returns the register addressed by the previous byte.
+ */
+byte MFRC522MockBus::transfer(byte data) {
+	stats.bytes++;
+	if (!_addressed) {
+		_addressed = true;
+		_reading = data & 0x80;
+		_address = (data >> 1) & 0x3F;
+		return 0;
+	}
+	if (_reading) {
+		byte value = readRegister(_address);
+		_address = (data >> 1) & 0x3F;
+		return value;
+	}
+	writeRegister(_address, data);
+	return 0;
+} // End transfer()
+
+/**
+ * Returns the value the chip would put on MISO for the given register address.
+ */
+byte MFRC522MockBus::readRegister(byte address) {
+	if (address == addressOf(MFRC522::FIFODataReg)) {
+		return fifoPop();
+	}
+	if (address == addressOf(MFRC522::FIFOLevelReg)) {
+		return _fifoLength;
+	}
+	return registers[address];
+} // End readRegister()
+
+/**
+ * Applies a register write with the side effects of the chip.
+ */
+void MFRC522MockBus::writeRegister(byte address, byte value) {
+	if (address == addressOf(MFRC522::CommandReg)) {
+		registers[address] = value & 0x3F;
+		execute(value & 0x0F);
+	} else if (address == addressOf(MFRC522::ComIrqReg) || address == addressOf(MFRC522::DivIrqReg)) {
+		if (value & 0x80) {		// Set1/Set2: the marked bits are set, otherwise cleared
+			registers[address] |= value & 0x7F;
+		} else {
+			registers[address] &= ~value;
+		}
+	} else if (address == addressOf(MFRC522::FIFODataReg)) {
+		fifoPush(value);
+	} else if (address == addressOf(MFRC522::FIFOLevelReg)) {
+		if (value & 0x80) {		// FlushBuffer
+			fifoFlush();
+		}
+	} else if (address == addressOf(MFRC522::BitFramingReg)) {
+		registers[address] = value & 0x7F;
+		if ((value & 0x80) && (registers[addressOf(MFRC522::CommandReg)] & 0x0F) == MFRC522::PCD_Transceive) {
+			transceive();		// StartSend
+		}
+	} else if (address == addressOf(MFRC522::Status2Reg)) {
+		registers[address] = (value & 0xC8) | (registers[address] & 0x07);	// ModemState is read only
+	} else if (address == addressOf(MFRC522::ErrorReg) || address == addressOf(MFRC522::Status1Reg)
+			|| address == addressOf(MFRC522::CRCResultRegH) || address == addressOf(MFRC522::CRCResultRegL)
+			|| address == addressOf(MFRC522::VersionReg)) {
+		// Read only
+	} else {
+		registers[address] = value;
+	}
+} // End writeRegister()
+
+/**
+ * Runs a command written to CommandReg. Transceive waits for StartSend in BitFramingReg.
+ */
+void MFRC522MockBus::execute(byte command) {
+	switch (command) {
+		case MFRC522::PCD_CalcCRC:
+			calculateCRC();
+			break;
+		case MFRC522::PCD_MFAuthent:
+			authenticate();
+			break;
+		case MFRC522::PCD_SoftReset:
+			reset();
+			break;
+		default:
+			break;
+	}
+} // End execute()
+
+/**
+ * Transmits the FIFO and loads the next queued response.
+ */
+void MFRC522MockBus::transceive() {
+	sentLength = _fifoLength;
+	memcpy(sent, _fifo, _fifoLength);
+	sentLastBits = registers[addressOf(MFRC522::BitFramingReg)] & 0x07;
+	fifoFlush();
+	registers[addressOf(MFRC522::ComIrqReg)] |= 0x40;	// TxIRq
+
+	Response response;
+	if (!nextResponse(&response) || response.timeout) {
+		registers[addressOf(MFRC522::ComIrqReg)] |= 0x01;	// TimerIRq
+		return;
+	}
+	receive(&response);
+} // End transceive()
+
+/**
+ * Consumes the 12 byte authentication frame. MFAuthent ends by itself, signalled with IdleIRq.
+ */
+void MFRC522MockBus::authenticate() {
+	sentLength = _fifoLength;
+	memcpy(sent, _fifo, _fifoLength);
+	sentLastBits = 0;
+	fifoFlush();
+
+	Response response;
+	if (nextResponse(&response) && response.timeout) {
+		registers[addressOf(MFRC522::ComIrqReg)] |= 0x01;	// TimerIRq
+		return;
+	}
+	registers[addressOf(MFRC522::Status2Reg)] |= 0x08;		// MFCrypto1On
+	registers[addressOf(MFRC522::CommandReg)] &= ~0x0F;		// Idle
+	registers[addressOf(MFRC522::ComIrqReg)] |= 0x10;		// IdleIRq
+} // End authenticate()
+
+/**
+ * Calculates CRC_A (ISO 14443-3 Annex B) over the FIFO with the preset selected in ModeReg.
+ */
+void MFRC522MockBus::calculateCRC() {
+	static const uint16_t presets[] = {0x0000, 0x6363, 0xA671, 0xFFFF};
+	uint16_t crc = crcA(_fifo, _fifoLength, presets[registers[addressOf(MFRC522::ModeReg)] & 0x03]);
+	fifoFlush();												// The coprocessor reads the FIFO
+	registers[addressOf(MFRC522::CRCResultRegL)] = crc & 0xFF;
+	registers[addressOf(MFRC522::CRCResultRegH)] = crc >> 8;
+	registers[addressOf(MFRC522::DivIrqReg)] |= 0x04;		// CRCIRq
+} // End calculateCRC()
+
+/**
+ * Calculates CRC_A (ISO 14443-3 Annex B). The low byte is transmitted first.
+ */
+uint16_t MFRC522MockBus::crcA(	const byte *data,	///< The bytes to protect
+								uint16_t length,	///< Number of bytes in data
+								uint16_t preset		///< Initial value, 0x6363 for ISO 14443 type A
+							) {
+	uint16_t crc = preset;
+	for (uint16_t index = 0; index < length; index++) {
+		byte value = data[index] ^ (byte)crc;
+		value ^= value << 4;
+		crc = (crc >> 8) ^ ((uint16_t)value << 8) ^ ((uint16_t)value << 3) ^ (value >> 4);
+	}
+	return crc;
+} // End crcA()
+
+/**
+ * Takes the next response from the queue.
+ *
+ * @return false if the queue is empty.
+ */
+bool MFRC522MockBus::nextResponse(Response *response) {
+	if (_queueCount == 0) {
+		return false;
+	}
+	*response = _queue[_queueHead];
+	_queueHead = (_queueHead + 1) % QUEUE_SIZE;
+	_queueCount--;
+	return true;
+} // End nextResponse()
+
+/**
+ * Puts a received frame into the FIFO and sets the status registers like the receiver does.
+ */
+void MFRC522MockBus::receive(const Response *response) {
+	for (byte index = 0; index < response->length; index++) {
+		fifoPush(response->data[index]);
+	}
+	registers[addressOf(MFRC522::ControlReg)] = (registers[addressOf(MFRC522::ControlReg)] & ~0x07) | (response->validBits & 0x07);
+	registers[addressOf(MFRC522::ErrorReg)] = response->error;
+	registers[addressOf(MFRC522::ComIrqReg)] |= 0x20;		// RxIRq
+	if (response->error) {
+		registers[addressOf(MFRC522::ComIrqReg)] |= 0x02;	// ErrIRq
+	}
+} // End receive()
+
+void MFRC522MockBus::fifoPush(byte value) {
+	if (_fifoLength < MFRC522::FIFO_SIZE) {
+		_fifo[_fifoLength++] = value;
+	} else {
+		registers[addressOf(MFRC522::ErrorReg)] |= 0x10;		// BufferOvfl
+	}
+} // End fifoPush()
+
+byte MFRC522MockBus::fifoPop() {
+	if (_fifoLength == 0) {
+		return 0;
+	}
+	byte value = _fifo[0];
+	_fifoLength--;
+	memmove(_fifo, _fifo + 1, _fifoLength);
+	return value;
+} // End fifoPop()
@@ -0,0 +1,98 @@
+/**
+ * In-memory MFRC522 transport for host builds.
+ *
+ * MFRC522MockBus decodes the SPI address bytes like the chip does and keeps a register file and a 64 byte FIFO.
+ * It executes enough of the command set for the protocol code in MFRC522.cpp to run without hardware:
+ * 		CalcCRC		CRC_A over the FIFO, result in CRCResultRegH/L and the CRCIRq bit.
+ * 		Transceive	On StartSend the FIFO is recorded in sent[] and the next queued response is loaded into the FIFO.
+ * 					An empty queue is reported as a PICC timeout (TimerIRq).
+ * 		MFAuthent	Succeeds (MFCrypto1On is set) unless a timeout is queued.
+ * 		SoftReset	Restores the reset values of the register file.
+ *
+ * Every beginTransaction(), chip select assertion and byte is counted, so the bus cost of a call can be measured:
+ * 		MFRC522MockBus bus;
+ * 		MFRC522 mfrc522(bus);
+ * 		mfrc522.PCD_Init();
+ * 		bus.queueResponse(atqa, 2);
+ * 		...
+ * 		bus.resetStats();
+ * 		mfrc522.PICC_ReadCardSerial();
+ * 		Serial.println(bus.stats.bytes);
+ *
+ * Only the host build in extras/host compiles this file, with stubs for Arduino.h and SPI.h. busstats.cpp prints the
+ * bus cost of the common calls this way.
+ */
+#ifndef MFRC522MockBus_h
+#define MFRC522MockBus_h
+
+#include "MFRC522.h"
+
+class MFRC522MockBus : public MFRC522Bus {
+public:
+	static constexpr byte REGISTER_COUNT = 64;
+	static constexpr byte QUEUE_SIZE = 8;		// Number of responses that can be queued
+
+	// Bus traffic since the last resetStats()
+	typedef struct {
+		uint32_t transactions;		// beginTransaction() calls
+		uint32_t frames;			// Chip select assertions, ie register accesses
+		uint32_t bytes;				// Bytes transferred, including address bytes
+	} Stats;
+
+	// Answer of the PICC to the next Transceive or MFAuthent command
+	typedef struct {
+		byte data[MFRC522::FIFO_SIZE];
+		byte length;				// Number of bytes in data
+		byte validBits;				// Number of valid bits in the last byte, 0 for 8 valid bits
+		byte error;					// ErrorReg value after reception
+		bool timeout;				// The PICC does not answer
+	} Response;
+
+	// Member variables
+	Stats stats;
+	byte registers[REGISTER_COUNT];	// Indexed by register address, ie PCD_Register >> 1
+	byte sent[MFRC522::FIFO_SIZE];	// Last frame transmitted by a Transceive or MFAuthent command
+	byte sentLength;
+	byte sentLastBits;				// TxLastBits of the last frame, 0 for 8 bits
+
+	MFRC522MockBus();
+
+	virtual void reset();
+	virtual void resetStats();
+	bool queueResponse(const byte *data, byte length, byte validBits = 0, byte error = 0);
+	bool queueTimeout();
+	void clearResponses();
+	byte pendingResponses() const { return _queueCount; };
+	static uint16_t crcA(const byte *data, uint16_t length, uint16_t preset = 0x6363);
+
+	void beginTransaction() override;
+	void endTransaction() override;
+	void select() override;
+	void deselect() override;
+	byte transfer(byte data) override;
+
+protected:
+	byte _fifo[MFRC522::FIFO_SIZE];
+	byte _fifoLength;
+	Response _queue[QUEUE_SIZE];
+	byte _queueHead;
+	byte _queueCount;
+	byte _address;					// Register address of the current frame
+	bool _reading;					// The current frame is a read
+	bool _addressed;				// The address byte of the current frame has been received
+
+	virtual byte readRegister(byte address);
+	virtual void writeRegister(byte address, byte value);
+	virtual void execute(byte command);
+	virtual void transceive();
+	virtual void authenticate();
+	void calculateCRC();
+	bool nextResponse(Response *response);
+	void receive(const Response *response);
+	void fifoFlush() { _fifoLength = 0; };
+	void fifoPush(byte value);
+	byte fifoPop();
+	static byte addressOf(MFRC522::PCD_Register reg) { return reg >> 1; };
+};
+
+#endif
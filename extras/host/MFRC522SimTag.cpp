@@ -0,0 +1,1082 @@
+/*
+ * Virtual PICCs for the MFRC522Simulator.
+ */
+#include "MFRC522SimTag.h"
+
+/////////////////////////////////////////////////////////////////////////////////////
+// ISO/IEC 14443-3 type A
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor.
+ * The tag starts in the field, in state IDLE.
+ */
+MFRC522SimTag::MFRC522SimTag(	const byte *uid,	///< The UID, uidSize bytes
+								byte uidSize,		///< 4, 7 or 10
+								uint16_t atqa,		///< ATQA as returned by PICC_RequestA(), byte 0 in the low bits. The UID size bits are set from uidSize.
+								byte sak			///< SAK sent when the UID is complete
+							) {
+	_uidSize = (uidSize == 7 || uidSize == 10) ? uidSize : 4;
+	memset(_uid, 0, sizeof(_uid));
+	memcpy(_uid, uid, _uidSize);
+	_atqa[0] = (atqa & 0x3F) | (_uidSize == 7 ? 0x40 : (_uidSize == 10 ? 0x80 : 0x00));	// b8b7: UID size bit frame
+	_atqa[1] = atqa >> 8;
+	_sak = sak;
+	_present = true;
+	MFRC522SimTag::powerOff();
+} // End constructor
+
+/**
+ * Resets the tag like losing the RF field does.
+ */
+void MFRC522SimTag::powerOff() {
+	_state = STATE_IDLE;
+	_halted = false;
+	_level = 1;
+	_crypto1 = false;
+	_rxRate = 0;
+	_txRate = 0;
+} // End powerOff()
+
+/**
+ * Moves the tag into or out of the field. A tag leaving the field loses its state.
+ */
+void MFRC522SimTag::setPresent(bool present) {
+	if (!present) {
+		powerOff();
+	}
+	_present = present;
+} // End setPresent()
+
+/**
+ * Handles a frame sent by the PCD.
+ *
+ * @return true if the tag answers, the answer is in *reply.
+ */
+bool MFRC522SimTag::receive(	const byte *data,	///< The frame as sent on the air, including CRC_A
+								uint16_t bits,		///< Number of bits in the frame
+								bool crypto1,		///< MFCrypto1On was set while sending
+								byte bitRate,		///< Bit rate PCD to PICC, 0 = 106 kbit/s ... 3 = 848 kbit/s
+								Frame *reply		///< Out: the answer
+							) {
+	if (!_present || bits == 0) {
+		return false;
+	}
+	reply->bits = 0;
+	reply->align = 0;
+	reply->bitRate = _txRate;
+	reply->delay = FDT_US;
+
+	// A frame the tag cannot demodulate or decrypt is a transmission error. In ISO/IEC 14443-4 it is ignored, so
+	// other PICCs can be addressed while this one stays active.
+	if (bitRate != _rxRate || crypto1 != _crypto1) {
+		if (_state != STATE_IDLE && _state != STATE_HALT && _state != STATE_PROTOCOL) {
+			fallback();
+		}
+		return false;
+	}
+
+	// Short frames
+	if (bits == 7) {
+		byte command = data[0] & 0x7F;
+		if ((command == MFRC522::PICC_CMD_REQA && _state == STATE_IDLE)
+				|| (command == MFRC522::PICC_CMD_WUPA && (_state == STATE_IDLE || _state == STATE_HALT))) {
+			_halted = _state == STATE_HALT;
+			_state = STATE_READY;
+			_level = 1;
+			answer(reply, _atqa, 2, false);
+			return true;
+		}
+		if (_state != STATE_IDLE && _state != STATE_HALT && _state != STATE_PROTOCOL) {
+			fallback();
+		}
+		return false;
+	}
+
+	switch (_state) {
+		case STATE_READY:
+			return anticollision(data, bits, reply);
+		case STATE_ACTIVE:
+			if (bits == 32 && data[0] == MFRC522::PICC_CMD_HLTA && data[1] == 0x00 && checkCRC(data, 4)) {
+				_state = STATE_HALT;
+				_crypto1 = false;
+				return false;		// HLTA is not answered
+			}
+			// fall through
+		case STATE_PROTOCOL:
+			if (bits % 8) {
+				if (_state == STATE_ACTIVE) {
+					fallback();
+				}
+				return false;
+			}
+			if (!command(data, bits / 8, reply)) {
+				return false;
+			}
+			if (reply->bits == 4 && reply->data[0] != MFRC522::MF_ACK) {
+				fallback();		// After a NAK the PICC returns to IDLE or HALT
+			}
+			return true;
+		default:
+			return false;
+	}
+} // End receive()
+
+/**
+ * Handles ANTICOLLISION and SELECT in state READY.
+ */
+bool MFRC522SimTag::anticollision(const byte *data, uint16_t bits, Frame *reply) {
+	byte levels = _uidSize == 4 ? 1 : (_uidSize == 7 ? 2 : 3);
+	byte cl[5];
+	if (bits < 16 || data[0] != MFRC522::PICC_CMD_SEL_CL1 + 2 * (_level - 1)) {
+		fallback();
+		return false;
+	}
+	cascadeLevel(_level, cl);
+
+	byte nvb = data[1];
+	if (nvb == 0x70) {		// SELECT
+		if (bits != 72 || !checkCRC(data, 9)) {
+			fallback();
+			return false;
+		}
+		if (memcmp(&data[2], cl, 5) != 0) {
+			fallback();		// Another PICC is selected
+			return false;
+		}
+		byte sak = 0x04;	// Cascade bit, UID not complete
+		if (_level < levels) {
+			_level++;
+		} else {
+			sak = _sak;
+			_state = STATE_ACTIVE;
+			selected();
+		}
+		answer(reply, &sak, 1);
+		return true;
+	}
+
+	// ANTICOLLISION: answer the UID bits following the ones sent by the PCD
+	uint16_t known = ((nvb >> 4) - 2) * 8 + (nvb & 0x07);
+	if ((nvb >> 4) < 2 || known >= 40 || bits != 16 + known) {
+		fallback();
+		return false;
+	}
+	for (uint16_t bit = 0; bit < known; bit++) {
+		if (((data[2 + bit / 8] ^ cl[bit / 8]) >> (bit % 8)) & 0x01) {
+			return false;	// Not our UID
+		}
+	}
+	answer(reply, &cl[known / 8], 5 - known / 8, false);
+	reply->align = known % 8;
+	reply->bits = 40 - known;
+	return true;
+} // End anticollision()
+
+/**
+ * Fills buffer with the 4 UID bytes (or CT and 3 bytes) and BCC of the given cascade level.
+ */
+void MFRC522SimTag::cascadeLevel(byte level, byte *buffer) {
+	byte levels = _uidSize == 4 ? 1 : (_uidSize == 7 ? 2 : 3);
+	byte index = 3 * (level - 1);
+	if (level < levels) {
+		buffer[0] = MFRC522::PICC_CMD_CT;
+		memcpy(&buffer[1], &_uid[index], 3);
+	} else {
+		memcpy(buffer, &_uid[index], 4);
+	}
+	buffer[4] = buffer[0] ^ buffer[1] ^ buffer[2] ^ buffer[3];
+} // End cascadeLevel()
+
+/**
+ * Returns to IDLE, or to HALT for the * states, after an unexpected frame.
+ */
+void MFRC522SimTag::fallback() {
+	_state = _halted ? STATE_HALT : STATE_IDLE;
+	_level = 1;
+	_crypto1 = false;
+	_rxRate = 0;
+	_txRate = 0;
+} // End fallback()
+
+/**
+ * MIFARE Classic authentication, run by the MFAuthent command of the MFRC522.
+ *
+ * @return true if the PICC accepts the key.
+ */
+bool MFRC522SimTag::authenticate(byte /*command*/, byte /*blockAddr*/, const byte * /*key*/, const byte * /*uid*/) {
+	fallback();		// Not a MIFARE Classic
+	return false;
+} // End authenticate()
+
+/**
+ * @return true if the last two bytes of data are the CRC_A of the bytes before.
+ */
+bool MFRC522SimTag::checkCRC(const byte *data, uint16_t length) {
+	if (length < 2) {
+		return false;
+	}
+	uint16_t crc = MFRC522MockBus::crcA(data, length - 2);
+	return data[length - 2] == (crc & 0xFF) && data[length - 1] == (crc >> 8);
+} // End checkCRC()
+
+/**
+ * Sets *reply to a frame of whole bytes.
+ */
+void MFRC522SimTag::answer(Frame *reply, const byte *data, uint16_t length, bool crc, uint32_t delay) {
+	if (data != reply->data) {
+		memmove(reply->data, data, length);
+	}
+	if (crc) {
+		uint16_t value = MFRC522MockBus::crcA(reply->data, length);
+		reply->data[length++] = value & 0xFF;
+		reply->data[length++] = value >> 8;
+	}
+	reply->bits = 8 * length;
+	reply->align = 0;
+	reply->delay = delay;
+} // End answer()
+
+/**
+ * Sets *reply to a 4 bit ACK or NAK.
+ */
+void MFRC522SimTag::answerNibble(Frame *reply, byte value, uint32_t delay) {
+	reply->data[0] = value & 0x0F;
+	reply->bits = 4;
+	reply->align = 0;
+	reply->delay = delay;
+} // End answerNibble()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MIFARE Classic
+/////////////////////////////////////////////////////////////////////////////////////
+
+// Access conditions of data blocks and sector trailers, indexed by C1C2C3. MIFARE Classic datasheet section 8.7.
+static const byte classicDataRead[]			= {0x03, 0x03, 0x03, 0x02, 0x03, 0x02, 0x03, 0x00};
+static const byte classicDataWrite[]		= {0x03, 0x00, 0x00, 0x02, 0x02, 0x00, 0x02, 0x00};
+static const byte classicDataIncrement[]	= {0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00};
+static const byte classicDataDecrement[]	= {0x03, 0x03, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00};	// Also TRANSFER and RESTORE
+static const byte classicKeyAWrite[]		= {0x01, 0x01, 0x00, 0x02, 0x02, 0x00, 0x00, 0x00};
+static const byte classicAccessRead[]		= {0x01, 0x01, 0x01, 0x03, 0x03, 0x03, 0x03, 0x03};
+static const byte classicAccessWrite[]		= {0x00, 0x01, 0x00, 0x02, 0x00, 0x02, 0x00, 0x00};
+static const byte classicKeyBRead[]			= {0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00};
+static const byte classicKeyBWrite[]		= {0x01, 0x01, 0x00, 0x02, 0x02, 0x00, 0x00, 0x00};
+
+/**
+ * Constructor.
+ * All keys are FFFFFFFFFFFF with the transport access conditions, all data blocks are 0.
+ */
+MFRC522SimClassic::MFRC522SimClassic(	const byte *uid,	///< The UID, uidSize bytes
+										byte uidSize,		///< 4 or 7
+										Type type			///< CLASSIC_1K or CLASSIC_4K
+									) : MFRC522SimTag(uid, uidSize, type == CLASSIC_4K ? 0x0002 : 0x0004, type == CLASSIC_4K ? 0x18 : 0x08) {
+	_type = type;
+	memset(_memory, 0, sizeof(_memory));
+
+	// Manufacturer block
+	byte *manufacturer = block(0);
+	memcpy(manufacturer, _uid, _uidSize);
+	byte index = _uidSize;
+	if (_uidSize == 4) {
+		manufacturer[index++] = _uid[0] ^ _uid[1] ^ _uid[2] ^ _uid[3];	// BCC
+	}
+	manufacturer[index++] = _sak;
+	manufacturer[index++] = _atqa[0];
+	manufacturer[index++] = _atqa[1];
+	while (index < 16) {
+		manufacturer[index] = 0x60 + index;
+		index++;
+	}
+
+	byte sectors = _type == CLASSIC_4K ? 40 : 16;
+	for (byte sector = 0; sector < sectors; sector++) {
+		byte *trailer = block(trailerOf(sector));
+		memset(trailer, 0xFF, 16);
+		setAccessBits(sector, 0, 0, 0, 1);
+	}
+	MFRC522SimClassic::powerOff();
+} // End constructor
+
+void MFRC522SimClassic::powerOff() {
+	MFRC522SimTag::powerOff();
+	_pending = 0;
+	_transferValid = false;
+} // End powerOff()
+
+/**
+ * Writes the access bytes 6..8 of a sector trailer.
+ * Each group is C1C2C3 as a 3 bit number, eg 0b001 for the transport configuration of the sector trailer.
+ */
+void MFRC522SimClassic::setAccessBits(	byte sector,	///< The sector
+										byte g0,		///< Access bits for block 0 (blocks 0-4 in the 16 block sectors of a 4K)
+										byte g1,		///< Access bits for block 1 (blocks 5-9)
+										byte g2,		///< Access bits for block 2 (blocks 10-14)
+										byte g3			///< Access bits for the sector trailer
+									) {
+	byte groups[] = {g0, g1, g2, g3};
+	byte c1 = 0, c2 = 0, c3 = 0;
+	for (byte group = 0; group < 4; group++) {
+		c1 |= ((groups[group] >> 2) & 0x01) << group;
+		c2 |= ((groups[group] >> 1) & 0x01) << group;
+		c3 |= (groups[group] & 0x01) << group;
+	}
+	byte *trailer = block(trailerOf(sector));
+	trailer[6] = ((~c2 & 0x0F) << 4) | (~c1 & 0x0F);
+	trailer[7] = (c1 << 4) | (~c3 & 0x0F);
+	trailer[8] = (c3 << 4) | c2;
+} // End setAccessBits()
+
+/**
+ * Returns C1C2C3 of a block as a 3 bit number, or 0xFF if the access bytes of its sector are inconsistent.
+ */
+byte MFRC522SimClassic::accessBits(byte blockAddr) {
+	byte sector = sectorOf(blockAddr);
+	const byte *trailer = block(trailerOf(sector));
+	byte c1 = trailer[7] >> 4;
+	byte c2 = trailer[8] & 0x0F;
+	byte c3 = trailer[8] >> 4;
+	if ((trailer[6] & 0x0F) != (~c1 & 0x0F) || (trailer[6] >> 4) != (~c2 & 0x0F) || (trailer[7] & 0x0F) != (~c3 & 0x0F)) {
+		return 0xFF;	// The sector is blocked
+	}
+	byte group = sector < 32 ? blockAddr % 4 : ((blockAddr - 128) % 16) / 5;
+	return (((c1 >> group) & 0x01) << 2) | (((c2 >> group) & 0x01) << 1) | ((c3 >> group) & 0x01);
+} // End accessBits()
+
+/**
+ * Key B cannot be used for authentication if the access conditions make it readable.
+ */
+bool MFRC522SimClassic::keyBReadable(byte sector) {
+	byte access = accessBits(trailerOf(sector));
+	return access != 0xFF && classicKeyBRead[access] != PERM_NEVER;
+} // End keyBReadable()
+
+bool MFRC522SimClassic::authenticate(byte command, byte blockAddr, const byte *key, const byte *uid) {
+	if (_state != STATE_ACTIVE || blockAddr >= blockCount()
+			|| (command != MFRC522::PICC_CMD_MF_AUTH_KEY_A && command != MFRC522::PICC_CMD_MF_AUTH_KEY_B)
+			|| memcmp(uid, &_uid[_uidSize - 4], 4) != 0) {
+		fallback();
+		return false;
+	}
+	byte sector = sectorOf(blockAddr);
+	const byte *trailer = block(trailerOf(sector));
+	bool keyB = command == MFRC522::PICC_CMD_MF_AUTH_KEY_B;
+	if ((keyB && keyBReadable(sector)) || memcmp(key, keyB ? &trailer[10] : trailer, 6) != 0) {
+		fallback();		// The reader's answer cannot be decrypted, the PICC stops responding
+		return false;
+	}
+	_crypto1 = true;
+	_authSector = sector;
+	_authKeyB = keyB;
+	_pending = 0;
+	return true;
+} // End authenticate()
+
+/**
+ * Checks the redundant value block format, MIFARE Classic datasheet section 8.6.2.1.
+ */
+bool MFRC522SimClassic::isValueBlock(const byte *data) {
+	for (byte index = 0; index < 4; index++) {
+		if (data[index] != data[index + 8] || data[index] != (byte)~data[index + 4]) {
+			return false;
+		}
+	}
+	return data[12] == data[14] && data[13] == data[15] && data[12] == (byte)~data[13];
+} // End isValueBlock()
+
+/**
+ * Writes the parts of a sector trailer the authenticated key may change.
+ *
+ * @return false if no part may be changed.
+ */
+bool MFRC522SimClassic::writeTrailer(byte blockAddr, const byte *data, bool test) {
+	byte access = accessBits(blockAddr);
+	if (access == 0xFF) {
+		return false;
+	}
+	bool keyA = allowed(classicKeyAWrite[access]);
+	bool bits = allowed(classicAccessWrite[access]);
+	bool keyB = allowed(classicKeyBWrite[access]);
+	if (test || !(keyA || bits || keyB)) {
+		return keyA || bits || keyB;
+	}
+	byte *trailer = block(blockAddr);
+	if (keyA) {
+		memcpy(trailer, data, 6);
+	}
+	if (bits) {
+		memcpy(&trailer[6], &data[6], 4);
+	}
+	if (keyB) {
+		memcpy(&trailer[10], &data[10], 6);
+	}
+	return true;
+} // End writeTrailer()
+
+bool MFRC522SimClassic::command(const byte *data, uint16_t length, Frame *reply) {
+	if (!checkCRC(data, length)) {
+		answerNibble(reply, 0x05);		// NAK, parity or CRC error
+		return true;
+	}
+	length -= 2;
+
+	// Second step of WRITE and the value operations
+	if (_pending) {
+		byte command = _pending;
+		byte blockAddr = _pendingBlock;
+		_pending = 0;
+		if (command == MFRC522::PICC_CMD_MF_WRITE) {
+			if (length != 16) {
+				answerNibble(reply, 0x04);
+				return true;
+			}
+			if (blockAddr == trailerOf(sectorOf(blockAddr))) {
+				writeTrailer(blockAddr, data, false);
+			} else {
+				memcpy(block(blockAddr), data, 16);
+			}
+			answerNibble(reply, MFRC522::MF_ACK, WRITE_US);
+			return true;
+		}
+		if (length != 4) {
+			fallback();
+			return false;
+		}
+		const byte *source = block(blockAddr);
+		int32_t value = (int32_t)((uint32_t)source[0] | ((uint32_t)source[1] << 8) | ((uint32_t)source[2] << 16) | ((uint32_t)source[3] << 24));
+		int32_t operand = (int32_t)((uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24));
+		if (command == MFRC522::PICC_CMD_MF_INCREMENT) {
+			value += operand;
+		} else if (command == MFRC522::PICC_CMD_MF_DECREMENT) {
+			value -= operand;
+		}
+		for (byte index = 0; index < 4; index++) {
+			byte octet = ((uint32_t)value >> (8 * index)) & 0xFF;
+			_transfer[index] = octet;
+			_transfer[index + 4] = ~octet;
+			_transfer[index + 8] = octet;
+		}
+		memcpy(&_transfer[12], &source[12], 4);
+		_transferValid = true;
+		return false;	// The operand is not answered
+	}
+
+	if (!_crypto1 || length != 2) {
+		answerNibble(reply, 0x04);		// NAK, not allowed
+		return true;
+	}
+	byte command = data[0];
+	byte blockAddr = data[1];
+	if (blockAddr >= blockCount() || sectorOf(blockAddr) != _authSector) {
+		answerNibble(reply, 0x04);
+		return true;
+	}
+	byte access = accessBits(blockAddr);
+	bool trailer = blockAddr == trailerOf(_authSector);
+	if (access == 0xFF) {
+		answerNibble(reply, 0x04);
+		return true;
+	}
+
+	switch (command) {
+		case MFRC522::PICC_CMD_MF_READ:
+			if (trailer) {
+				memset(reply->data, 0, 16);		// Key A is never readable
+				if (allowed(classicAccessRead[access])) {
+					memcpy(&reply->data[6], &block(blockAddr)[6], 4);
+				}
+				if (allowed(classicKeyBRead[access])) {
+					memcpy(&reply->data[10], &block(blockAddr)[10], 6);
+				}
+				answer(reply, reply->data, 16);
+				return true;
+			}
+			if (!allowed(classicDataRead[access])) {
+				break;
+			}
+			answer(reply, block(blockAddr), 16);
+			return true;
+		case MFRC522::PICC_CMD_MF_WRITE:
+			if (blockAddr == 0 || (trailer ? !writeTrailer(blockAddr, nullptr, true) : !allowed(classicDataWrite[access]))) {
+				break;
+			}
+			_pending = command;
+			_pendingBlock = blockAddr;
+			answerNibble(reply, MFRC522::MF_ACK);
+			return true;
+		case MFRC522::PICC_CMD_MF_INCREMENT:
+		case MFRC522::PICC_CMD_MF_DECREMENT:
+		case MFRC522::PICC_CMD_MF_RESTORE:
+			if (trailer || !isValueBlock(block(blockAddr))
+					|| !allowed(command == MFRC522::PICC_CMD_MF_INCREMENT ? classicDataIncrement[access] : classicDataDecrement[access])) {
+				break;
+			}
+			_pending = command;
+			_pendingBlock = blockAddr;
+			answerNibble(reply, MFRC522::MF_ACK);
+			return true;
+		case MFRC522::PICC_CMD_MF_TRANSFER:
+			if (trailer || !_transferValid || !allowed(classicDataDecrement[access])) {
+				break;
+			}
+			memcpy(block(blockAddr), _transfer, 16);
+			answerNibble(reply, MFRC522::MF_ACK, WRITE_US);
+			return true;
+		default:
+			fallback();
+			return false;
+	}
+	answerNibble(reply, 0x04);
+	return true;
+} // End command()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MIFARE Ultralight and NTAG21x
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor.
+ * The user memory is 0, no password protection.
+ */
+MFRC522SimUltralight::MFRC522SimUltralight(	const byte *uid,	///< 7 byte UID
+											Type type			///< ULTRALIGHT, NTAG213, NTAG215 or NTAG216
+										) : MFRC522SimTag(uid, 7, 0x0044, 0x00) {
+	static const byte pageCounts[] = {16, 45, 135, 231};
+	static const byte dataAreaSizes[] = {0x00, 0x12, 0x3E, 0x6D};	// Capability container byte 2
+	_type = type;
+	_pageCount = pageCounts[type];
+	memset(_memory, 0, sizeof(_memory));
+
+	byte *memory = page(0);
+	memcpy(memory, _uid, 3);
+	memory[3] = MFRC522::PICC_CMD_CT ^ _uid[0] ^ _uid[1] ^ _uid[2];		// BCC0
+	memcpy(&memory[4], &_uid[3], 4);
+	memory[8] = _uid[3] ^ _uid[4] ^ _uid[5] ^ _uid[6];					// BCC1
+	memory[9] = 0x48;													// Internal
+	if (_type != ULTRALIGHT) {
+		memory[12] = 0xE1;												// Capability container, NDEF
+		memory[13] = 0x10;
+		memory[14] = dataAreaSizes[type];
+		byte *config = page(configPage());
+		config[3] = 0xFF;												// CFG0: AUTH0 = 0xFF, no password protection
+		config[5] = 0x05;												// CFG1
+		memset(page(configPage() + 2), 0xFF, 4);						// PWD
+	}
+	_counter = 0;
+	_pending = 0;
+	_authenticated = false;
+	_counted = false;
+} // End constructor
+
+void MFRC522SimUltralight::selected() {
+	_pending = 0;
+	_authenticated = false;
+	_counted = false;
+} // End selected()
+
+/**
+ * @return true if the page needs PWD_AUTH first.
+ */
+bool MFRC522SimUltralight::protectedPage(byte pageAddr, bool write) {
+	if (_type == ULTRALIGHT || _authenticated) {
+		return false;
+	}
+	byte auth0 = page(configPage())[3];
+	bool prot = page(configPage() + 1)[0] & 0x80;		// ACCESS.PROT: reads are protected too
+	return pageAddr >= auth0 && (write || prot);
+} // End protectedPage()
+
+/**
+ * Writes a page. Lock bytes and the capability container are one time programmable.
+ *
+ * @return MF_ACK or a NAK value.
+ */
+byte MFRC522SimUltralight::writePage(byte pageAddr, const byte *data) {
+	if (pageAddr < 2 || pageAddr >= _pageCount || protectedPage(pageAddr, true)) {
+		return 0x00;	// NAK, invalid argument
+	}
+	byte *memory = page(pageAddr);
+	if (pageAddr == 2) {
+		memory[2] |= data[2];
+		memory[3] |= data[3];
+	} else if (pageAddr == 3) {
+		for (byte index = 0; index < 4; index++) {
+			memory[index] |= data[index];
+		}
+	} else {
+		memcpy(memory, data, 4);
+	}
+	return MFRC522::MF_ACK;
+} // End writePage()
+
+/**
+ * Copies pages to buffer. PWD and PACK read as 0.
+ */
+void MFRC522SimUltralight::readPages(byte first, byte count, byte *buffer, bool rollOver) {
+	for (byte index = 0; index < count; index++) {
+		byte pageAddr = rollOver ? (first + index) % _pageCount : first + index;
+		if (_type != ULTRALIGHT && pageAddr >= configPage() + 2) {
+			memset(&buffer[4 * index], 0, 4);
+		} else {
+			memcpy(&buffer[4 * index], page(pageAddr), 4);
+		}
+	}
+	// The NFC counter counts the first read after each activation if NFC_CNT_EN is set
+	if (_type != ULTRALIGHT && !_counted && (page(configPage() + 1)[0] & 0x10)) {
+		_counter = (_counter + 1) & 0xFFFFFF;
+		_counted = true;
+	}
+} // End readPages()
+
+bool MFRC522SimUltralight::command(const byte *data, uint16_t length, Frame *reply) {
+	if (!checkCRC(data, length)) {
+		answerNibble(reply, 0x01);		// NAK, CRC error
+		return true;
+	}
+	length -= 2;
+	bool ntag = _type != ULTRALIGHT;
+
+	// Second step of COMPATIBILITY WRITE
+	if (_pending) {
+		byte pageAddr = _pending;
+		_pending = 0;
+		byte result = length == 16 ? writePage(pageAddr, data) : 0x00;
+		answerNibble(reply, result, result == MFRC522::MF_ACK ? WRITE_US : FDT_US);
+		return true;
+	}
+
+	switch (data[0]) {
+		case MFRC522::PICC_CMD_MF_READ:
+			if (length != 2 || data[1] >= _pageCount || protectedPage(data[1], false)) {
+				break;
+			}
+			readPages(data[1], 4, reply->data, true);
+			answer(reply, reply->data, 16);
+			return true;
+		case MFRC522::PICC_CMD_UL_WRITE:
+			if (length != 6) {
+				break;
+			}
+			{
+				byte result = writePage(data[1], &data[2]);
+				answerNibble(reply, result, result == MFRC522::MF_ACK ? WRITE_US : FDT_US);
+			}
+			return true;
+		case MFRC522::PICC_CMD_MF_WRITE:		// COMPATIBILITY WRITE
+			if (length != 2 || data[1] < 2 || data[1] >= _pageCount || protectedPage(data[1], true)) {
+				break;
+			}
+			_pending = data[1];
+			answerNibble(reply, MFRC522::MF_ACK);
+			return true;
+		case 0x60:								// GET_VERSION
+			if (!ntag) {
+				fallback();
+				return false;
+			}
+			if (length != 1) {
+				break;
+			}
+			{
+				static const byte storageSizes[] = {0x00, 0x0F, 0x11, 0x13};
+				const byte version[] = {0x00, 0x04, 0x04, 0x02, 0x01, 0x00, storageSizes[_type], 0x03};
+				answer(reply, version, sizeof(version));
+			}
+			return true;
+		case 0x3A:								// FAST_READ
+			if (!ntag) {
+				fallback();
+				return false;
+			}
+			if (length != 3 || data[1] > data[2] || data[2] >= _pageCount) {
+				break;
+			}
+			for (uint16_t pageAddr = data[1]; pageAddr <= data[2]; pageAddr++) {
+				if (protectedPage(pageAddr, false)) {
+					answerNibble(reply, 0x00);
+					return true;
+				}
+			}
+			readPages(data[1], data[2] - data[1] + 1, reply->data, false);
+			answer(reply, reply->data, 4 * (data[2] - data[1] + 1));
+			return true;
+		case 0x39:								// READ_CNT
+			if (!ntag) {
+				fallback();
+				return false;
+			}
+			if (length != 2 || data[1] != 0x02) {
+				break;
+			}
+			reply->data[0] = _counter & 0xFF;
+			reply->data[1] = (_counter >> 8) & 0xFF;
+			reply->data[2] = (_counter >> 16) & 0xFF;
+			answer(reply, reply->data, 3);
+			return true;
+		case 0x3C:								// READ_SIG
+			if (!ntag) {
+				fallback();
+				return false;
+			}
+			if (length != 2 || data[1] != 0x00) {
+				break;
+			}
+			for (byte index = 0; index < 32; index++) {
+				reply->data[index] = _uid[index % 7] ^ (byte)(index * 0x1D);	// Not a real ECC signature
+			}
+			answer(reply, reply->data, 32);
+			return true;
+		case 0x1B:								// PWD_AUTH
+			if (!ntag) {
+				fallback();
+				return false;
+			}
+			if (length != 5 || memcmp(&data[1], page(configPage() + 2), 4) != 0) {
+				answerNibble(reply, 0x04);
+				return true;
+			}
+			_authenticated = true;
+			answer(reply, page(configPage() + 3), 2);
+			return true;
+		default:
+			fallback();
+			return false;
+	}
+	answerNibble(reply, 0x00);		// NAK, invalid argument
+	return true;
+} // End command()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// ISO/IEC 14443-4
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor.
+ * FSC 256 bytes, FWT 4.8ms, 106 kbit/s only, CID supported, empty file.
+ */
+MFRC522SimIsoDep::MFRC522SimIsoDep(	const byte *uid,	///< The UID, uidSize bytes
+									byte uidSize		///< 4, 7 or 10
+								) : MFRC522SimTag(uid, uidSize, 0x0304, 0x20) {
+	fsci = 8;
+	fwi = 4;
+	sfgi = 0;
+	bitRates = 0x00;
+	supportsCID = true;
+	apduTime = 1000;
+	_fileLength = 0;
+	selected();
+} // End constructor
+
+/**
+ * Sets the contents of the transparent file read by READ BINARY and GET DATA.
+ */
+void MFRC522SimIsoDep::setFile(const byte *data, uint16_t length) {
+	if (length > FILE_SIZE) {
+		length = FILE_SIZE;
+	}
+	memcpy(_file, data, length);
+	_fileLength = length;
+} // End setFile()
+
+void MFRC522SimIsoDep::selected() {
+	_cid = 0;
+	_fsd = 256;
+	_blockNumber = true;		// The PICC block number is initialized to 1
+	_ppsAllowed = false;
+	_cidPresent = false;
+	_wtxPending = false;
+	_commandLength = 0;
+	_responseLength = 0;
+	_responseOffset = 0;
+	_responseSent = 0;
+	_getResponse = 0;
+} // End selected()
+
+bool MFRC522SimIsoDep::command(const byte *data, uint16_t length, Frame *reply) {
+	if (!checkCRC(data, length)) {
+		return false;		// Transmission errors are not answered in ISO/IEC 14443-4
+	}
+	length -= 2;
+
+	if (_state == STATE_ACTIVE) {
+		if (length != 2 || data[0] != 0xE0 || (data[1] & 0x0F) == 0x0F) {	// RATS
+			fallback();
+			return false;
+		}
+		static const uint16_t fsdTable[] = {16, 24, 32, 40, 48, 64, 96, 128, 256};
+		byte fsdi = data[1] >> 4;
+		_fsd = fsdi > 8 ? 256 : fsdTable[fsdi];
+		_cid = data[1] & 0x0F;
+		_state = STATE_PROTOCOL;
+		_ppsAllowed = true;
+		const byte ats[] = {
+			0x05,							// TL
+			(byte)(0x70 | (fsci & 0x0F)),	// T0: TA(1), TB(1) and TC(1) follow
+			bitRates,						// TA(1)
+			(byte)((fwi << 4) | (sfgi & 0x0F)),	// TB(1)
+			(byte)(supportsCID ? 0x02 : 0x00)	// TC(1)
+		};
+		answer(reply, ats, sizeof(ats), true, 500);
+		return true;
+	}
+
+	// PPS, only directly after RATS
+	if (_ppsAllowed && (data[0] & 0xF0) == 0xD0) {
+		_ppsAllowed = false;
+		if ((data[0] & 0x0F) != _cid || length < 2) {
+			return false;
+		}
+		byte dsi = 0;
+		byte dri = 0;
+		if (data[1] & 0x10) {		// PPS1 present
+			if (length != 3) {
+				return false;
+			}
+			dsi = (data[2] >> 2) & 0x03;
+			dri = data[2] & 0x03;
+			if ((dsi && !(bitRates & (0x10 << (dsi - 1)))) || (dri && !(bitRates & (0x01 << (dri - 1))))) {
+				return false;		// Not supported
+			}
+		}
+		answer(reply, data, 1);		// PPSS, sent at the old bit rate
+		_txRate = dsi;
+		_rxRate = dri;
+		return true;
+	}
+	_ppsAllowed = false;
+	return block(data, length, reply);
+} // End command()
+
+/**
+ * Handles an I-, R- or S-block.
+ */
+bool MFRC522SimIsoDep::block(const byte *data, uint16_t length, Frame *reply) {
+	byte pcb = data[0];
+	uint16_t offset = 1;
+	if (pcb & 0x08) {
+		if (length < 2 || (data[1] & 0x0F) != _cid) {
+			return false;	// Addressed to another card
+		}
+		offset++;
+	} else if (_cid != 0) {
+		return false;		// A PICC with CID != 0 does not answer blocks without CID
+	}
+	_cidPresent = pcb & 0x08;
+	if (pcb & 0x04) {
+		offset++;			// NAD, ignored
+	}
+	if (offset > length) {
+		return false;
+	}
+	bool number = pcb & 0x01;
+
+	if ((pcb & 0xE2) == 0x02) {			// I-block
+		uint16_t size = length - offset;
+		if (_commandLength + size > APDU_SIZE) {
+			_commandLength = 0;
+			return false;
+		}
+		_blockNumber = number;
+		memcpy(&_command[_commandLength], &data[offset], size);
+		_commandLength += size;
+		if (pcb & 0x10) {				// Chaining: acknowledge and wait for more
+			answerBlock(reply, 0xA2 | number, nullptr, 0, FDT_US);
+			return true;
+		}
+		_responseLength = 0;
+		apdu(_command, _commandLength, _response, &_responseLength);
+		_commandLength = 0;
+		_responseOffset = 0;
+		_responseSent = 0;
+		if (apduTime > fwt()) {			// Ask for more time
+			uint32_t wtxm = (apduTime + fwt() - 1) / fwt();
+			byte inf = wtxm > 59 ? 59 : wtxm;
+			_wtxPending = true;
+			answerBlock(reply, 0xF2, &inf, 1, FDT_US);
+			return true;
+		}
+		sendResponse(reply, apduTime);
+		return true;
+	}
+
+	if ((pcb & 0xE6) == 0xA2) {			// R-block
+		bool nak = pcb & 0x10;
+		if (!nak && number != _blockNumber && _responseSent < _responseLength) {
+			_blockNumber = number;		// Next block of a chained response
+			_responseOffset = _responseSent;
+			sendResponse(reply, FDT_US);
+			return true;
+		}
+		if (number == _blockNumber) {	// Retransmit the last block
+			if (_commandLength) {
+				answerBlock(reply, 0xA2 | number, nullptr, 0, FDT_US);
+			} else {
+				sendResponse(reply, FDT_US);
+			}
+			return true;
+		}
+		if (nak) {
+			answerBlock(reply, 0xA2 | _blockNumber, nullptr, 0, FDT_US);
+			return true;
+		}
+		return false;
+	}
+
+	if ((pcb & 0xC7) == 0xC2) {			// S-block
+		if ((pcb & 0x30) == 0x00) {		// DESELECT
+			answerBlock(reply, 0xC2, nullptr, 0, FDT_US);
+			_state = STATE_HALT;
+			_rxRate = 0;
+			_txRate = 0;
+			return true;
+		}
+		if ((pcb & 0x30) == 0x30 && _wtxPending) {		// WTX response
+			_wtxPending = false;
+			sendResponse(reply, apduTime > fwt() ? apduTime - fwt() : FDT_US);
+			return true;
+		}
+	}
+	return false;
+} // End block()
+
+/**
+ * Sends the next part of the response APDU in an I-block.
+ */
+void MFRC522SimIsoDep::sendResponse(Frame *reply, uint32_t delay) {
+	uint16_t maxInf = _fsd - 3 - (_cidPresent ? 1 : 0);		// PCB, CID and CRC_A
+	uint16_t size = _responseLength - _responseOffset;
+	byte pcb = 0x02 | (_blockNumber ? 0x01 : 0x00);
+	if (size > maxInf) {
+		size = maxInf;
+		pcb |= 0x10;		// Chaining
+	}
+	answerBlock(reply, pcb, &_response[_responseOffset], size, delay);
+	_responseSent = _responseOffset + size;
+} // End sendResponse()
+
+void MFRC522SimIsoDep::answerBlock(Frame *reply, byte pcb, const byte *inf, uint16_t infLength, uint32_t delay) {
+	uint16_t length = 0;
+	reply->data[length++] = pcb | (_cidPresent ? 0x08 : 0x00);
+	if (_cidPresent) {
+		reply->data[length++] = _cid;
+	}
+	if (infLength) {
+		memcpy(&reply->data[length], inf, infLength);
+		length += infLength;
+	}
+	answer(reply, reply->data, length, true, delay);
+} // End answerBlock()
+
+/**
+ * Executes a command APDU. Supported are SELECT, READ BINARY (short and extended Le), UPDATE BINARY,
+ * GET DATA with the file answered through 61xx and GET RESPONSE, and GET CHALLENGE.
+ * Override to model other applications.
+ */
+void MFRC522SimIsoDep::apdu(const byte *command, uint16_t length, byte *response, uint16_t *responseLength) {
+	uint16_t size = 0;
+	uint16_t sw = 0x9000;
+	if (length < 4) {
+		sw = 0x6700;
+	} else {
+		// Decode Lc and Le, ISO/IEC 7816-4 5.1
+		uint32_t le = 0;
+		bool hasLe = false;
+		bool extended = false;
+		uint16_t lc = 0;
+		const byte *body = &command[4];
+		if (length == 4) {
+			// Case 1: neither Lc nor Le
+		} else if (length == 5) {
+			hasLe = true;
+			le = command[4] ? command[4] : 256;
+		} else if (length == 7 && command[4] == 0) {
+			hasLe = true;
+			extended = true;
+			le = (command[5] << 8) | command[6];
+			le = le ? le : 65536;
+		} else if (length > 5 && command[4] != 0) {
+			lc = command[4];
+			body = &command[5];
+			if (length == 6 + lc) {
+				hasLe = true;
+				le = command[5 + lc] ? command[5 + lc] : 256;
+			}
+		} else if (length > 7) {
+			extended = true;
+			lc = (command[5] << 8) | command[6];
+			body = &command[7];
+			if (length == 9 + lc) {
+				hasLe = true;
+				le = (command[7 + lc] << 8) | command[8 + lc];
+				le = le ? le : 65536;
+			}
+		}
+		if ((body - command) + lc > length) {
+			lc = 0;
+			sw = 0x6700;
+		}
+		uint16_t offset = ((command[2] & 0x7F) << 8) | command[3];
+		uint16_t remaining = _fileLength > _getResponse ? _fileLength - _getResponse : 0;
+
+		switch (sw == 0x9000 ? command[1] : 0x00) {
+			case 0x00:		// Malformed
+				break;
+			case 0xA4:		// SELECT
+				break;
+			case 0xB0:		// READ BINARY
+				if (!hasLe) {
+					sw = 0x6700;
+				} else if (offset > _fileLength) {
+					sw = 0x6B00;
+				} else if (!extended && le > (uint32_t)(_fileLength - offset) && _fileLength - offset < 256) {
+					sw = 0x6C00 | (_fileLength - offset);	// Wrong Le, retry with the exact length
+				} else {
+					size = le < (uint32_t)(_fileLength - offset) ? le : _fileLength - offset;
+					memcpy(response, &_file[offset], size);
+					sw = size < le ? 0x6282 : 0x9000;		// End of file reached before Le bytes
+				}
+				break;
+			case 0xD6:		// UPDATE BINARY
+				if ((uint32_t)offset + lc > FILE_SIZE) {
+					sw = 0x6A84;
+				} else {
+					memcpy(&_file[offset], body, lc);
+					if (offset + lc > _fileLength) {
+						_fileLength = offset + lc;
+					}
+				}
+				break;
+			case 0xCA:		// GET DATA, the whole file through GET RESPONSE
+				_getResponse = 0;
+				if (!_fileLength) {
+					sw = 0x6A88;
+				} else {
+					sw = 0x6100 | (_fileLength >= 256 ? 0x00 : _fileLength);
+				}
+				break;
+			case 0xC0:		// GET RESPONSE
+				if (!remaining) {
+					sw = 0x6985;
+					break;
+				}
+				le = hasLe ? le : 256;
+				size = le < remaining ? le : remaining;
+				memcpy(response, &_file[_getResponse], size);
+				_getResponse += size;
+				remaining -= size;
+				sw = remaining ? 0x6100 | (remaining >= 256 ? 0x00 : remaining) : 0x9000;
+				break;
+			case 0x84:		// GET CHALLENGE
+				size = hasLe && le <= 256 ? le : 8;
+				for (uint16_t index = 0; index < size; index++) {
+					response[index] = (byte)(index * 73 + 41);
+				}
+				break;
+			default:
+				sw = 0x6D00;
+				break;
+		}
+	}
+	response[size++] = sw >> 8;
+	response[size++] = sw & 0xFF;
+	*responseLength = size;
+} // End apdu()
@@ -0,0 +1,203 @@
+/**
+ * Virtual PICCs for the MFRC522Simulator.
+ *
+ * MFRC522SimTag implements the ISO/IEC 14443-3 type A state machine: REQA/WUPA, anticollision and select on all
+ * cascade levels, HLTA and the HALT, READY* and ACTIVE* states. Derived classes add the commands of a product:
+ * 		MFRC522SimClassic		MIFARE Classic 1K/4K: authentication, sector trailers with access conditions,
+ * 								READ, WRITE, INCREMENT, DECREMENT, RESTORE and TRANSFER.
+ * 		MFRC522SimUltralight	MIFARE Ultralight and NTAG213/215/216: READ, WRITE, COMPATIBILITY WRITE, GET_VERSION,
+ * 								FAST_READ, READ_CNT, READ_SIG and PWD_AUTH.
+ * 		MFRC522SimIsoDep		ISO/IEC 14443-4 card: RATS, PPS, I-, R- and S-blocks with chaining, CID and S(WTX),
+ * 								and a few ISO/IEC 7816-4 APDUs on a transparent file.
+ *
+ * The MFRC522 decrypts the MIFARE Classic traffic itself, so the host only ever sees plain text. A tag therefore
+ * keeps track of whether a Crypto1 session is active instead of running the cipher: frames sent with MFCrypto1On
+ * set in Status2Reg are understood by an authenticated tag only, and vice versa. This is how a real card behaves
+ * when PCD_StopCrypto1() is forgotten or called too early.
+ */
+#ifndef MFRC522SimTag_h
+#define MFRC522SimTag_h
+
+#include "MFRC522MockBus.h"
+
+class MFRC522SimTag {
+public:
+	static constexpr uint16_t MAX_FRAME = 1024;		// Largest frame a tag sends, eg FAST_READ of a whole NTAG216
+	static constexpr uint32_t FDT_US = 86;			// Frame delay time 1172/fc of ISO/IEC 14443-3 6.2.1.1
+
+	// ISO/IEC 14443-3 states, STATE_PROTOCOL is the ISO/IEC 14443-4 state after RATS
+	enum State : byte {
+		STATE_IDLE,
+		STATE_READY,
+		STATE_ACTIVE,
+		STATE_HALT,
+		STATE_PROTOCOL
+	};
+
+	// A frame sent by the tag
+	typedef struct {
+		byte data[MAX_FRAME + 2];
+		uint16_t bits;				// Number of bits sent
+		byte align;					// Bit position of the first bit sent in data[0], used in anticollision
+		byte bitRate;				// Bit rate of the answer, 0 = 106 kbit/s ... 3 = 848 kbit/s
+		uint32_t delay;				// Time in μs from the end of the PCD frame to the start of the answer
+	} Frame;
+
+	MFRC522SimTag(const byte *uid, byte uidSize, uint16_t atqa, byte sak);
+	virtual ~MFRC522SimTag() {};
+
+	bool receive(const byte *data, uint16_t bits, bool crypto1, byte bitRate, Frame *reply);
+	virtual bool authenticate(byte command, byte blockAddr, const byte *key, const byte *uid);
+	virtual void powerOff();
+
+	void setPresent(bool present);
+	bool isPresent() const { return _present; };
+	State state() const { return _state; };
+	const byte *uid() const { return _uid; };
+	byte uidSize() const { return _uidSize; };
+
+protected:
+	byte _uid[10];
+	byte _uidSize;					// 4, 7 or 10 bytes
+	byte _atqa[2];					// As sent, LSB first
+	byte _sak;
+	State _state;
+	bool _halted;					// In READY* or ACTIVE*, ie woken from HALT by WUPA
+	byte _level;					// Cascade level being selected while in READY
+	bool _present;
+	bool _crypto1;					// A MIFARE Classic Crypto1 session is active
+	byte _rxRate;					// Bit rate PCD to PICC
+	byte _txRate;					// Bit rate PICC to PCD
+
+	virtual bool command(const byte *data, uint16_t length, Frame *reply) = 0;
+	virtual void selected() {};
+	bool anticollision(const byte *data, uint16_t bits, Frame *reply);
+	void cascadeLevel(byte level, byte *buffer);
+	void fallback();
+	static bool checkCRC(const byte *data, uint16_t length);
+	static void answer(Frame *reply, const byte *data, uint16_t length, bool crc = true, uint32_t delay = FDT_US);
+	static void answerNibble(Frame *reply, byte value, uint32_t delay = FDT_US);
+};
+
+class MFRC522SimClassic : public MFRC522SimTag {
+public:
+	enum Type : byte {
+		CLASSIC_1K,
+		CLASSIC_4K
+	};
+	static constexpr uint32_t WRITE_US = 2500;		// EEPROM programming time
+
+	MFRC522SimClassic(const byte *uid, byte uidSize = 4, Type type = CLASSIC_1K);
+
+	bool authenticate(byte command, byte blockAddr, const byte *key, const byte *uid) override;
+	void powerOff() override;
+
+	uint16_t blockCount() const { return _type == CLASSIC_4K ? 256 : 64; };
+	byte *block(byte blockAddr) { return &_memory[16 * blockAddr]; };
+	void setAccessBits(byte sector, byte g0, byte g1, byte g2, byte g3);
+
+protected:
+	// Access permissions, each for key A (bit 0) and key B (bit 1)
+	enum Permission : byte {
+		PERM_NEVER				= 0x00,
+		PERM_A					= 0x01,
+		PERM_B					= 0x02,
+		PERM_AB					= 0x03
+	};
+
+	Type _type;
+	byte _memory[4096];
+	byte _authSector;
+	bool _authKeyB;
+	byte _pending;					// First byte of a two step command waiting for its data, 0 if none
+	byte _pendingBlock;
+	byte _transfer[16];				// The internal transfer buffer of value operations
+	bool _transferValid;
+
+	bool command(const byte *data, uint16_t length, Frame *reply) override;
+	byte sectorOf(byte blockAddr) const { return blockAddr < 128 ? blockAddr / 4 : 32 + (blockAddr - 128) / 16; };
+	byte trailerOf(byte sector) const { return sector < 32 ? sector * 4 + 3 : 128 + (sector - 32) * 16 + 15; };
+	byte accessBits(byte blockAddr);
+	bool allowed(byte permission) const { return permission & (_authKeyB ? PERM_B : PERM_A); };
+	bool keyBReadable(byte sector);
+	bool writeTrailer(byte blockAddr, const byte *data, bool test);
+	static bool isValueBlock(const byte *data);
+};
+
+class MFRC522SimUltralight : public MFRC522SimTag {
+public:
+	enum Type : byte {
+		ULTRALIGHT,
+		NTAG213,
+		NTAG215,
+		NTAG216
+	};
+	static constexpr uint32_t WRITE_US = 4100;		// EEPROM programming time
+
+	MFRC522SimUltralight(const byte *uid, Type type = NTAG213);
+
+	byte pageCount() const { return _pageCount; };
+	byte *page(byte pageAddr) { return &_memory[4 * pageAddr]; };
+	uint32_t counter() const { return _counter; };
+
+protected:
+	Type _type;
+	byte _pageCount;
+	byte _memory[231 * 4];
+	byte _pending;					// Page of a COMPATIBILITY WRITE waiting for its data, 0 if none
+	bool _authenticated;			// PWD_AUTH succeeded in this activation
+	bool _counted;					// The NFC counter was incremented in this activation
+	uint32_t _counter;
+
+	bool command(const byte *data, uint16_t length, Frame *reply) override;
+	void selected() override;
+	bool protectedPage(byte pageAddr, bool write);
+	byte writePage(byte pageAddr, const byte *data);
+	void readPages(byte first, byte count, byte *buffer, bool rollOver);
+	byte configPage() const { return _pageCount - 4; };	// CFG0, followed by CFG1, PWD and PACK
+};
+
+class MFRC522SimIsoDep : public MFRC522SimTag {
+public:
+	static constexpr uint16_t FILE_SIZE = 4096;
+	static constexpr uint16_t APDU_SIZE = FILE_SIZE + 8;
+
+	MFRC522SimIsoDep(const byte *uid, byte uidSize = 7);
+
+	// ATS parameters, change them before the tag is activated
+	byte fsci;						// Frame size for proximity card integer, 8 => 256 bytes
+	byte fwi;						// Frame waiting time integer, FWT = 302μs * 2^fwi
+	byte sfgi;						// Start-up frame guard time integer
+	byte bitRates;					// TA(1), bit rates supported in addition to 106 kbit/s
+	bool supportsCID;
+	uint32_t apduTime;				// Time in μs the card needs to process a command APDU
+
+	void setFile(const byte *data, uint16_t length);
+	uint32_t fwt() const { return (uint32_t)302 << fwi; };
+
+protected:
+	byte _cid;
+	uint16_t _fsd;					// Frame size of the PCD, from RATS
+	bool _blockNumber;
+	bool _ppsAllowed;				// PPS is only accepted directly after RATS
+	bool _cidPresent;				// The last block of the PCD carried a CID
+	bool _wtxPending;				// An S(WTX) request is waiting for the PCD's S(WTX) response
+	byte _file[FILE_SIZE];
+	uint16_t _fileLength;
+	byte _command[APDU_SIZE];		// Command APDU, assembled from chained I-blocks
+	uint16_t _commandLength;
+	byte _response[APDU_SIZE];		// Response APDU, sent in chained I-blocks
+	uint16_t _responseLength;
+	uint16_t _responseOffset;		// Bytes of _response sent before the last block
+	uint16_t _responseSent;			// Bytes of _response sent including the last block
+	uint16_t _getResponse;			// Offset in _file for GET RESPONSE after 61xx
+
+	bool command(const byte *data, uint16_t length, Frame *reply) override;
+	void selected() override;
+	bool block(const byte *data, uint16_t length, Frame *reply);
+	void sendResponse(Frame *reply, uint32_t delay);
+	void answerBlock(Frame *reply, byte pcb, const byte *inf, uint16_t infLength, uint32_t delay);
+	virtual void apdu(const byte *command, uint16_t length, byte *response, uint16_t *responseLength);
+};
+
+#endif
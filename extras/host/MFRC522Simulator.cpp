@@ -0,0 +1,435 @@
+/*
+ * Timed model of an MFRC522 and the PICCs in its field, for host builds.
+ */
+#include "MFRC522Simulator.h"
+
+/**
+ * Constructor.
+ * The chip starts in its reset state with the antenna off, the SPI clock at MFRC522_SPICLOCK.
+ */
+MFRC522Simulator::MFRC522Simulator() {
+	_tagCount = 0;
+	_time = 0;
+	_wakeUpTime = 500;
+	_fieldOn = false;
+	setSpiClock(MFRC522_SPICLOCK);
+	reset();
+	resetStats();
+} // End constructor
+
+/**
+ * Puts a PICC into the field. It starts in state IDLE.
+ *
+ * @return false if MAX_TAGS tags are in the field already.
+ */
+bool MFRC522Simulator::addTag(MFRC522SimTag *tag) {
+	if (_tagCount >= MAX_TAGS) {
+		return false;
+	}
+	tag->powerOff();
+	_tags[_tagCount++] = tag;
+	return true;
+} // End addTag()
+
+/**
+ * Takes a PICC out of the field.
+ */
+void MFRC522Simulator::removeTag(MFRC522SimTag *tag) {
+	for (byte index = 0; index < _tagCount; index++) {
+		if (_tags[index] == tag) {
+			_tagCount--;
+			memmove(&_tags[index], &_tags[index + 1], (_tagCount - index) * sizeof(_tags[0]));
+			tag->powerOff();
+			return;
+		}
+	}
+} // End removeTag()
+
+/**
+ * Sets the SPI clock used to account the time of register accesses.
+ */
+void MFRC522Simulator::setSpiClock(uint32_t hz) {
+	_spiByteTime = 8000000000ULL / (hz ? hz : 1);
+} // End setSpiClock()
+
+/**
+ * Sets the time the oscillator needs to start after PowerDown is cleared. The datasheet does not specify it,
+ * it depends on the crystal. PowerDown in CommandReg reads as 1 until then.
+ */
+void MFRC522Simulator::setWakeUpTime(uint32_t us) {
+	_wakeUpTime = us;
+} // End setWakeUpTime()
+
+/**
+ * Loads the reset values of the registers and stops all activity. Like a SoftReset this switches the antenna off.
+ */
+void MFRC522Simulator::reset() {
+	MFRC522MockBus::reset();
+	_phase = PHASE_IDLE;
+	_timerAt = NEVER;
+	_wakeUpAt = NEVER;
+	updateField();
+} // End reset()
+
+/**
+ * Clears the bus and air interface counters.
+ */
+void MFRC522Simulator::resetStats() {
+	MFRC522MockBus::resetStats();
+	rfStats.frames = 0;
+	rfStats.answers = 0;
+	rfStats.airTime = 0;
+} // End resetStats()
+
+byte MFRC522Simulator::transfer(byte data) {
+	_time += _spiByteTime;
+	advance();
+	byte value = MFRC522MockBus::transfer(data);
+	updateAlerts();
+	return value;
+} // End transfer()
+
+/**
+ * Returns the virtual time in μs. Every call takes 1μs, so polling loops make progress.
+ */
+uint32_t MFRC522Simulator::now() {
+	_time += 1000;
+	advance();
+	return _time / 1000;
+} // End now()
+
+void MFRC522Simulator::wait(uint32_t us) {
+	_time += (uint64_t)us * 1000;
+	advance();
+} // End wait()
+
+/**
+ * Applies a register write. On top of MFRC522MockBus:
+ * A new command stops the running one, NoCmdChange only changes RcvOff and PowerDown, PowerDown and
+ * TxControlReg switch the field.
+ */
+void MFRC522Simulator::writeRegister(byte address, byte value) {
+	if (address == addressOf(MFRC522::CommandReg)) {
+		byte old = registers[address];
+		if ((old & 0x10) && !(value & 0x10)) {		// Wake up
+			if (_wakeUpAt == NEVER) {
+				_wakeUpAt = _time + (uint64_t)_wakeUpTime * 1000;
+			}
+			value |= 0x10;							// PowerDown reads 1 until the oscillator runs
+		}
+		if ((value & 0x0F) == MFRC522::PCD_NoCmdChange) {
+			registers[address] = (value & 0x30) | (old & 0x0F);
+		} else {
+			_phase = PHASE_IDLE;
+			_timerAt = NEVER;
+			MFRC522MockBus::writeRegister(address, value);
+		}
+		updateField();
+	} else {
+		MFRC522MockBus::writeRegister(address, value);
+		if (address == addressOf(MFRC522::TxControlReg)) {
+			updateField();
+		}
+	}
+} // End writeRegister()
+
+void MFRC522Simulator::execute(byte command) {
+	switch (command) {
+		case MFRC522::PCD_Idle:
+		case MFRC522::PCD_Transceive:		// Waits for StartSend
+			break;
+		default:
+			MFRC522MockBus::execute(command);
+			break;
+	}
+} // End execute()
+
+/**
+ * StartSend: the transmitter starts taking bytes from the FIFO.
+ * Like the chip, Transceive ignores StartSend while it waits for or receives an answer, also after a timeout.
+ */
+void MFRC522Simulator::transceive() {
+	advance();
+	if (_phase == PHASE_WAIT || _phase == PHASE_RX) {
+		return;
+	}
+	byte bitFraming = registers[addressOf(MFRC522::BitFramingReg)];
+	registers[addressOf(MFRC522::ErrorReg)] = 0;
+	_txLength = 0;
+	_txLastBits = bitFraming & 0x07;
+	_rxAlign = (bitFraming >> 4) & 0x07;
+	_phase = PHASE_TX;
+	_phaseStart = _time;
+	_txNext = _time;
+	_timerAt = NEVER;
+	advance();
+} // End transceive()
+
+/**
+ * MFAuthent: takes the 12 byte authentication frame from the FIFO and runs the MIFARE authentication with the
+ * active PICC. MFCrypto1On is set and IdleIRq signalled after the four frames of the protocol.
+ */
+void MFRC522Simulator::authenticate() {
+	sentLength = 0;
+	while (_fifoLength && sentLength < 12) {
+		sent[sentLength++] = fifoPop();
+	}
+	sentLastBits = 0;
+	registers[addressOf(MFRC522::Status2Reg)] &= ~0x08;		// MFCrypto1On
+	registers[addressOf(MFRC522::ErrorReg)] = 0;
+
+	bool accepted = false;
+	if (_fieldOn && sentLength == 12) {
+		for (byte index = 0; index < _tagCount; index++) {
+			MFRC522SimTag *tag = _tags[index];
+			if (tag->isPresent() && tag->state() == MFRC522SimTag::STATE_ACTIVE) {
+				accepted |= tag->authenticate(sent[0], sent[1], &sent[2], &sent[8]);
+			}
+		}
+	}
+
+	// AUTH with CRC_A, token RB, token AB and token BA
+	uint32_t byteTx = 9 * bitTime(txRate());
+	uint32_t byteRx = 9 * bitTime(rxRate());
+	uint64_t nonce = 4 * byteTx + MFRC522SimTag::FDT_US * 1000 + 4 * byteRx;
+	rfStats.frames += 2;
+	_phaseStart = _time;
+	if (accepted) {
+		_phase = PHASE_AUTH;
+		_rxEnd = _time + nonce + 8 * byteTx + MFRC522SimTag::FDT_US * 1000 + 4 * byteRx;
+		_timerAt = NEVER;
+	} else {
+		_phase = PHASE_WAIT;
+		_rxStart = NEVER;
+		_timerAt = NEVER;
+		if (registers[addressOf(MFRC522::TModeReg)] & 0x80) {	// TAuto
+			_timerAt = _time + nonce + 8 * byteTx + timerPeriod();
+		}
+	}
+} // End authenticate()
+
+/**
+ * Runs the transmitter, receiver and timer up to the current time.
+ */
+void MFRC522Simulator::advance() {
+	if (_wakeUpAt != NEVER && _time >= _wakeUpAt) {
+		_wakeUpAt = NEVER;
+		registers[addressOf(MFRC522::CommandReg)] &= ~0x10;	// PowerDown
+		updateField();
+	}
+
+	bool running = true;
+	while (running) {
+		switch (_phase) {
+			case PHASE_TX:
+				if (_txNext > _time) {
+					running = false;
+				} else if (_fifoLength == 0) {
+					endTransmission(_txNext);
+				} else {
+					if (_txLength < sizeof(_txFrame) - 2) {
+						_txFrame[_txLength++] = fifoPop();
+					} else {
+						fifoPop();
+					}
+					_txNext += 9 * bitTime(txRate());
+				}
+				break;
+			case PHASE_WAIT:
+				if (_timerAt <= _time && _timerAt < _rxStart) {
+					registers[addressOf(MFRC522::ComIrqReg)] |= 0x01;	// TimerIRq
+					_timerAt = NEVER;
+				}
+				if (_rxStart <= _time) {
+					_phase = PHASE_RX;
+					_timerAt = NEVER;		// The timer stops at the first bit received
+				} else {
+					running = false;
+				}
+				break;
+			case PHASE_RX: {
+				uint32_t byteRx = 9 * bitTime(rxRate());
+				while (_rxPushed < _rxLength && _rxStart + (uint64_t)(_rxPushed + 1) * byteRx <= _time) {
+					fifoPush(_rxFrame[_rxPushed++]);
+				}
+				if (_rxEnd <= _time) {
+					endReception();
+				} else {
+					running = false;
+				}
+				break;
+			}
+			case PHASE_AUTH:
+				if (_rxEnd <= _time) {
+					registers[addressOf(MFRC522::Status2Reg)] |= 0x08;	// MFCrypto1On
+					registers[addressOf(MFRC522::CommandReg)] &= ~0x0F;	// Idle
+					registers[addressOf(MFRC522::ComIrqReg)] |= 0x10;	// IdleIRq
+					rfStats.answers += 2;
+					rfStats.airTime += (_rxEnd - _phaseStart) / 1000;
+					_phase = PHASE_IDLE;
+				} else {
+					running = false;
+				}
+				break;
+			default:
+				running = false;
+				break;
+		}
+	}
+	updateAlerts();
+} // End advance()
+
+/**
+ * The transmitter found the FIFO empty: the frame is complete. It is delivered to the PICCs in the field and their
+ * answers are combined bit by bit like on the air, a bit sent differently by two PICCs is a collision.
+ */
+void MFRC522Simulator::endTransmission(uint64_t at) {
+	sentLength = _txLength < sizeof(sent) ? _txLength : sizeof(sent);
+	memcpy(sent, _txFrame, sentLength);
+	sentLastBits = _txLastBits;
+
+	uint16_t bits = 8 * _txLength;
+	if (_txLastBits && _txLength) {
+		bits -= 8 - _txLastBits;
+	}
+	if ((registers[addressOf(MFRC522::TxModeReg)] & 0x80) && bits && bits % 8 == 0) {	// TxCRCEn
+		uint16_t crc = crcA(_txFrame, _txLength);
+		_txFrame[_txLength++] = crc & 0xFF;
+		_txFrame[_txLength++] = crc >> 8;
+		bits += 16;
+		at += 18 * bitTime(txRate());
+	}
+	registers[addressOf(MFRC522::ComIrqReg)] |= 0x40;	// TxIRq
+	rfStats.frames++;
+	rfStats.airTime += (at - _phaseStart) / 1000;
+	_phase = PHASE_WAIT;
+	_timerAt = NEVER;
+	if (registers[addressOf(MFRC522::TModeReg)] & 0x80) {	// TAuto
+		_timerAt = at + timerPeriod();
+	}
+
+	// Collect the answers, bit n of the answer goes to bit _rxAlign + n of the FIFO
+	bool crypto1 = registers[addressOf(MFRC522::Status2Reg)] & 0x08;
+	bool answered = false;
+	uint16_t rxBits = 0;
+	int32_t collision = -1;
+	uint32_t delay = 0;
+	memset(_rxFrame, 0, sizeof(_rxFrame));
+	for (byte index = 0; _fieldOn && bits && index < _tagCount; index++) {
+		if (!_tags[index]->receive(_txFrame, bits, crypto1, txRate(), &_reply) || _reply.bitRate != rxRate()) {
+			continue;
+		}
+		for (uint16_t bit = 0; bit < _reply.bits && _rxAlign + bit < 8 * (sizeof(_rxFrame) - 2); bit++) {
+			uint16_t source = _reply.align + bit;
+			uint16_t target = _rxAlign + bit;
+			byte value = (_reply.data[source / 8] >> (source % 8)) & 0x01;
+			if (answered && bit < rxBits) {
+				if (value != ((_rxFrame[target / 8] >> (target % 8)) & 0x01) && (collision < 0 || bit < collision)) {
+					collision = bit;
+				}
+			} else {
+				_rxFrame[target / 8] |= value << (target % 8);
+			}
+		}
+		if (!answered || _reply.delay < delay) {
+			delay = _reply.delay;
+		}
+		if (_reply.bits > rxBits) {
+			rxBits = _reply.bits;
+		}
+		answered = true;
+	}
+	if (!answered) {
+		_rxStart = NEVER;
+		return;
+	}
+
+	uint16_t total = _rxAlign + rxBits;
+	_rxLength = (total + 7) / 8;
+	_rxLastBits = total % 8;
+	_rxPushed = 0;
+	_rxError = 0;
+	_rxColl = 0x20;		// CollPosNotValid
+	if (collision >= 0) {
+		uint16_t target = _rxAlign + collision;
+		_rxFrame[target / 8] |= 1 << (target % 8);
+		if (!(registers[addressOf(MFRC522::CollReg)] & 0x80)) {	// ValuesAfterColl = 0: later bits are cleared
+			_rxFrame[target / 8] &= 0xFF >> (7 - target % 8);
+			memset(&_rxFrame[target / 8 + 1], 0, _rxLength - target / 8 - 1);
+		}
+		_rxError |= 0x08;	// CollErr
+		uint16_t position = target + 1;
+		_rxColl = position > 32 ? 0x20 : (position & 0x1F);
+	}
+	_rxStart = at + (uint64_t)delay * 1000;
+	_rxEnd = _rxStart + (uint64_t)_rxLength * 9 * bitTime(rxRate());
+	if ((registers[addressOf(MFRC522::RxModeReg)] & 0x80) && collision < 0 && _rxLastBits == 0) {	// RxCRCEn
+		if (_rxLength < 2 || crcA(_rxFrame, _rxLength - 2) != (_rxFrame[_rxLength - 2] | (_rxFrame[_rxLength - 1] << 8))) {
+			_rxError |= 0x04;	// CRCErr
+		} else {
+			_rxLength -= 2;		// The CRC_A is not written to the FIFO
+		}
+	}
+} // End endTransmission()
+
+/**
+ * The last bit of the answer was received.
+ */
+void MFRC522Simulator::endReception() {
+	while (_rxPushed < _rxLength) {
+		fifoPush(_rxFrame[_rxPushed++]);
+	}
+	registers[addressOf(MFRC522::ControlReg)] = (registers[addressOf(MFRC522::ControlReg)] & ~0x07) | _rxLastBits;
+	registers[addressOf(MFRC522::ErrorReg)] |= _rxError;
+	registers[addressOf(MFRC522::CollReg)] = (registers[addressOf(MFRC522::CollReg)] & 0x80) | _rxColl;
+	registers[addressOf(MFRC522::ComIrqReg)] |= 0x20;	// RxIRq
+	if (registers[addressOf(MFRC522::ErrorReg)] & 0x1F) {
+		registers[addressOf(MFRC522::ComIrqReg)] |= 0x02;	// ErrIRq
+	}
+	rfStats.answers++;
+	rfStats.airTime += (_rxEnd - _rxStart) / 1000;
+	_phase = PHASE_IDLE;
+} // End endReception()
+
+/**
+ * The antenna drivers are on if TX1 or TX2 is enabled and the chip is not powered down.
+ * PICCs lose their state when the field goes off.
+ */
+void MFRC522Simulator::updateField() {
+	bool on = (registers[addressOf(MFRC522::TxControlReg)] & 0x03) && !(registers[addressOf(MFRC522::CommandReg)] & 0x10);
+	if (_fieldOn && !on) {
+		for (byte index = 0; index < _tagCount; index++) {
+			_tags[index]->powerOff();
+		}
+	}
+	_fieldOn = on;
+} // End updateField()
+
+/**
+ * Updates the FIFO level and timer flags in Status1Reg, and HiAlertIRq and LoAlertIRq in ComIrqReg.
+ */
+void MFRC522Simulator::updateAlerts() {
+	byte waterLevel = registers[addressOf(MFRC522::WaterLevelReg)] & 0x3F;
+	byte status = registers[addressOf(MFRC522::Status1Reg)] & ~0x0B;
+	if (MFRC522::FIFO_SIZE - _fifoLength <= waterLevel) {
+		status |= 0x02;										// HiAlert
+		registers[addressOf(MFRC522::ComIrqReg)] |= 0x08;	// HiAlertIRq
+	}
+	if (_fifoLength <= waterLevel) {
+		status |= 0x01;										// LoAlert
+		registers[addressOf(MFRC522::ComIrqReg)] |= 0x04;	// LoAlertIRq
+	}
+	if (_timerAt != NEVER) {
+		status |= 0x08;										// TRunning
+	}
+	registers[addressOf(MFRC522::Status1Reg)] = status;
+} // End updateAlerts()
+
+/**
+ * @return the period of the timer in ns, (TPrescaler * 2 + 1) * (TReload + 1) / 13.56 MHz.
+ */
+uint64_t MFRC522Simulator::timerPeriod() {
+	uint32_t prescaler = ((registers[addressOf(MFRC522::TModeReg)] & 0x0F) << 8) | registers[addressOf(MFRC522::TPrescalerReg)];
+	uint32_t reload = (registers[addressOf(MFRC522::TReloadRegH)] << 8) | registers[addressOf(MFRC522::TReloadRegL)];
+	return (uint64_t)(2 * prescaler + 1) * (reload + 1) * 100000 / 1356;
+} // End timerPeriod()
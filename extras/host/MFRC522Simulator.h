@@ -0,0 +1,113 @@
+/**
+ * Timed model of an MFRC522 and the PICCs in its field, for host builds.
+ *
+ * MFRC522Simulator is a MFRC522Bus, so the unchanged MFRC522 and MFRC522Extended classes run on top of it:
+ * 		MFRC522Simulator sim;
+ * 		MFRC522SimClassic card(uid);
+ * 		sim.addTag(&card);
+ * 		MFRC522 mfrc522(sim);
+ * 		mfrc522.PCD_Init();
+ * 		uint32_t start = sim.now();
+ * 		mfrc522.PICC_IsNewCardPresent() && mfrc522.PICC_ReadCardSerial();
+ * 		Serial.println(sim.now() - start);		// Latency in μs, SPI and air interface included
+ *
+ * Time is virtual. Every SPI byte advances it by 8 clocks of the SPI clock (setSpiClock()), every call to now()
+ * by 1μs, and wait() by the given time. On top of the register file, FIFO and CRC coprocessor of MFRC522MockBus
+ * the model covers:
+ * 	-	Transceive: the FIFO is sent at the bit rate in TxModeReg, one byte per 9 bit periods (8 data bits and parity),
+ * 		so the host can refill the FIFO while sending. The answer arrives after the frame delay time of the PICC at
+ * 		the bit rate in RxModeReg and fills the FIFO byte by byte. Bit oriented frames (TxLastBits, RxAlign),
+ * 		TxCRCEn/RxCRCEn, collisions (CollErr, CollReg) and FIFO overflow (BufferOvfl) are modelled.
+ * 	-	The timer with TAuto: TimerIRq fires the programmed time after the end of the transmission unless an
+ * 		answer started before.
+ * 	-	MFAuthent: IdleIRq and MFCrypto1On after the four authentication frames, TimerIRq for a wrong key.
+ * 	-	SoftReset, soft power-down (PowerDown in CommandReg, see setWakeUpTime()) and the antenna driver.
+ * 		Switching the field off resets the PICCs.
+ * 	-	HiAlert and LoAlert in Status1Reg and ComIrqReg, from WaterLevelReg.
+ * The IRQ pin is not modelled, use polling mode.
+ */
+#ifndef MFRC522Simulator_h
+#define MFRC522Simulator_h
+
+#include "MFRC522MockBus.h"
+#include "MFRC522SimTag.h"
+
+class MFRC522Simulator : public MFRC522MockBus {
+public:
+	static constexpr byte MAX_TAGS = 8;
+	static constexpr uint64_t NEVER = ~(uint64_t)0;
+
+	// Air interface traffic since the last resetStats()
+	typedef struct {
+		uint32_t frames;			// Frames sent by the PCD
+		uint32_t answers;			// Frames received from PICCs
+		uint32_t airTime;			// Time in μs the PCD was sending or receiving
+	} RfStats;
+
+	// Member variables
+	RfStats rfStats;
+
+	MFRC522Simulator();
+
+	bool addTag(MFRC522SimTag *tag);
+	void removeTag(MFRC522SimTag *tag);
+	void setSpiClock(uint32_t hz);
+	void setWakeUpTime(uint32_t us);
+	uint64_t time() const { return _time; };	// Virtual time in ns
+
+	void reset() override;
+	void resetStats() override;
+	byte transfer(byte data) override;
+	uint32_t now() override;
+	void wait(uint32_t us) override;
+
+protected:
+	enum Phase : byte {
+		PHASE_IDLE,					// No transmission in progress
+		PHASE_TX,					// Sending the FIFO
+		PHASE_WAIT,					// Waiting for an answer
+		PHASE_RX,					// Receiving an answer
+		PHASE_AUTH					// Running the MIFARE authentication
+	};
+
+	MFRC522SimTag *_tags[MAX_TAGS];
+	byte _tagCount;
+	uint64_t _time;					// Virtual time in ns
+	uint32_t _spiByteTime;			// ns per SPI byte
+	uint32_t _wakeUpTime;			// μs from clearing PowerDown until the oscillator runs
+	uint64_t _wakeUpAt;				// Time PowerDown clears, NEVER if not waking up
+	bool _fieldOn;
+	Phase _phase;
+	uint64_t _phaseStart;			// Start of the transmission
+	uint64_t _txNext;				// Time the transmitter takes the next byte from the FIFO
+	uint64_t _timerAt;				// Time of the next TimerIRq, NEVER if the timer is stopped
+	uint64_t _rxStart;				// Start of the answer, NEVER if no PICC answers
+	uint64_t _rxEnd;				// End of the answer, also end of PHASE_AUTH
+	byte _txFrame[MFRC522SimTag::MAX_FRAME + 2];
+	uint16_t _txLength;
+	byte _txLastBits;
+	byte _rxAlign;
+	byte _rxFrame[MFRC522SimTag::MAX_FRAME + 2];
+	uint16_t _rxLength;				// Bytes in _rxFrame, as they will appear in the FIFO
+	uint16_t _rxPushed;				// Bytes of _rxFrame already in the FIFO
+	byte _rxLastBits;
+	byte _rxError;					// ErrorReg bits set at the end of the answer
+	byte _rxColl;					// CollReg bits 6..0 set at the end of the answer
+	MFRC522SimTag::Frame _reply;
+
+	void writeRegister(byte address, byte value) override;
+	void execute(byte command) override;
+	void transceive() override;
+	void authenticate() override;
+	void advance();
+	void endTransmission(uint64_t at);
+	void endReception();
+	void updateField();
+	void updateAlerts();
+	uint64_t timerPeriod();
+	byte txRate() { return (registers[addressOf(MFRC522::TxModeReg)] >> 4) & 0x03; };
+	byte rxRate() { return (registers[addressOf(MFRC522::RxModeReg)] >> 4) & 0x03; };
+	static uint32_t bitTime(byte rate) { return 9439 >> rate; };	// ns per bit, 128/fc at 106 kbit/s
+};
+
+#endif
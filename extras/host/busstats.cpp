@@ -0,0 +1,61 @@
+/* Prints the SPI traffic of common MFRC522 calls, measured on a MFRC522MockBus. */
+#include "MFRC522MockBus.h"
+
+// Queues a PICC answer followed by its CRC_A, calculated by the mock's CalcCRC
+static void queueWithCRC(MFRC522MockBus &bus, MFRC522 &mfrc522, const byte *data, byte length) {
+	byte frame[MFRC522::FIFO_SIZE];
+	memcpy(frame, data, length);
+	mfrc522.PCD_CalculateCRC(frame, length, &frame[length]);
+	bus.queueResponse(frame, length + 2);
+}
+
+static void report(const char *call, const MFRC522MockBus &bus) {
+	printf("%-36s %6lu transactions %6lu frames %6lu bytes\n", call,
+		   (unsigned long)bus.stats.transactions, (unsigned long)bus.stats.frames, (unsigned long)bus.stats.bytes);
+}
+
+int main() {
+	MFRC522MockBus bus;
+	MFRC522 mfrc522(bus);
+	mfrc522.PCD_Init();
+
+	// A MIFARE Classic 1K with a 4 byte UID
+	const byte atqa[] = {0x04, 0x00};
+	const byte cl1[] = {0x11, 0x22, 0x33, 0x44, 0x11 ^ 0x22 ^ 0x33 ^ 0x44};
+	const byte sak[] = {0x08};
+	bus.queueResponse(atqa, sizeof(atqa));
+	bus.resetStats();
+	bool present = mfrc522.PICC_IsNewCardPresent();
+	report("PICC_IsNewCardPresent()", bus);
+
+	bus.queueResponse(cl1, sizeof(cl1));
+	queueWithCRC(bus, mfrc522, sak, sizeof(sak));
+	bus.resetStats();
+	bool selected = mfrc522.PICC_ReadCardSerial();
+	report("PICC_ReadCardSerial()", bus);
+
+	MFRC522::MIFARE_Key key;
+	memset(key.keyByte, 0xFF, MFRC522::MF_KEY_SIZE);
+	bus.resetStats();
+	MFRC522::StatusCode status = mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, 4, &key, &mfrc522.uid);
+	report("PCD_Authenticate()", bus);
+
+	// Sector 1 with the transport configuration: three empty data blocks and the default access bits
+	byte block[16] = {};
+	byte trailer[16] = {0, 0, 0, 0, 0, 0, 0xFF, 0x07, 0x80, 0x69, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+	bus.queueResponse(block, 0);		// Consumed by MFAuthent
+	queueWithCRC(bus, mfrc522, trailer, sizeof(trailer));
+	for (byte i = 0; i < 3; i++) {
+		queueWithCRC(bus, mfrc522, block, sizeof(block));
+	}
+	bus.resetStats();
+	mfrc522.PICC_DumpMifareClassicSectorToSerial(&mfrc522.uid, &key, 1);
+	report("PICC_DumpMifareClassicSectorToSerial()", bus);
+
+	mfrc522.PCD_StopCrypto1();
+	if (!present || !selected || status != MFRC522::STATUS_OK || bus.pendingResponses() != 0) {
+		printf("Unexpected PICC dialogue\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,62 @@
+/* Host implementation of the Arduino core functions declared in Arduino.h and SPI.h. */
+#include "Arduino.h"
+#include "SPI.h"
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+SPIClass SPI;
+
+static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+void pinMode(uint8_t /*pin*/, uint8_t /*mode*/) {}
+void digitalWrite(uint8_t /*pin*/, uint8_t /*val*/) {}
+int digitalRead(uint8_t /*pin*/) { return HIGH; }
+
+unsigned long micros() {
+	return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned long millis() {
+	return micros() / 1000;
+}
+
+void delay(unsigned long ms) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+	std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {}
+
+size_t HardwareSerial::print(const char *str) {
+	return fputs(str, stdout) < 0 ? 0 : strlen(str);
+}
+
+size_t HardwareSerial::print(char c) {
+	return putchar(c) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::print(long n, int base) {
+	if (n < 0 && base == DEC) {
+		return print('-') + print((unsigned long)-n, base);
+	}
+	return print((unsigned long)n, base);
+}
+
+size_t HardwareSerial::print(unsigned long n, int base) {
+	char buf[8 * sizeof(long) + 1];
+	char *str = &buf[sizeof(buf) - 1];
+	*str = '\0';
+	if (base < 2) {
+		base = DEC;
+	}
+	do {
+		char digit = n % base;
+		n /= base;
+		*--str = digit < 10 ? digit + '0' : digit + 'A' - 10;
+	} while (n);
+	return print(str);
+}
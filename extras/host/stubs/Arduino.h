@@ -0,0 +1,67 @@
+/**
+ * Minimal Arduino core for host builds of the MFRC522 library.
+ *
+ * Only what the sources in src/ use is provided. Serial prints to stdout, the pin functions do nothing and
+ * millis()/micros() follow the host clock.
+ */
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH			1
+#define LOW				0
+#define INPUT			0
+#define OUTPUT			1
+#define INPUT_PULLUP	2
+#define DEC				10
+#define HEX				16
+#define LSBFIRST		0
+#define MSBFIRST		1
+#define SS				10
+
+#define PROGMEM
+#define pgm_read_byte(addr)	(*(const uint8_t *)(addr))
+#define pgm_read_word(addr)	(*(const uint16_t *)(addr))
+
+class __FlashStringHelper;
+#define F(string_literal)	(reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+class HardwareSerial {
+public:
+	void begin(unsigned long /*baud*/) {};
+	operator bool() const { return true; };
+
+	size_t print(const __FlashStringHelper *str) { return print(reinterpret_cast<const char *>(str)); };
+	size_t print(const char *str);
+	size_t print(char c);
+	size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); };
+	size_t print(int n, int base = DEC) { return print((long)n, base); };
+	size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); };
+	size_t print(long n, int base = DEC);
+	size_t print(unsigned long n, int base = DEC);
+
+	size_t println() { return print("\r\n"); };
+	template<typename T> size_t println(T value) { size_t n = print(value); return n + println(); };
+	template<typename T> size_t println(T value, int base) { size_t n = print(value, base); return n + println(); };
+};
+
+extern HardwareSerial Serial;
+
+#endif
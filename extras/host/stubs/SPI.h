@@ -0,0 +1,31 @@
+/**
+ * Minimal SPI library for host builds of the MFRC522 library.
+ *
+ * The SPI object accepts every call and reads 0x00. Host programs talk to the chip through another MFRC522Bus.
+ */
+#ifndef SPI_h
+#define SPI_h
+
+#include "Arduino.h"
+
+#define SPI_CLOCK_DIV4	4000000
+#define SPI_MODE0		0
+
+class SPISettings {
+public:
+	SPISettings() {};
+	SPISettings(uint32_t /*clock*/, uint8_t /*bitOrder*/, uint8_t /*dataMode*/) {};
+};
+
+class SPIClass {
+public:
+	void begin() {};
+	void end() {};
+	void beginTransaction(SPISettings /*settings*/) {};
+	void endTransaction() {};
+	uint8_t transfer(uint8_t /*data*/) { return 0; };
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,84 @@
+/* MFRC522Apdu encodes short and extended APDUs, follows 61xx with GET RESPONSE, resends after 6Cxx and streams chunks. */
+#include "MFRC522Simulator.h"
+#include "MFRC522Apdu.h"
+#include "check.h"
+
+static byte file[600];
+
+static uint16_t chunkBytes;
+static uint16_t chunkMismatches;
+static void collect(const byte *data, uint16_t length, void *context) {
+	for (uint16_t i = 0; i < length; i++) {
+		if (data[i] != file[chunkBytes + i]) {
+			chunkMismatches++;
+		}
+	}
+	chunkBytes += length;
+	(*(uint16_t *)context)++;
+}
+
+int main() {
+	MFRC522Simulator sim;
+	const byte uid[] = {0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+	MFRC522SimIsoDep card(uid);
+	for (uint16_t i = 0; i < sizeof(file); i++) {
+		file[i] = (byte)(i * 7 + 3);
+	}
+	card.setFile(file, 20);
+	sim.addTag(&card);
+	MFRC522Extended mfrc522(sim);
+	mfrc522.PCD_Init();
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+
+	static byte buffer[MFRC522Apdu::HEADROOM + 700];
+	MFRC522Apdu apdu(mfrc522, &mfrc522.tag, buffer, sizeof(buffer));
+
+	// Case 1, header only
+	CHECK(apdu.begin(0x00, 0xA4, 0x04, 0x00) != NULL);
+	CHECK_EQUAL(MFRC522::STATUS_OK, apdu.transceive());
+	CHECK_EQUAL(MFRC522Apdu::SW_OK, apdu.sw());
+	CHECK_EQUAL(0, apdu.responseLength());
+
+	// Le 256 for a file of 20 bytes: 6C14, sent again with Le 20
+	apdu.begin(0x00, 0xB0, 0x00, 0x00, 0, 256);
+	CHECK_EQUAL(MFRC522::STATUS_OK, apdu.transceive());
+	CHECK_EQUAL(MFRC522Apdu::SW_OK, apdu.sw());
+	CHECK_EQUAL(20, apdu.responseLength());
+	CHECK_EQUAL(file[19], apdu.response()[19]);
+
+	// Extended Lc: UPDATE BINARY of 600 bytes, read back with extended Le
+	byte *body = apdu.begin(0x00, 0xD6, 0x00, 0x00, sizeof(file));
+	CHECK(body != NULL);
+	memcpy(body, file, sizeof(file));
+	CHECK_EQUAL(MFRC522::STATUS_OK, apdu.transceive());
+	CHECK_EQUAL(MFRC522Apdu::SW_OK, apdu.sw());
+	apdu.begin(0x00, 0xB0, 0x00, 0x00, 0, sizeof(file));
+	CHECK_EQUAL(MFRC522::STATUS_OK, apdu.transceive());
+	CHECK_EQUAL(sizeof(file), apdu.responseLength());
+	CHECK_EQUAL(0, memcmp(apdu.response(), file, sizeof(file)));
+
+	// GET DATA answers 6100, the 600 bytes come with GET RESPONSE and are appended
+	memset(buffer, 0, sizeof(buffer));
+	apdu.begin(0x00, 0xCA, 0x00, 0x00);
+	CHECK_EQUAL(MFRC522::STATUS_OK, apdu.transceive());
+	CHECK_EQUAL(MFRC522Apdu::SW_OK, apdu.sw());
+	CHECK_EQUAL(sizeof(file), apdu.responseLength());
+	CHECK_EQUAL(0, memcmp(apdu.response(), file, sizeof(file)));
+
+	// The same through a callback, with a buffer for one block only
+	static byte small[MFRC522Apdu::HEADROOM + 260];
+	MFRC522Apdu streamed(mfrc522, &mfrc522.tag, small, sizeof(small));
+	uint16_t calls = 0;
+	streamed.setChunkCallback(collect, &calls);
+	streamed.begin(0x00, 0xCA, 0x00, 0x00);
+	CHECK_EQUAL(MFRC522::STATUS_OK, streamed.transceive());
+	CHECK_EQUAL(MFRC522Apdu::SW_OK, streamed.sw());
+	CHECK_EQUAL(sizeof(file), streamed.responseLength());
+	CHECK_EQUAL(sizeof(file), chunkBytes);
+	CHECK_EQUAL(0, chunkMismatches);
+	CHECK(calls > 2);
+
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.TCL_Deselect(&mfrc522.tag));
+	return CHECK_RESULT();
+}
@@ -0,0 +1,61 @@
+/* MFRC522BlockCache writes back only the changed blocks, one authentication per sector. */
+#include "MFRC522Simulator.h"
+#include "MFRC522BlockCache.h"
+#include "check.h"
+
+int main() {
+	MFRC522Simulator sim;
+	MFRC522 mfrc522(sim);
+	mfrc522.PCD_Init();
+	const byte uid[] = {0x01, 0x02, 0x03, 0x04};
+	MFRC522SimClassic card(uid);
+	sim.addTag(&card);
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+
+	MFRC522BlockCache cache(mfrc522);
+	CHECK_EQUAL(MFRC522::STATUS_OK, cache.begin());
+	byte block[16];
+	CHECK_EQUAL(MFRC522::STATUS_OK, cache.read(4, block));
+	block[0] = 0x42;
+	CHECK_EQUAL(MFRC522::STATUS_OK, cache.write(4, block));
+	CHECK_EQUAL(MFRC522::STATUS_OK, cache.read(5, block));
+	CHECK_EQUAL(MFRC522::STATUS_OK, cache.write(5, block));		// Unchanged
+	CHECK_EQUAL(MFRC522::STATUS_OK, cache.read(8, block));
+	block[15] = 7;
+	CHECK_EQUAL(MFRC522::STATUS_OK, cache.write(8, block));
+	block[0] = 1;
+	CHECK_EQUAL(MFRC522::STATUS_OK, cache.write(9, block));
+	CHECK_EQUAL(MFRC522::STATUS_OK, cache.write(12, block));
+	CHECK_EQUAL(MFRC522::STATUS_OK, cache.write(1, block));
+
+	MFRC522BlockCache::FlushReport report;
+	CHECK_EQUAL(MFRC522::STATUS_OK, cache.flush(&report));
+	CHECK_EQUAL(5, report.written);
+	CHECK_EQUAL(1, report.skipped);
+	CHECK_EQUAL(0, report.failed);
+	CHECK_EQUAL(3, report.authentications);
+	CHECK(!cache.isDirty());
+	CHECK_EQUAL(0x42, card.block(4)[0]);
+	CHECK_EQUAL(7, card.block(8)[15]);
+	CHECK_EQUAL(1, card.block(9)[0]);
+	CHECK_EQUAL(1, card.block(12)[0]);
+	CHECK_EQUAL(1, card.block(1)[0]);
+
+	// More dirty blocks than lines: write-backs done to free a line are reported by the next flush()
+	byte blocks = 0;
+	for (byte blockAddr = 16; blockAddr < 40; blockAddr++) {
+		if (blockAddr % 4 == 3) {
+			continue;
+		}
+		CHECK_EQUAL(MFRC522::STATUS_OK, cache.read(blockAddr, block));
+		block[0] = blockAddr;
+		CHECK_EQUAL(MFRC522::STATUS_OK, cache.write(blockAddr, block));
+		blocks++;
+	}
+	CHECK_EQUAL(MFRC522::STATUS_OK, cache.flush(&report));
+	CHECK_EQUAL(blocks, report.written);
+	CHECK_EQUAL(16, card.block(16)[0]);
+	CHECK_EQUAL(38, card.block(38)[0]);
+	return CHECK_RESULT();
+}
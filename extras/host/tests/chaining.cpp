@@ -0,0 +1,66 @@
+/* TCL_TransceiveExtended() chains APDUs and responses larger than the frame sizes of the PCD and PICC. */
+#include "MFRC522Simulator.h"
+#include "MFRC522Extended.h"
+#include "check.h"
+
+static const uint16_t FILE_SIZE = 600;
+
+int main() {
+	MFRC522Simulator sim;
+	const byte uid[] = {0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+	MFRC522SimIsoDep card(uid);
+	static byte file[FILE_SIZE];
+	for (uint16_t i = 0; i < FILE_SIZE; i++) {
+		file[i] = i * 3;
+	}
+	card.setFile(file, FILE_SIZE);
+	sim.addTag(&card);
+	MFRC522Extended mfrc522(sim);
+	mfrc522.PCD_Init();
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+	CHECK_EQUAL(256, mfrc522.tag.ats.fsc);
+
+	// UPDATE BINARY of 220 bytes at offset 0x10 needs chaining towards the PICC
+	static byte apdu[5 + 220];
+	static byte response[FILE_SIZE];
+	apdu[0] = 0x00;
+	apdu[1] = 0xD6;
+	apdu[2] = 0x00;
+	apdu[3] = 0x10;
+	apdu[4] = 220;
+	for (byte i = 0; i < 220; i++) {
+		apdu[5 + i] = 0xA0 ^ i;
+	}
+	uint16_t responseLength = sizeof(response);
+	sim.resetStats();
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.TCL_TransceiveExtended(&mfrc522.tag, apdu, sizeof(apdu), response, &responseLength));
+	CHECK_EQUAL(2, responseLength);
+	CHECK_EQUAL(0x90, response[0]);
+	CHECK(sim.rfStats.frames > 2);
+
+	// READ BINARY with an extended Le of 500 needs chaining towards the PCD, and returns the updated bytes
+	byte readBinary[] = {0x00, 0xB0, 0x00, 0x00, 0x00, 0x01, 0xF4};
+	responseLength = sizeof(response);
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.TCL_TransceiveExtended(&mfrc522.tag, readBinary, sizeof(readBinary), response, &responseLength));
+	CHECK_EQUAL(502, responseLength);
+	CHECK_EQUAL(0x90, response[500]);
+	CHECK_EQUAL(0x00, response[501]);
+	for (uint16_t i = 0; i < 500; i++) {
+		byte expected = (i >= 0x10 && i < 0x10 + 220) ? (0xA0 ^ (i - 0x10)) : (byte)(i * 3);
+		CHECK_EQUAL(expected, response[i]);
+	}
+
+	// The byte sized TCL_Transceive() keeps working, also without a response buffer
+	byte shortRead[] = {0x00, 0xB0, 0x00, 0x00, 0x10};
+	byte shortLength = 64;
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.TCL_Transceive(&mfrc522.tag, shortRead, (byte)sizeof(shortRead), response, &shortLength));
+	CHECK_EQUAL(18, shortLength);
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.TCL_Transceive(&mfrc522.tag, shortRead, 5, NULL, NULL));
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.TCL_Transceive(&mfrc522.tag, shortRead, 5));
+
+	responseLength = 100;
+	CHECK_EQUAL(MFRC522::STATUS_NO_ROOM, mfrc522.TCL_TransceiveExtended(&mfrc522.tag, readBinary, sizeof(readBinary), response, &responseLength));
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.TCL_Deselect(&mfrc522.tag));
+	return CHECK_RESULT();
+}
@@ -0,0 +1,30 @@
+/**
+ * Assertions for the host tests. A test program returns the result of CHECK_RESULT() from main().
+ */
+#ifndef check_h
+#define check_h
+
+#include <stdio.h>
+
+static int checkFailures = 0;
+
+#define CHECK(condition) do { \
+		if (!(condition)) { \
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			checkFailures++; \
+		} \
+	} while (0)
+
+#define CHECK_EQUAL(expected, actual) do { \
+		long long checkExpected = (long long)(expected); \
+		long long checkActual = (long long)(actual); \
+		if (checkExpected != checkActual) { \
+			printf("%s:%d: CHECK_EQUAL(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #expected, #actual, \
+				   checkExpected, checkActual); \
+			checkFailures++; \
+		} \
+	} while (0)
+
+#define CHECK_RESULT() (checkFailures == 0 ? 0 : 1)
+
+#endif
@@ -0,0 +1,62 @@
+/* NTAG_FastRead() reads a whole NTAG216 in one frame, the FIFO being emptied while the answer arrives. */
+#include "MFRC522Simulator.h"
+#include "check.h"
+
+static const uint16_t PAGES = 231;
+
+int main() {
+	MFRC522Simulator sim;
+	MFRC522 mfrc522(sim);
+	mfrc522.PCD_Init();
+	const byte uid[] = {0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+	MFRC522SimUltralight ntag(uid, MFRC522SimUltralight::NTAG216);
+	sim.addTag(&ntag);
+	for (byte page = 4; page < 225; page++) {
+		for (byte j = 0; j < 4; j++) {
+			ntag.page(page)[j] = page + j;
+		}
+	}
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+
+	byte version[8];
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.NTAG_GetVersion(version));
+	CHECK_EQUAL(PAGES, MFRC522::NTAG_PageCount(version));
+
+	static byte buffer[PAGES * 4 + 2];			// Room for the CRC_A
+	uint16_t size = sizeof(buffer);
+	sim.resetStats();
+	uint32_t start = sim.now();
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.NTAG_FastRead(0, PAGES - 1, buffer, &size));
+	uint32_t fastTime = sim.now() - start;
+	CHECK_EQUAL(PAGES * 4, size);
+	CHECK_EQUAL(1, sim.rfStats.frames);
+	for (byte page = 4; page < 225; page++) {
+		for (byte j = 0; j < 4; j++) {
+			CHECK_EQUAL((byte)(page + j), buffer[page * 4 + j]);
+		}
+	}
+
+	sim.resetStats();
+	start = sim.now();
+	for (uint16_t page = 0; page < PAGES; page += 4) {
+		byte block[18];
+		byte blockSize = sizeof(block);
+		CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.MIFARE_Read(page, block, &blockSize));
+	}
+	CHECK(fastTime < sim.now() - start);
+	printf("FAST_READ %u us, READ loop %u us\n", fastTime, sim.now() - start);
+
+	size = 10;
+	CHECK_EQUAL(MFRC522::STATUS_NO_ROOM, mfrc522.NTAG_FastRead(0, 3, buffer, &size));
+
+	// A slow SPI clock cannot keep up with the reception, but must not corrupt the result
+	sim.setSpiClock(1000000);
+	size = sizeof(buffer);
+	memset(buffer, 0, sizeof(buffer));
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.NTAG_FastRead(0, PAGES - 1, buffer, &size));
+	for (byte page = 4; page < 225; page++) {
+		CHECK_EQUAL((byte)(page + 3), buffer[page * 4 + 3]);
+	}
+	return CHECK_RESULT();
+}
@@ -0,0 +1,64 @@
+/* PICC_Inventory() finds every PICC in the field in fewer frames than a REQA/select/HLTA loop. */
+#include "MFRC522Simulator.h"
+#include "check.h"
+
+static const byte uids[8][7] = {
+	{0x11, 0x22, 0x33, 0x44}, {0x11, 0x22, 0x33, 0x45}, {0x11, 0xA2, 0x33, 0x44}, {0x91, 0x22, 0x33, 0x44},
+	{0x11, 0x22, 0x33, 0xC4}, {0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06}, {0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x07},
+	{0x04, 0x81, 0x02, 0x03, 0x04, 0x05, 0x06}
+};
+
+// Resets the PICCs to IDLE
+static void cycleField(MFRC522 &mfrc522) {
+	mfrc522.PCD_AntennaOff();
+	mfrc522.PCD_AntennaOn();
+}
+
+int main() {
+	MFRC522Simulator sim;
+	MFRC522SimClassic c0(uids[0]), c1(uids[1]), c2(uids[2]), c3(uids[3]), c4(uids[4]);
+	MFRC522SimUltralight u0(uids[5]), u1(uids[6]), u2(uids[7]);
+	MFRC522SimTag *tags[] = {&c0, &c1, &c2, &c3, &c4, &u0, &u1, &u2};
+	for (MFRC522SimTag *tag : tags) {
+		sim.addTag(tag);
+	}
+	MFRC522 mfrc522(sim);
+	mfrc522.PCD_Init();
+
+	MFRC522::Uid found[10];
+	byte count;
+	sim.resetStats();
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.PICC_Inventory(found, 10, &count));
+	uint32_t inventoryFrames = sim.rfStats.frames;
+	CHECK_EQUAL(8, count);
+	for (byte i = 0; i < 8; i++) {
+		byte matches = 0;
+		for (byte j = 0; j < count; j++) {
+			byte size = i < 5 ? 4 : 7;
+			matches += found[j].size == size && memcmp(found[j].uidByte, uids[i], size) == 0;
+		}
+		CHECK_EQUAL(1, matches);
+	}
+
+	// maxCount stops the inventory early
+	cycleField(mfrc522);
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.PICC_Inventory(found, 3, &count));
+	CHECK_EQUAL(3, count);
+
+	// So does the time budget
+	cycleField(mfrc522);
+	CHECK_EQUAL(MFRC522::STATUS_TIMEOUT, mfrc522.PICC_Inventory(found, 10, &count, 5000));
+	CHECK(count < 8);
+
+	cycleField(mfrc522);
+	sim.resetStats();
+	byte naive = 0;
+	while (mfrc522.PICC_IsNewCardPresent() && mfrc522.PICC_ReadCardSerial()) {
+		naive++;
+		mfrc522.PICC_HaltA();
+	}
+	CHECK_EQUAL(8, naive);
+	CHECK(inventoryFrames < sim.rfStats.frames);
+	printf("inventory %u frames, REQA loop %u frames\n", inventoryFrames, sim.rfStats.frames);
+	return CHECK_RESULT();
+}
@@ -0,0 +1,59 @@
+/* MFRC522KeySearch finds the keys of every sector and tries the key that worked last time first. */
+#include "MFRC522Simulator.h"
+#include "MFRC522KeySearch.h"
+#include "check.h"
+
+static const uint16_t KEY_COUNT = 40;
+static byte dictionary[KEY_COUNT][MFRC522::MF_KEY_SIZE];
+
+static void wakeAndSelect(MFRC522 &mfrc522) {
+	byte atqa[2];
+	byte atqaSize = sizeof(atqa);
+	mfrc522.PICC_WakeupA(atqa, &atqaSize);
+	mfrc522.PICC_ReadCardSerial();
+}
+
+int main() {
+	for (uint16_t i = 0; i < KEY_COUNT; i++) {
+		for (byte j = 0; j < MFRC522::MF_KEY_SIZE; j++) {
+			dictionary[i][j] = i * 7 + j + 1;
+		}
+	}
+	MFRC522Simulator sim;
+	MFRC522 mfrc522(sim);
+	mfrc522.PCD_Init();
+	const byte uid[] = {0x01, 0x02, 0x03, 0x04};
+	MFRC522SimClassic card(uid);
+	sim.addTag(&card);
+	for (byte sector = 0; sector < 16; sector++) {
+		memcpy(card.block(sector * 4 + 3), dictionary[30], MFRC522::MF_KEY_SIZE);
+		memcpy(card.block(sector * 4 + 3) + 10, dictionary[31], MFRC522::MF_KEY_SIZE);
+	}
+	memcpy(card.block(15), dictionary[2], MFRC522::MF_KEY_SIZE);		// Sector 3 opens with key 2
+	memset(card.block(19), 0x55, MFRC522::MF_KEY_SIZE);					// Sector 4 with keys outside the dictionary
+	memset(card.block(19) + 10, 0x66, MFRC522::MF_KEY_SIZE);
+
+	MFRC522KeySearch search(mfrc522, dictionary[0], KEY_COUNT, MFRC522KeySearch::KEY_AB);
+	uint32_t attempts[2];
+	for (byte tap = 0; tap < 2; tap++) {
+		wakeAndSelect(mfrc522);
+		uint32_t before = search.attempts();
+		CHECK_EQUAL(MFRC522::STATUS_TIMEOUT, search.searchCard(16));	// Sector 4 stays closed
+		attempts[tap] = search.attempts() - before;
+		CHECK_EQUAL(30, search.keyIndex(0));
+		CHECK_EQUAL(2, search.keyIndex(3));
+		CHECK_EQUAL(MFRC522KeySearch::KEY_NOT_FOUND, search.keyIndex(4));
+		CHECK_EQUAL(30, search.keyIndex(15));
+
+		CHECK_EQUAL(MFRC522::STATUS_OK, search.authenticate(3));
+		byte buffer[18];
+		byte size = sizeof(buffer);
+		CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.MIFARE_Read(12, buffer, &size));
+		mfrc522.PICC_HaltA();
+		mfrc522.PCD_StopCrypto1();
+	}
+	// The second tap reuses the keys found by the first
+	CHECK(attempts[1] * 4 < attempts[0]);
+	printf("first tap %u authentications, second tap %u\n", attempts[0], attempts[1]);
+	return CHECK_RESULT();
+}
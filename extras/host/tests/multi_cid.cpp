@@ -0,0 +1,71 @@
+/* Two ISO/IEC 14443-4 PICCs activated with their own CID and bit rate are used alternately. */
+#include "MFRC522Simulator.h"
+#include "MFRC522Apdu.h"
+#include "check.h"
+
+int main() {
+	MFRC522Simulator sim;
+	const byte uid1[] = {0x04, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01};
+	const byte uid2[] = {0x04, 0x02, 0x02, 0x02, 0x02, 0x02, 0x02};
+	MFRC522SimIsoDep card1(uid1), card2(uid2);
+	static byte file1[300], file2[300];
+	for (uint16_t i = 0; i < 300; i++) {
+		file1[i] = i;
+		file2[i] = 255 - i;
+	}
+	card1.setFile(file1, sizeof(file1));
+	card2.setFile(file2, sizeof(file2));
+	card1.bitRates = 0x22;				// 424 kbit/s in both directions
+	card2.bitRates = 0x00;				// 106 kbit/s only
+	sim.addTag(&card1);
+	sim.addTag(&card2);
+	MFRC522Extended mfrc522(sim);
+	mfrc522.PCD_Init();
+	mfrc522.PCD_SetMaxBitRate(MFRC522Extended::BITRATE_424KBITS);
+
+	MFRC522Extended::TagInfo tags[2];
+	for (byte i = 0; i < 2; i++) {
+		CHECK(mfrc522.PICC_IsNewCardPresent());
+		CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.PICC_Activate(&tags[i], i + 1));
+		CHECK_EQUAL(i + 1, tags[i].cid);
+	}
+	CHECK(!mfrc522.PICC_IsNewCardPresent());
+	CHECK(tags[0].uid.uidByte[1] != tags[1].uid.uidByte[1]);
+	MFRC522Extended::TagInfo *fast = tags[0].ds == 2 ? &tags[0] : &tags[1];
+	MFRC522Extended::TagInfo *slow = fast == &tags[0] ? &tags[1] : &tags[0];
+	CHECK_EQUAL(2, fast->ds);
+	CHECK_EQUAL(2, fast->dr);
+	CHECK_EQUAL(0, slow->ds);
+	CHECK_EQUAL(0, slow->dr);
+
+	static byte buffer[MFRC522Apdu::HEADROOM + 300];
+	for (byte round = 0; round < 3; round++) {
+		for (byte i = 0; i < 2; i++) {
+			bool first = tags[i].uid.uidByte[1] == 0x01;
+			MFRC522Apdu apdu(mfrc522, &tags[i], buffer, sizeof(buffer));
+			apdu.begin(0x00, 0xB0, 0x00, round * 10, 0, 100);
+			CHECK_EQUAL(MFRC522::STATUS_OK, apdu.transceive());
+			CHECK_EQUAL(0x9000, apdu.sw());
+			CHECK_EQUAL(100, apdu.responseLength());
+			for (uint16_t k = 0; k < apdu.responseLength(); k++) {
+				CHECK_EQUAL(first ? round * 10 + k : 255 - (round * 10 + k), apdu.response()[k]);
+			}
+
+			byte readBinary[] = {0x00, 0xB0, 0x00, 0x00, 0x04};
+			byte response[10];
+			uint16_t responseLength = sizeof(response);
+			CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.TCL_TransceiveExtended(&tags[i], readBinary, sizeof(readBinary), response, &responseLength));
+			CHECK_EQUAL(first ? 0x00 : 0xFF, response[0]);
+		}
+	}
+	for (byte i = 0; i < 2; i++) {
+		CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.TCL_PresenceCheck(&tags[i]));
+	}
+	for (byte i = 0; i < 2; i++) {
+		CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.TCL_Deselect(&tags[i]));
+	}
+	for (byte i = 0; i < 2; i++) {
+		CHECK(mfrc522.TCL_PresenceCheck(&tags[i]) != MFRC522::STATUS_OK);
+	}
+	return CHECK_RESULT();
+}
@@ -0,0 +1,40 @@
+/* PICC_PollPresence() costs a few SPI frames per poll, still sends a REQA every time and returns once a PICC answers. */
+#include "MFRC522Simulator.h"
+#include "check.h"
+
+int main() {
+	MFRC522Simulator sim;
+	MFRC522 mfrc522(sim);
+	mfrc522.PCD_Init();
+	mfrc522.PICC_IsNewCardPresent();
+	sim.resetStats();
+	for (byte i = 0; i < 10; i++) {
+		CHECK(!mfrc522.PICC_IsNewCardPresent());
+	}
+	uint32_t classicFrames = sim.stats.frames;
+
+	mfrc522.PICC_PollPresence();
+	sim.resetStats();
+	for (byte i = 0; i < 10; i++) {
+		CHECK(!mfrc522.PICC_PollPresence());
+	}
+	CHECK_EQUAL(10, sim.rfStats.frames);
+	CHECK(sim.stats.frames * 10 < classicFrames);
+
+	const byte uid[] = {0x01, 0x02, 0x03, 0x04};
+	MFRC522SimClassic card(uid);
+	sim.addTag(&card);
+	CHECK(mfrc522.PICC_PollPresence());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+	CHECK_EQUAL(0x04, mfrc522.uid.uidByte[3]);
+	mfrc522.PICC_HaltA();
+	CHECK(!mfrc522.PICC_PollPresence());
+	sim.removeTag(&card);
+	CHECK(!mfrc522.PICC_PollPresence());
+	MFRC522SimClassic other(uid);
+	sim.addTag(&other);
+	uint32_t start = sim.now();
+	CHECK(mfrc522.PICC_PollPresence());
+	CHECK(sim.now() - start < 1000);			// The ATQA ends the poll before the REQA timeout
+	return CHECK_RESULT();
+}
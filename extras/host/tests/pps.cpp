@@ -0,0 +1,89 @@
+/* PICC_ReadCardSerial() on MFRC522Extended negotiates the fastest bit rate the PCD and PICC share with PPS. */
+#include "MFRC522Simulator.h"
+#include "MFRC522Extended.h"
+#include "check.h"
+
+// A PICC that acknowledges PPS but keeps 106 kbit/s
+class MFRC522SimStubbornIsoDep : public MFRC522SimIsoDep {
+public:
+	MFRC522SimStubbornIsoDep(const byte *uid) : MFRC522SimIsoDep(uid) {};
+	bool command(const byte *data, uint16_t length, Frame *response) override {
+		bool pps = _ppsAllowed && (data[0] & 0xF0) == 0xD0;
+		bool answered = MFRC522SimIsoDep::command(data, length, response);
+		if (pps) {
+			_txRate = 0;
+			_rxRate = 0;
+		}
+		return answered;
+	}
+};
+
+// Activates a PICC announcing bitRates in TA(1), reads 500 bytes and checks TxModeReg and RxModeReg
+static void check(MFRC522Extended::TagBitRates maxBitRate, byte bitRates, byte txSpeed, byte rxSpeed, bool stubborn = false) {
+	MFRC522Simulator sim;
+	const byte uid[] = {0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+	MFRC522SimIsoDep compliant(uid);
+	MFRC522SimStubbornIsoDep stubbornCard(uid);
+	MFRC522SimIsoDep &card = stubborn ? stubbornCard : compliant;
+	static byte file[600];
+	card.setFile(file, sizeof(file));
+	card.bitRates = bitRates;
+	sim.addTag(&card);
+	MFRC522Extended mfrc522(sim);
+	mfrc522.PCD_Init();
+	mfrc522.PCD_SetMaxBitRate(maxBitRate);
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+
+	byte apdu[] = {0x00, 0xB0, 0x00, 0x00, 0x00, 0x01, 0xF4};
+	static byte response[502];
+	uint16_t responseLength = sizeof(response);
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.TCL_TransceiveExtended(&mfrc522.tag, apdu, sizeof(apdu), response, &responseLength));
+	CHECK_EQUAL(502, responseLength);
+	if ((mfrc522.PCD_ReadRegister(MFRC522::TxModeReg) & 0x70) != txSpeed
+		|| (mfrc522.PCD_ReadRegister(MFRC522::RxModeReg) & 0x70) != rxSpeed) {
+		printf("max %d TA(1) %02X: TxModeReg %02X RxModeReg %02X\n", maxBitRate, bitRates,
+			   mfrc522.PCD_ReadRegister(MFRC522::TxModeReg), mfrc522.PCD_ReadRegister(MFRC522::RxModeReg));
+		checkFailures++;
+	}
+}
+
+// Without PCD_SetMaxBitRate() PPS stops at 212 kbit/s. A PICC that does not follow the PPS costs a reset of the field.
+static void checkDefaults() {
+	MFRC522Simulator sim;
+	const byte uid[] = {0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+	MFRC522SimIsoDep card(uid);
+	card.bitRates = 0x77;
+	sim.addTag(&card);
+	MFRC522Extended mfrc522(sim);
+	mfrc522.PCD_Init();
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.PICC_Select(&mfrc522.tag.uid));
+	CHECK_EQUAL(MFRC522Extended::BITRATE_212KBITS, mfrc522.tag.ds);
+	CHECK_EQUAL(MFRC522Extended::BITRATE_212KBITS, mfrc522.tag.dr);
+
+	MFRC522SimStubbornIsoDep stubborn(uid);
+	stubborn.bitRates = 0x77;
+	sim.removeTag(&card);
+	sim.addTag(&stubborn);
+	MFRC522Extended::TagInfo tag;
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK_EQUAL(MFRC522::STATUS_FIELD_RESET, mfrc522.PICC_Activate(&tag, 1));
+	CHECK_EQUAL(MFRC522Extended::BITRATE_106KBITS, tag.ds);
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.TCL_PresenceCheck(&tag));
+}
+
+int main() {
+	const byte kbps106 = 0x00, kbps212 = 0x10, kbps424 = 0x20, kbps848 = 0x30;
+	check(MFRC522Extended::BITRATE_106KBITS, 0x77, kbps106, kbps106);
+	check(MFRC522Extended::BITRATE_212KBITS, 0x77, kbps212, kbps212);
+	check(MFRC522Extended::BITRATE_848KBITS, 0x77, kbps848, kbps848);
+	check(MFRC522Extended::BITRATE_848KBITS, 0x33, kbps424, kbps424);
+	check(MFRC522Extended::BITRATE_848KBITS, 0x71, kbps212, kbps848);	// DS 848, DR 212
+	check(MFRC522Extended::BITRATE_848KBITS, 0xD2, kbps106, kbps106);	// Same D, no common rate above 106
+	check(MFRC522Extended::BITRATE_848KBITS, 0xB6, kbps424, kbps424);	// Same D, 424 is the fastest common rate
+	// The PCD drops back to 106 kbit/s when the PICC does not follow the PPS
+	check(MFRC522Extended::BITRATE_848KBITS, 0x77, kbps106, kbps106, true);
+	checkDefaults();
+	return CHECK_RESULT();
+}
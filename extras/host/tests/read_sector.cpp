@@ -0,0 +1,34 @@
+/* MIFARE_ReadSector() reads a sector with one authentication and reports a wrong key as STATUS_AUTH_FAILED. */
+#include "MFRC522Simulator.h"
+#include "check.h"
+
+int main() {
+	MFRC522Simulator sim;
+	MFRC522 mfrc522(sim);
+	mfrc522.PCD_Init();
+	const byte uid[] = {0x01, 0x02, 0x03, 0x04};
+	MFRC522SimClassic card(uid);
+	sim.addTag(&card);
+	memset(card.block(5), 0xA5, 16);
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+
+	MFRC522::MIFARE_Key key;
+	memset(key.keyByte, 0xFF, MFRC522::MF_KEY_SIZE);
+	byte buffer[64];
+	uint16_t size = sizeof(buffer);
+	MFRC522::StatusCode blockStatus[4];
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.MIFARE_ReadSector(1, MFRC522::PICC_CMD_MF_AUTH_KEY_A, &key, &mfrc522.uid, buffer, &size, blockStatus));
+	CHECK_EQUAL(64, size);
+	CHECK_EQUAL(0xA5, buffer[16]);
+	CHECK_EQUAL(MFRC522::STATUS_OK, blockStatus[3]);
+
+	key.keyByte[0] = 0x00;
+	size = sizeof(buffer);
+	CHECK_EQUAL(MFRC522::STATUS_AUTH_FAILED, mfrc522.MIFARE_ReadSector(1, MFRC522::PICC_CMD_MF_AUTH_KEY_A, &key, &mfrc522.uid, buffer, &size, blockStatus));
+	for (byte i = 0; i < 4; i++) {
+		CHECK_EQUAL(MFRC522::STATUS_AUTH_FAILED, blockStatus[i]);
+	}
+	mfrc522.PCD_StopCrypto1();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,47 @@
+/* PICC_SelectKnown() selects a PICC of known UID without the anticollision loop. */
+#include "MFRC522Simulator.h"
+#include "check.h"
+
+int main() {
+	MFRC522Simulator sim;
+	const byte uid7[] = {0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+	const byte uid4[] = {0x11, 0x22, 0x33, 0x44};
+	MFRC522SimUltralight ultralight(uid7);
+	MFRC522SimClassic classic(uid4);
+	sim.addTag(&ultralight);
+	sim.addTag(&classic);
+	MFRC522 mfrc522(sim);
+	mfrc522.PCD_Init();
+
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+	MFRC522::Uid known = mfrc522.uid;
+	byte sak = known.sak;
+	mfrc522.PICC_HaltA();
+
+	// WUPA and one SELECT per cascade level
+	sim.resetStats();
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.PICC_SelectKnown(&known));
+	uint32_t knownFrames = sim.rfStats.frames;
+	CHECK_EQUAL(sak, known.sak);
+	CHECK_EQUAL(known.size == 7 ? 3 : 2, knownFrames);
+	mfrc522.PICC_HaltA();
+
+	byte atqa[2];
+	byte atqaSize = sizeof(atqa);
+	sim.resetStats();
+	MFRC522::StatusCode status = mfrc522.PICC_WakeupA(atqa, &atqaSize);
+	CHECK(status == MFRC522::STATUS_OK || status == MFRC522::STATUS_COLLISION);	// Both PICCs answer the WUPA
+	MFRC522::Uid full;
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.PICC_Select(&full));
+	CHECK(knownFrames < sim.rfStats.frames);
+	mfrc522.PICC_HaltA();
+
+	// A UID that is not in the field falls back to a full select
+	MFRC522::Uid absent = known;
+	absent.uidByte[absent.size - 1] ^= 0xFF;
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.PICC_SelectKnown(&absent));
+	CHECK(absent.size == 4 || absent.size == 7);
+	CHECK(memcmp(absent.uidByte, absent.size == 4 ? uid4 : uid7, absent.size) == 0);
+	return CHECK_RESULT();
+}
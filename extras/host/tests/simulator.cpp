@@ -0,0 +1,105 @@
+/* MFRC522Simulator runs the unchanged protocol code against MIFARE Classic, Ultralight and ISO-DEP PICCs. */
+#include "MFRC522Simulator.h"
+#include "MFRC522Extended.h"
+#include "check.h"
+
+int main() {
+	MFRC522Simulator sim;
+	const byte uid4[] = {0x11, 0x22, 0x33, 0x44};
+	MFRC522SimClassic classic(uid4);
+	sim.addTag(&classic);
+	MFRC522 mfrc522(sim);
+	mfrc522.PCD_Init();
+	CHECK_EQUAL(0x92, mfrc522.PCD_ReadRegister(MFRC522::VersionReg));
+
+	// Selection takes time on air and on the SPI bus
+	uint32_t start = sim.now();
+	sim.resetStats();
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+	CHECK(sim.now() - start > sim.rfStats.airTime);
+	CHECK_EQUAL(3, sim.rfStats.frames);
+	CHECK_EQUAL(4, mfrc522.uid.size);
+	CHECK(memcmp(mfrc522.uid.uidByte, uid4, 4) == 0);
+	CHECK_EQUAL(0x08, mfrc522.uid.sak);
+
+	MFRC522::MIFARE_Key key;
+	memset(key.keyByte, 0xFF, MFRC522::MF_KEY_SIZE);
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, 4, &key, &mfrc522.uid));
+	byte data[16];
+	for (byte i = 0; i < sizeof(data); i++) {
+		data[i] = i;
+	}
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.MIFARE_Write(5, data, sizeof(data)));
+	byte buffer[18];
+	byte size = sizeof(buffer);
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.MIFARE_Read(5, buffer, &size));
+	CHECK_EQUAL(18, size);
+	CHECK(memcmp(buffer, data, sizeof(data)) == 0);
+	CHECK(memcmp(classic.block(5), data, sizeof(data)) == 0);
+	mfrc522.PICC_HaltA();
+	mfrc522.PCD_StopCrypto1();
+	CHECK(!mfrc522.PICC_IsNewCardPresent());
+
+	// A wrong key times out
+	byte atqa[2];
+	byte atqaSize = sizeof(atqa);
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.PICC_WakeupA(atqa, &atqaSize));
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.PICC_Select(&mfrc522.uid));
+	key.keyByte[0] = 0x00;
+	CHECK_EQUAL(MFRC522::STATUS_TIMEOUT, mfrc522.PCD_Authenticate(MFRC522::PICC_CMD_MF_AUTH_KEY_A, 4, &key, &mfrc522.uid));
+	mfrc522.PCD_StopCrypto1();
+
+	// Two PICCs collide and are selected one after the other
+	const byte other[] = {0x91, 0x22, 0x33, 0x45};
+	MFRC522SimClassic second(other);
+	sim.addTag(&second);
+	mfrc522.PCD_AntennaOff();
+	mfrc522.PCD_AntennaOn();
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+	byte first = mfrc522.uid.uidByte[0];
+	mfrc522.PICC_HaltA();
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+	CHECK(mfrc522.uid.uidByte[0] != first);
+	mfrc522.PICC_HaltA();
+	sim.removeTag(&classic);
+	sim.removeTag(&second);
+
+	// Ultralight with a 7 byte UID
+	const byte uid7[] = {0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+	MFRC522SimUltralight ultralight(uid7);
+	sim.addTag(&ultralight);
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+	CHECK_EQUAL(7, mfrc522.uid.size);
+	CHECK_EQUAL(MFRC522::PICC_TYPE_MIFARE_UL, mfrc522.PICC_GetType(mfrc522.uid.sak));
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.MIFARE_Ultralight_Write(4, data, 4));
+	size = sizeof(buffer);
+	CHECK_EQUAL(MFRC522::STATUS_OK, mfrc522.MIFARE_Read(4, buffer, &size));
+	CHECK(memcmp(buffer, data, 4) == 0);
+	sim.removeTag(&ultralight);
+
+	// ISO/IEC 14443-4 PICC with a file for READ BINARY
+	MFRC522SimIsoDep isoDep(uid7);
+	byte file[32];
+	for (byte i = 0; i < sizeof(file); i++) {
+		file[i] = i;
+	}
+	isoDep.setFile(file, sizeof(file));
+	sim.addTag(&isoDep);
+	MFRC522Extended extended(sim);
+	extended.PCD_Init();
+	CHECK(extended.PICC_IsNewCardPresent());
+	CHECK(extended.PICC_ReadCardSerial());
+	byte apdu[] = {0x00, 0xB0, 0x00, 0x00, 0x10};
+	byte response[64];
+	byte responseLength = sizeof(response);
+	CHECK_EQUAL(MFRC522::STATUS_OK, extended.TCL_Transceive(&extended.tag, apdu, sizeof(apdu), response, &responseLength));
+	CHECK_EQUAL(18, responseLength);
+	CHECK_EQUAL(0x0F, response[15]);
+	CHECK_EQUAL(0x90, response[16]);
+	CHECK_EQUAL(MFRC522::STATUS_OK, extended.TCL_Deselect(&extended.tag));
+	return CHECK_RESULT();
+}
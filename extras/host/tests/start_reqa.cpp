@@ -0,0 +1,45 @@
+/* PICC_StartREQA_or_WUPA() and PCD_PollCommunication() find a PICC even after another one changed the bit rates. */
+#include "MFRC522Simulator.h"
+#include "check.h"
+
+// Runs REQA with the non-blocking API, returns the status of PICC_FinishREQA_or_WUPA()
+static MFRC522::StatusCode requestA(MFRC522 &mfrc522) {
+	MFRC522::StatusCode status = mfrc522.PICC_StartREQA_or_WUPA(MFRC522::PICC_CMD_REQA);
+	if (status != MFRC522::STATUS_OK) {
+		return status;
+	}
+	while ((status = mfrc522.PCD_PollCommunication()) == MFRC522::STATUS_PENDING) {
+	}
+	if (status != MFRC522::STATUS_OK) {
+		return status;
+	}
+	byte bufferATQA[2];
+	byte bufferSize = sizeof(bufferATQA);
+	return mfrc522.PICC_FinishREQA_or_WUPA(bufferATQA, &bufferSize);
+}
+
+int main() {
+	MFRC522Simulator sim;
+	MFRC522 mfrc522(sim);
+	mfrc522.PCD_Init();
+	CHECK_EQUAL(MFRC522::STATUS_TIMEOUT, requestA(mfrc522));
+
+	const byte uid[] = {0x11, 0x22, 0x33, 0x44};
+	MFRC522SimClassic card(uid);
+	sim.addTag(&card);
+	CHECK_EQUAL(MFRC522::STATUS_OK, requestA(mfrc522));
+	CHECK(mfrc522.PICC_ReadCardSerial());
+	mfrc522.PICC_HaltA();
+
+	// A reader left at 424 kbit/s by an ISO/IEC 14443-4 PICC
+	mfrc522.PCD_AntennaOff();
+	mfrc522.PCD_AntennaOn();
+	mfrc522.PCD_WriteRegister(MFRC522::TxModeReg, 0xA0);
+	mfrc522.PCD_WriteRegister(MFRC522::RxModeReg, 0xA0);
+	mfrc522.PCD_WriteRegister(MFRC522::ModWidthReg, 0x0A);
+	CHECK_EQUAL(MFRC522::STATUS_OK, requestA(mfrc522));
+	CHECK_EQUAL(0x00, mfrc522.PCD_ReadRegister(MFRC522::TxModeReg));
+	CHECK_EQUAL(0x26, mfrc522.PCD_ReadRegister(MFRC522::ModWidthReg));
+	CHECK(mfrc522.PICC_ReadCardSerial());
+	return CHECK_RESULT();
+}
@@ -0,0 +1,36 @@
+/* MFRC522Tracker reports arrival and removal, and does not leave a PICC swapped in for the tracked one ACTIVE. */
+#include "MFRC522Simulator.h"
+#include "MFRC522Tracker.h"
+#include "check.h"
+
+int main() {
+	MFRC522Simulator sim;
+	MFRC522 mfrc522(sim);
+	mfrc522.PCD_Init();
+	MFRC522Tracker tracker(mfrc522);
+	CHECK_EQUAL(MFRC522Tracker::EVENT_NONE, tracker.update());
+
+	const byte uidA[] = {0x11, 0x22, 0x33, 0x44};
+	const byte uidB[] = {0x55, 0x66, 0x77, 0x88};
+	MFRC522SimClassic cardA(uidA);
+	MFRC522SimClassic cardB(uidB);
+	sim.addTag(&cardA);
+	CHECK_EQUAL(MFRC522Tracker::CARD_ARRIVED, tracker.update());
+	CHECK_EQUAL(0x44, tracker.uid().uidByte[3]);
+	CHECK_EQUAL(MFRC522Tracker::CARD_STILL_PRESENT, tracker.update());
+	CHECK_EQUAL(MFRC522SimTag::STATE_ACTIVE, cardA.state());
+
+	// The full cascade of PICC_SelectKnown() selects card B, the probe must halt it again
+	sim.removeTag(&cardA);
+	sim.addTag(&cardB);
+	CHECK_EQUAL(MFRC522Tracker::CARD_STILL_PRESENT, tracker.update());
+	CHECK_EQUAL(MFRC522SimTag::STATE_HALT, cardB.state());
+	CHECK_EQUAL(MFRC522Tracker::CARD_REMOVED, tracker.update());
+	CHECK_EQUAL(0x44, tracker.uid().uidByte[3]);
+	CHECK_EQUAL(MFRC522Tracker::EVENT_NONE, tracker.update());	// HALT ignores the REQA of PICC_PollPresence()
+	sim.removeTag(&cardB);
+	sim.addTag(&cardB);
+	CHECK_EQUAL(MFRC522Tracker::CARD_ARRIVED, tracker.update());
+	CHECK_EQUAL(0x88, tracker.uid().uidByte[3]);
+	return CHECK_RESULT();
+}
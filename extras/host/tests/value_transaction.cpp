@@ -0,0 +1,53 @@
+/* MFRC522ValueTransaction applies a batch of value operations and verifies the result. */
+#include "MFRC522Simulator.h"
+#include "MFRC522ValueTransaction.h"
+#include "check.h"
+
+static void setValueBlock(byte *block, int32_t value, byte address) {
+	memcpy(block, &value, 4);
+	memcpy(block + 8, &value, 4);
+	for (byte i = 0; i < 4; i++) {
+		block[4 + i] = ~block[i];
+	}
+	block[12] = block[14] = address;
+	block[13] = block[15] = ~address;
+}
+
+int main() {
+	MFRC522Simulator sim;
+	MFRC522 mfrc522(sim);
+	mfrc522.PCD_Init();
+	const byte uid[] = {0x01, 0x02, 0x03, 0x04};
+	MFRC522SimClassic card(uid);
+	sim.addTag(&card);
+	card.setAccessBits(1, 0, 1, 1, 1);
+	setValueBlock(card.block(5), 1000, 5);
+	setValueBlock(card.block(6), 1000, 6);
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+	MFRC522::MIFARE_Key key;
+	memset(key.keyByte, 0xFF, MFRC522::MF_KEY_SIZE);
+	byte log[16];
+	memset(log, 0xAB, sizeof(log));
+
+	MFRC522ValueTransaction transaction(mfrc522);
+	CHECK(transaction.decrement(5, 30, 5));
+	CHECK(transaction.decrement(5, 20, 5));
+	CHECK(transaction.restore(5, 6));
+	CHECK(transaction.write(4, log));
+	transaction.expect(5, 950);
+	MFRC522ValueTransaction::Result result;
+	CHECK_EQUAL(MFRC522::STATUS_OK, transaction.commit(MFRC522::PICC_CMD_MF_AUTH_KEY_A, &key, &mfrc522.uid, &result));
+	CHECK(result.verified);
+	CHECK_EQUAL(950, result.value);
+	int32_t backup;
+	memcpy(&backup, card.block(6), 4);
+	CHECK_EQUAL(950, backup);
+	CHECK_EQUAL(0xAB, card.block(4)[0]);
+
+	// Operations on several sectors do not fit in one transaction
+	MFRC522ValueTransaction other(mfrc522);
+	CHECK(other.write(8, log));
+	CHECK(!other.write(12, log));
+	return CHECK_RESULT();
+}
@@ -0,0 +1,49 @@
+/* TCL_TransceiveExtended() answers S(WTX) requests of a PICC whose APDU takes longer than its FWT. */
+#include "MFRC522Simulator.h"
+#include "MFRC522Extended.h"
+#include "check.h"
+
+// Returns the duration of a READ BINARY in μs, 0 on failure
+static uint32_t readBinary(byte fwi, uint32_t apduTime) {
+	MFRC522Simulator sim;
+	const byte uid[] = {0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+	MFRC522SimIsoDep card(uid);
+	static byte file[64];
+	card.setFile(file, sizeof(file));
+	card.fwi = fwi;
+	card.apduTime = apduTime;
+	sim.addTag(&card);
+	MFRC522Extended mfrc522(sim);
+	mfrc522.PCD_Init();
+	CHECK(mfrc522.PICC_IsNewCardPresent());
+	CHECK(mfrc522.PICC_ReadCardSerial());
+	CHECK_EQUAL(fwi, mfrc522.tag.ats.tb1.fwi);
+
+	byte apdu[] = {0x00, 0xB0, 0x00, 0x00, 0x10};
+	byte response[32];
+	uint16_t responseLength = sizeof(response);
+	uint32_t start = sim.now();
+	MFRC522::StatusCode status = mfrc522.TCL_TransceiveExtended(&mfrc522.tag, apdu, sizeof(apdu), response, &responseLength);
+	uint32_t duration = sim.now() - start;
+	CHECK_EQUAL(MFRC522::STATUS_OK, status);
+	CHECK_EQUAL(18, responseLength);
+	CHECK_EQUAL(0x90, response[16]);
+
+	// A PICC that left the field is reported after a few FWT, not after the WTX extended time
+	card.setPresent(false);
+	responseLength = sizeof(response);
+	start = sim.now();
+	CHECK_EQUAL(MFRC522::STATUS_TIMEOUT, mfrc522.TCL_TransceiveExtended(&mfrc522.tag, apdu, sizeof(apdu), response, &responseLength));
+	CHECK(sim.now() - start < 10 * mfrc522.tag.fwt);
+	return status == MFRC522::STATUS_OK ? duration : 0;
+}
+
+int main() {
+	// Within the FWT
+	CHECK(readBinary(0, 5000) > 0);
+	// 100 ms against a FWT of about 8 ms
+	uint32_t duration = readBinary(4, 100000);
+	CHECK(duration > 90000);
+	CHECK(duration < 120000);
+	return CHECK_RESULT();
+}
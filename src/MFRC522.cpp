@@ -24,15 +24,65 @@ MFRC522::MFRC522(byte resetPowerDownPin	///< Arduino pin connected to MFRC522's
  */
 MFRC522::MFRC522(	byte chipSelectPin,		///< Arduino pin connected to MFRC522's SPI slave select input (Pin 24, NSS, active low)
 					byte resetPowerDownPin	///< Arduino pin connected to MFRC522's reset and power down input (Pin 6, NRSTPD, active low). If there is no connection from the CPU to NRSTPD, set this to UINT8_MAX. In this case, only soft reset will be used in PCD_Init().
-				) {
+				): _spiBus(chipSelectPin) {
 	_chipSelectPin = chipSelectPin;
+	_bus = nullptr;
 	_resetPowerDownPin = resetPowerDownPin;
+	_irqPin = UNUSED_PIN;
+	_batchDepth = 0;
+	_presenceArmed = false;
+	_pending.command = PCD_Idle;
+	_timerTimeout = 0;
+	_reactivateTime = 0;
+	_waterLevel = MFRC522_WATER_LEVEL;
+	_shadowValid = 0;
+	_timeouts[TIMEOUT_DEFAULT]			= 25000;	// The timeout PCD_Init() has always programmed
+	_timeouts[TIMEOUT_REQA]				= 1000;		// ATQA follows after 86μs. ISO 14443-3 also uses 1ms for the HLTA NAK window.
+	_timeouts[TIMEOUT_ANTICOLLISION]	= 1000;
+	_timeouts[TIMEOUT_AUTH]				= 5000;
+	_timeouts[TIMEOUT_READ_WRITE]		= 10000;	// MIFARE Classic and Ultralight writes need a few ms of EEPROM programming time
+	_timeouts[TIMEOUT_ISO_DEP]			= 25000;
+	_timeouts[TIMEOUT_VALUE_DATA]		= 2000;		// The operation is on the internal register, a NAK comes without EEPROM delay
+	_timeouts[TIMEOUT_FWT]				= 25000;
+} // End constructor
+
+/**
+ * Constructor.
+ * Talks to the MFRC522 through the given transport, eg a MFRC522SPIBus on another SPIClass or a MFRC522MockBus.
+ * The bus must outlive this object.
+ */
+MFRC522::MFRC522(	MFRC522Bus &bus,		///< The transport to use for register access
+					byte resetPowerDownPin	///< Arduino pin connected to MFRC522's reset and power down input (Pin 6, NRSTPD, active low). If there is no connection from the CPU to NRSTPD, set this to UINT8_MAX. In this case, only soft reset will be used in PCD_Init().
+				): MFRC522(UNUSED_PIN, resetPowerDownPin) {
+	_bus = &bus;
 } // End constructor
 
 /////////////////////////////////////////////////////////////////////////////////////
 // Basic interface functions for communicating with the MFRC522
 /////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Claims the SPI bus for a sequence of register accesses.
+ * Calls can be nested; the bus is only released by the outermost PCD_EndBatch().
+ * Every register access between PCD_BeginBatch() and PCD_EndBatch() shares one SPI transaction,
+ * so only the chip select framing required by the datasheet (section 8.1.2) remains per register.
+ * Do not hold a batch while waiting for the PICC - other devices on the bus would be blocked.
+ */
+void MFRC522::PCD_BeginBatch() {
+	if (_batchDepth++ == 0) {
+		PCD_Bus().beginTransaction();
+	}
+} // End PCD_BeginBatch()
+
+/**
+ * Releases the SPI bus claimed by PCD_BeginBatch().
+ */
+void MFRC522::PCD_EndBatch() {
+	if (_batchDepth > 0 && --_batchDepth == 0) {
+		PCD_Bus().endTransaction();
+	}
+} // End PCD_EndBatch()
+
 /**
  * Writes a byte to the specified register in the MFRC522 chip.
  * The interface is described in the datasheet section 8.1.2.
@@ -40,12 +90,25 @@ MFRC522::MFRC522(	byte chipSelectPin,		///< Arduino pin connected to MFRC522's S
 void MFRC522::PCD_WriteRegister(	PCD_Register reg,	///< The register to write to. One of the PCD_Register enums.
 									byte value			///< The value to write.
 								) {
-	SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
-	digitalWrite(_chipSelectPin, LOW);		// Select slave
-	SPI.transfer(reg);						// MSB == 0 is for writing. LSB is not used in address. Datasheet section 8.1.2.3.
-	SPI.transfer(value);
-	digitalWrite(_chipSelectPin, HIGH);		// Release slave again
-	SPI.endTransaction(); // Stop using the SPI bus
+	byte mask;
+	byte flags;
+	byte slot = PCD_ShadowSlot(reg, &mask, &flags);
+	if (slot != SHADOW_NONE) {
+		bool known = _shadowValid & ((uint32_t)1 << slot);
+		// Skip the write if the chip already holds this value and no trigger bit (StartSend) is written.
+		if (known && (flags & SHADOW_SKIP) && (value & ~mask) == 0 && (value & mask) == _shadowValue[slot]) {
+			return;
+		}
+		_shadowValue[slot] = value & mask;
+		_shadowValid |= (uint32_t)1 << slot;
+	}
+	MFRC522Bus &bus = PCD_Bus();
+	PCD_BeginBatch();
+	bus.select();				// Select slave
+	bus.transfer(reg);						// MSB == 0 is for writing. LSB is not used in address. Datasheet section 8.1.2.3.
+	bus.transfer(value);
+	bus.deselect();				// Release slave again
+	PCD_EndBatch();
 } // End PCD_WriteRegister()
 
 /**
@@ -56,16 +119,37 @@ void MFRC522::PCD_WriteRegister(	PCD_Register reg,	///< The register to write to
 									byte count,			///< The number of bytes to write to the register
 									byte *values		///< The values to write. Byte array.
 								) {
-	SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
-	digitalWrite(_chipSelectPin, LOW);		// Select slave
-	SPI.transfer(reg);						// MSB == 0 is for writing. LSB is not used in address. Datasheet section 8.1.2.3.
+	byte mask;
+	byte flags;
+	byte slot = PCD_ShadowSlot(reg, &mask, &flags);
+	if (slot != SHADOW_NONE) {
+		_shadowValid &= ~((uint32_t)1 << slot);	// Not used for configuration registers, forget the value
+	}
+	MFRC522Bus &bus = PCD_Bus();
+	PCD_BeginBatch();
+	bus.select();				// Select slave
+	bus.transfer(reg);						// MSB == 0 is for writing. LSB is not used in address. Datasheet section 8.1.2.3.
 	for (byte index = 0; index < count; index++) {
-		SPI.transfer(values[index]);
+		bus.transfer(values[index]);
 	}
-	digitalWrite(_chipSelectPin, HIGH);		// Release slave again
-	SPI.endTransaction(); // Stop using the SPI bus
+	bus.deselect();				// Release slave again
+	PCD_EndBatch();
 } // End PCD_WriteRegister()
 
+/**
+ * Writes a sequence of bytes to different registers in one SPI transaction.
+ * The writes are performed in the order given.
+ */
+void MFRC522::PCD_WriteRegisters(	byte count,						///< The number of entries in writes
+									const PCD_RegisterWrite *writes	///< The register/value pairs to write.
+								) {
+	PCD_BeginBatch();
+	for (byte index = 0; index < count; index++) {
+		PCD_WriteRegister(writes[index].reg, writes[index].value);
+	}
+	PCD_EndBatch();
+} // End PCD_WriteRegisters()
+
 /**
  * Reads a byte from the specified register in the MFRC522 chip.
  * The interface is described in the datasheet section 8.1.2.
@@ -73,12 +157,23 @@ void MFRC522::PCD_WriteRegister(	PCD_Register reg,	///< The register to write to
 byte MFRC522::PCD_ReadRegister(	PCD_Register reg	///< The register to read from. One of the PCD_Register enums.
 								) {
 	byte value;
-	SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
-	digitalWrite(_chipSelectPin, LOW);			// Select slave
-	SPI.transfer(0x80 | reg);					// MSB == 1 is for reading. LSB is not used in address. Datasheet section 8.1.2.3.
-	value = SPI.transfer(0);					// Read the value back. Send 0 to stop reading.
-	digitalWrite(_chipSelectPin, HIGH);			// Release slave again
-	SPI.endTransaction(); // Stop using the SPI bus
+	byte mask;
+	byte flags;
+	byte slot = PCD_ShadowSlot(reg, &mask, &flags);
+	if (slot != SHADOW_NONE && (flags & SHADOW_READ) && (_shadowValid & ((uint32_t)1 << slot))) {
+		return _shadowValue[slot];	// Only the host changes this register, no need to ask the chip
+	}
+	MFRC522Bus &bus = PCD_Bus();
+	PCD_BeginBatch();
+	bus.select();					// Select slave
+	bus.transfer(0x80 | reg);					// MSB == 1 is for reading. LSB is not used in address. Datasheet section 8.1.2.3.
+	value = bus.transfer(0);					// Read the value back. Send 0 to stop reading.
+	bus.deselect();					// Release slave again
+	PCD_EndBatch();
+	if (slot != SHADOW_NONE) {
+		_shadowValue[slot] = value & mask;
+		_shadowValid |= (uint32_t)1 << slot;
+	}
 	return value;
 } // End PCD_ReadRegister()
 
@@ -97,28 +192,52 @@ void MFRC522::PCD_ReadRegister(	PCD_Register reg,	///< The register to read from
 	//Serial.print(F("Reading ")); 	Serial.print(count); Serial.println(F(" bytes from register."));
 	byte address = 0x80 | reg;				// MSB == 1 is for reading. LSB is not used in address. Datasheet section 8.1.2.3.
 	byte index = 0;							// Index in values array.
-	SPI.beginTransaction(SPISettings(MFRC522_SPICLOCK, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
-	digitalWrite(_chipSelectPin, LOW);		// Select slave
+	MFRC522Bus &bus = PCD_Bus();
+	PCD_BeginBatch();
+	bus.select();				// Select slave
 	count--;								// One read is performed outside of the loop
-	SPI.transfer(address);					// Tell MFRC522 which address we want to read
+	bus.transfer(address);					// Tell MFRC522 which address we want to read
 	if (rxAlign) {		// Only update bit positions rxAlign..7 in values[0]
 		// Create bit mask for bit positions rxAlign..7
 		byte mask = (0xFF << rxAlign) & 0xFF;
 		// Read value and tell that we want to read the same address again.
-		byte value = SPI.transfer(address);
+		byte value = bus.transfer(address);
 		// Apply mask to both current value of values[0] and the new data in value.
 		values[0] = (values[0] & ~mask) | (value & mask);
 		index++;
 	}
 	while (index < count) {
-		values[index] = SPI.transfer(address);	// Read value and tell that we want to read the same address again.
+		values[index] = bus.transfer(address);	// Read value and tell that we want to read the same address again.
 		index++;
 	}
-	values[index] = SPI.transfer(0);			// Read the final byte. Send 0 to stop reading.
-	digitalWrite(_chipSelectPin, HIGH);			// Release slave again
-	SPI.endTransaction(); // Stop using the SPI bus
+	values[index] = bus.transfer(0);			// Read the final byte. Send 0 to stop reading.
+	bus.deselect();					// Release slave again
+	PCD_EndBatch();
 } // End PCD_ReadRegister()
 
+/**
+ * Reads a number of different registers in the MFRC522 chip with a single chip select assertion.
+ * The SPI read sequence in datasheet section 8.1.2.1 allows a new address to be sent with every byte clocked out.
+ */
+void MFRC522::PCD_ReadRegisters(	byte count,					///< The number of registers to read
+									const PCD_Register *regs,	///< The registers to read from. PCD_Register enums.
+									byte *values				///< Byte array to store the values in, values[i] is read from regs[i].
+								) {
+	if (count == 0) {
+		return;
+	}
+	MFRC522Bus &bus = PCD_Bus();
+	PCD_BeginBatch();
+	bus.select();				// Select slave
+	bus.transfer(0x80 | regs[0]);			// MSB == 1 is for reading. Tell MFRC522 the first address we want to read
+	for (byte index = 1; index < count; index++) {
+		values[index - 1] = bus.transfer(0x80 | regs[index]);	// Read value and tell the next address we want to read.
+	}
+	values[count - 1] = bus.transfer(0);	// Read the final byte. Send 0 to stop reading.
+	bus.deselect();				// Release slave again
+	PCD_EndBatch();
+} // End PCD_ReadRegisters()
+
 /**
  * Sets the bits given in mask in register reg.
  */
@@ -126,8 +245,10 @@ void MFRC522::PCD_SetRegisterBitMask(	PCD_Register reg,	///< The register to upd
 										byte mask			///< The bits to set.
 									) { 
 	byte tmp;
-	tmp = PCD_ReadRegister(reg);
+	PCD_BeginBatch();
+	tmp = PCD_ShadowedValue(reg);
 	PCD_WriteRegister(reg, tmp | mask);			// set bit mask
+	PCD_EndBatch();
 } // End PCD_SetRegisterBitMask()
 
 /**
@@ -137,13 +258,81 @@ void MFRC522::PCD_ClearRegisterBitMask(	PCD_Register reg,	///< The register to u
 										byte mask			///< The bits to clear.
 									  ) {
 	byte tmp;
-	tmp = PCD_ReadRegister(reg);
+	PCD_BeginBatch();
+	tmp = PCD_ShadowedValue(reg);
 	PCD_WriteRegister(reg, tmp & (~mask));		// clear bit mask
+	PCD_EndBatch();
 } // End PCD_ClearRegisterBitMask()
 
+/**
+ * Returns the host-owned bits of a register for a read-modify-write.
+ * Shadowed registers are served from the shadow, so the update costs a single write.
+ * Bits the chip changes by itself (eg CollPos in CollReg, MFCrypto1On in Status2Reg) are returned as 0.
+ * 
+ * @return The register value.
+ */
+byte MFRC522::PCD_ShadowedValue(	PCD_Register reg	///< The register to read. One of the PCD_Register enums.
+								) {
+	byte mask;
+	byte flags;
+	byte slot = PCD_ShadowSlot(reg, &mask, &flags);
+	if (slot == SHADOW_NONE) {
+		return PCD_ReadRegister(reg);
+	}
+	if (!(_shadowValid & ((uint32_t)1 << slot))) {
+		PCD_ReadRegister(reg);	// Loads the shadow
+	}
+	return _shadowValue[slot];
+} // End PCD_ShadowedValue()
 
 /**
- * Use the CRC coprocessor in the MFRC522 to calculate a CRC_A.
+ * Looks up the shadow slot of a host-owned configuration register.
+ * Volatile command and status registers (CommandReg, the IRQ, error, FIFO and timer value registers) are never shadowed.
+ * 
+ * @return The slot index in _shadowValue[], or SHADOW_NONE.
+ */
+byte MFRC522::PCD_ShadowSlot(	PCD_Register reg,	///< The register to look up. One of the PCD_Register enums.
+								byte *mask,			///< Out: The bits owned by the host.
+								byte *flags			///< Out: SHADOW_READ and/or SHADOW_SKIP.
+							) {
+	*mask = 0xFF;
+	*flags = SHADOW_READ | SHADOW_SKIP;
+	switch (reg) {
+		case ComIEnReg:			return 0;
+		case DivIEnReg:			return 1;
+		case WaterLevelReg:		return 2;
+		case BitFramingReg:		*mask = 0x7F;								return 3;	// StartSend is a trigger and always written
+		case CollReg:			*mask = 0x80;	*flags = SHADOW_SKIP;		return 4;	// CollPos is status
+		case Status2Reg:		*mask = 0xC0;	*flags = 0;					return 5;	// MFCrypto1On is set by the chip, writes must not be skipped
+		case ModeReg:			return 6;
+		case TxModeReg:			return 7;
+		case RxModeReg:			return 8;
+		case TxControlReg:		return 9;
+		case TxASKReg:			return 10;
+		case ModWidthReg:		return 11;
+		case RFCfgReg:			return 12;
+		case TModeReg:			return 13;
+		case TPrescalerReg:		return 14;
+		case TReloadRegH:		return 15;
+		case TReloadRegL:		return 16;
+		default:				return SHADOW_NONE;
+	}
+} // End PCD_ShadowSlot()
+
+/**
+ * Forgets all shadowed register values.
+ * Call this when the MFRC522 registers were changed behind the driver's back, eg by a reset through the NRSTPD pin
+ * or by another MFRC522 instance using the same chip. PCD_Reset() and PCD_Init() do this themselves.
+ */
+void MFRC522::PCD_InvalidateRegisterCache() {
+	_shadowValid = 0;
+	_timerTimeout = 0;
+	_presenceArmed = false;
+} // End PCD_InvalidateRegisterCache()
+
+
+/**
+ * Calculates a CRC_A, with the CRC coprocessor in the MFRC522 or in software as selected by MFRC522_CRC_MODE.
  * 
  * @return STATUS_OK on success, STATUS_??? otherwise.
  */
@@ -151,31 +340,122 @@ MFRC522::StatusCode MFRC522::PCD_CalculateCRC(	byte *data,		///< In: Pointer to
 												byte length,	///< In: The number of bytes to transfer.
 												byte *result	///< Out: Pointer to result buffer. Result is written to result[0..1], low byte first.
 					 ) {
+#if MFRC522_CRC_MODE != MFRC522_CRC_HARDWARE
+	uint16_t crc = CRC_Calculate(data, length);
+	result[0] = crc & 0xFF;
+	result[1] = crc >> 8;
+	return STATUS_OK;
+#else
+	_presenceArmed = false;
+	PCD_BeginBatch();
 	PCD_WriteRegister(CommandReg, PCD_Idle);		// Stop any active command.
 	PCD_WriteRegister(DivIrqReg, 0x04);				// Clear the CRCIRq interrupt request bit
+	if (_irqPin != UNUSED_PIN) {
+		PCD_WriteRegister(ComIEnReg, 0x80);			// IRqInv=1 (IRQ pin active low), no ComIrqReg sources
+		PCD_WriteRegister(DivIEnReg, 0x84);			// IRQPushPull=1, CRCIEn=1
+	}
 	PCD_WriteRegister(FIFOLevelReg, 0x80);			// FlushBuffer = 1, FIFO initialization
 	PCD_WriteRegister(FIFODataReg, length, data);	// Write data to the FIFO
 	PCD_WriteRegister(CommandReg, PCD_CalcCRC);		// Start the calculation
+	PCD_EndBatch();
 	
-	// Wait for the CRC calculation to complete. Each iteration of the while-loop takes 17.73μs.
-	// TODO check/modify for other architectures than Arduino Uno 16bit
-
-	// Wait for the CRC calculation to complete. Each iteration of the while-loop takes 17.73us.
-	for (uint16_t i = 5000; i > 0; i--) {
+	// In interrupt mode wait for the IRQ pin, the DivIrqReg read below then succeeds at once.
+	// The coprocessor needs a few μs per byte, so 5ms means communication with the MFRC522 is down.
+	const uint32_t timeout = 5000;
+	if (_irqPin != UNUSED_PIN && !PCD_WaitForIrqPin(timeout)) {
+		return STATUS_TIMEOUT;
+	}
+	
+	// Wait for the CRC calculation to complete.
+	const uint32_t start = PCD_Bus().now();
+	do {
 		// DivIrqReg[7..0] bits are: Set2 reserved reserved MfinActIRq reserved CRCIRq reserved reserved
 		byte n = PCD_ReadRegister(DivIrqReg);
 		if (n & 0x04) {									// CRCIRq bit set - calculation done
+			const PCD_Register crcRegs[] = {CRCResultRegL, CRCResultRegH};
+			PCD_BeginBatch();
 			PCD_WriteRegister(CommandReg, PCD_Idle);	// Stop calculating CRC for new content in the FIFO.
 			// Transfer the result from the registers to the result buffer
-			result[0] = PCD_ReadRegister(CRCResultRegL);
-			result[1] = PCD_ReadRegister(CRCResultRegH);
+			PCD_ReadRegisters(2, crcRegs, result);
+			PCD_EndBatch();
 			return STATUS_OK;
 		}
-	}
-	// 89ms passed and nothing happend. Communication with the MFRC522 might be down.
+	} while (PCD_Bus().now() - start < timeout);
+	// 5ms passed and nothing happend. Communication with the MFRC522 might be down.
 	return STATUS_TIMEOUT;
+#endif
 } // End PCD_CalculateCRC()
 
+#if MFRC522_CRC_MODE == MFRC522_CRC_TABLE
+// CRC_A of each byte value, polynomial x^16 + x^12 + x^5 + 1 in LSB first order (0x8408)
+static const uint16_t crcTable[256] PROGMEM = {
+	0x0000, 0x1189, 0x2312, 0x329B, 0x4624, 0x57AD, 0x6536, 0x74BF,
+	0x8C48, 0x9DC1, 0xAF5A, 0xBED3, 0xCA6C, 0xDBE5, 0xE97E, 0xF8F7,
+	0x1081, 0x0108, 0x3393, 0x221A, 0x56A5, 0x472C, 0x75B7, 0x643E,
+	0x9CC9, 0x8D40, 0xBFDB, 0xAE52, 0xDAED, 0xCB64, 0xF9FF, 0xE876,
+	0x2102, 0x308B, 0x0210, 0x1399, 0x6726, 0x76AF, 0x4434, 0x55BD,
+	0xAD4A, 0xBCC3, 0x8E58, 0x9FD1, 0xEB6E, 0xFAE7, 0xC87C, 0xD9F5,
+	0x3183, 0x200A, 0x1291, 0x0318, 0x77A7, 0x662E, 0x54B5, 0x453C,
+	0xBDCB, 0xAC42, 0x9ED9, 0x8F50, 0xFBEF, 0xEA66, 0xD8FD, 0xC974,
+	0x4204, 0x538D, 0x6116, 0x709F, 0x0420, 0x15A9, 0x2732, 0x36BB,
+	0xCE4C, 0xDFC5, 0xED5E, 0xFCD7, 0x8868, 0x99E1, 0xAB7A, 0xBAF3,
+	0x5285, 0x430C, 0x7197, 0x601E, 0x14A1, 0x0528, 0x37B3, 0x263A,
+	0xDECD, 0xCF44, 0xFDDF, 0xEC56, 0x98E9, 0x8960, 0xBBFB, 0xAA72,
+	0x6306, 0x728F, 0x4014, 0x519D, 0x2522, 0x34AB, 0x0630, 0x17B9,
+	0xEF4E, 0xFEC7, 0xCC5C, 0xDDD5, 0xA96A, 0xB8E3, 0x8A78, 0x9BF1,
+	0x7387, 0x620E, 0x5095, 0x411C, 0x35A3, 0x242A, 0x16B1, 0x0738,
+	0xFFCF, 0xEE46, 0xDCDD, 0xCD54, 0xB9EB, 0xA862, 0x9AF9, 0x8B70,
+	0x8408, 0x9581, 0xA71A, 0xB693, 0xC22C, 0xD3A5, 0xE13E, 0xF0B7,
+	0x0840, 0x19C9, 0x2B52, 0x3ADB, 0x4E64, 0x5FED, 0x6D76, 0x7CFF,
+	0x9489, 0x8500, 0xB79B, 0xA612, 0xD2AD, 0xC324, 0xF1BF, 0xE036,
+	0x18C1, 0x0948, 0x3BD3, 0x2A5A, 0x5EE5, 0x4F6C, 0x7DF7, 0x6C7E,
+	0xA50A, 0xB483, 0x8618, 0x9791, 0xE32E, 0xF2A7, 0xC03C, 0xD1B5,
+	0x2942, 0x38CB, 0x0A50, 0x1BD9, 0x6F66, 0x7EEF, 0x4C74, 0x5DFD,
+	0xB58B, 0xA402, 0x9699, 0x8710, 0xF3AF, 0xE226, 0xD0BD, 0xC134,
+	0x39C3, 0x284A, 0x1AD1, 0x0B58, 0x7FE7, 0x6E6E, 0x5CF5, 0x4D7C,
+	0xC60C, 0xD785, 0xE51E, 0xF497, 0x8028, 0x91A1, 0xA33A, 0xB2B3,
+	0x4A44, 0x5BCD, 0x6956, 0x78DF, 0x0C60, 0x1DE9, 0x2F72, 0x3EFB,
+	0xD68D, 0xC704, 0xF59F, 0xE416, 0x90A9, 0x8120, 0xB3BB, 0xA232,
+	0x5AC5, 0x4B4C, 0x79D7, 0x685E, 0x1CE1, 0x0D68, 0x3FF3, 0x2E7A,
+	0xE70E, 0xF687, 0xC41C, 0xD595, 0xA12A, 0xB0A3, 0x8238, 0x93B1,
+	0x6B46, 0x7ACF, 0x4854, 0x59DD, 0x2D62, 0x3CEB, 0x0E70, 0x1FF9,
+	0xF78F, 0xE606, 0xD49D, 0xC514, 0xB1AB, 0xA022, 0x92B9, 0x8330,
+	0x7BC7, 0x6A4E, 0x58D5, 0x495C, 0x3DE3, 0x2C6A, 0x1EF1, 0x0F78,
+};
+#elif MFRC522_CRC_MODE == MFRC522_CRC_NIBBLE
+// CRC_A of each 4 bit value, polynomial x^16 + x^12 + x^5 + 1 in LSB first order (0x8408)
+static const uint16_t crcTable[16] PROGMEM = {
+	0x0000, 0x1081, 0x2102, 0x3183, 0x4204, 0x5285, 0x6306, 0x7387,
+	0x8408, 0x9489, 0xA50A, 0xB58B, 0xC60C, 0xD68D, 0xE70E, 0xF78F,
+};
+#endif
+
+/**
+ * Calculates a CRC_A (ISO/IEC 14443-3 Annex B) in software, without accessing the MFRC522.
+ * A frame with the CRC_A appended gives 0 when checked with this function.
+ * 
+ * @return the CRC_A, to be sent low byte first.
+ */
+uint16_t MFRC522::CRC_Calculate(	const byte *data,	///< In: The data to protect.
+									uint16_t length,	///< In: The number of bytes in data.
+									uint16_t crc		///< In: The initial value, 0x6363 for CRC_A. Pass a previous result to continue a calculation.
+								) {
+	for (uint16_t i = 0; i < length; i++) {
+#if MFRC522_CRC_MODE == MFRC522_CRC_NIBBLE
+		crc = (crc >> 4) ^ pgm_read_word(&crcTable[(crc ^ data[i]) & 0x0F]);
+		crc = (crc >> 4) ^ pgm_read_word(&crcTable[(crc ^ (data[i] >> 4)) & 0x0F]);
+#elif MFRC522_CRC_MODE == MFRC522_CRC_TABLE
+		crc = (crc >> 8) ^ pgm_read_word(&crcTable[(crc ^ data[i]) & 0xFF]);
+#else
+		crc ^= data[i];
+		for (byte bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x0001) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+		}
+#endif
+	}
+	return crc;
+} // End CRC_Calculate()
+
 
 /////////////////////////////////////////////////////////////////////////////////////
 // Functions for manipulating the MFRC522
@@ -188,8 +468,7 @@ void MFRC522::PCD_Init() {
 	bool hardReset = false;
 
 	// Set the chipSelectPin as digital output, do not select the slave yet
-	pinMode(_chipSelectPin, OUTPUT);
-	digitalWrite(_chipSelectPin, HIGH);
+	PCD_Bus().begin();
 	
 	// If a valid pin number has been set, pull device out of power down / reset state.
 	if (_resetPowerDownPin != UNUSED_PIN) {
@@ -204,6 +483,7 @@ void MFRC522::PCD_Init() {
 			// Section 8.8.2 in the datasheet says the oscillator start-up time is the start up time of the crystal + 37,74μs. Let us be generous: 50ms.
 			delay(50);
 			hardReset = true;
+			PCD_InvalidateRegisterCache();
 		}
 	}
 
@@ -211,6 +491,7 @@ void MFRC522::PCD_Init() {
 		PCD_Reset();
 	}
 	
+	PCD_BeginBatch();
 	// Reset baud rates
 	PCD_WriteRegister(TxModeReg, 0x00);
 	PCD_WriteRegister(RxModeReg, 0x00);
@@ -224,10 +505,12 @@ void MFRC522::PCD_Init() {
 	PCD_WriteRegister(TPrescalerReg, 0xA9);		// TPreScaler = TModeReg[3..0]:TPrescalerReg, ie 0x0A9 = 169 => f_timer=40kHz, ie a timer period of 25μs.
 	PCD_WriteRegister(TReloadRegH, 0x03);		// Reload timer with 0x3E8 = 1000, ie 25ms before timeout.
 	PCD_WriteRegister(TReloadRegL, 0xE8);
+	_timerTimeout = 25000;						// Commands reprogram the timer for their PCD_TimeoutClass as needed
 	
 	PCD_WriteRegister(TxASKReg, 0x40);		// Default 0x00. Force a 100 % ASK modulation independent of the ModGsPReg register setting
 	PCD_WriteRegister(ModeReg, 0x3D);		// Default 0x3F. Set the preset value for the CRC coprocessor for the CalcCRC command to 0x6363 (ISO 14443-3 part 6.2.4)
 	PCD_AntennaOn();						// Enable the antenna driver pins TX1 and TX2 (they were disabled by the reset)
+	PCD_EndBatch();
 } // End PCD_Init()
 
 /**
@@ -245,6 +528,7 @@ void MFRC522::PCD_Init(	byte chipSelectPin,		///< Arduino pin connected to MFRC5
 						byte resetPowerDownPin	///< Arduino pin connected to MFRC522's reset and power down input (Pin 6, NRSTPD, active low)
 					) {
 	_chipSelectPin = chipSelectPin;
+	_spiBus.setChipSelectPin(chipSelectPin);
 	_resetPowerDownPin = resetPowerDownPin; 
 	// Set the chipSelectPin as digital output, do not select the slave yet
 	PCD_Init();
@@ -255,13 +539,14 @@ void MFRC522::PCD_Init(	byte chipSelectPin,		///< Arduino pin connected to MFRC5
  */
 void MFRC522::PCD_Reset() {
 	PCD_WriteRegister(CommandReg, PCD_SoftReset);	// Issue the SoftReset command.
+	PCD_InvalidateRegisterCache();					// All registers are back at their reset values
 	// The datasheet does not mention how long the SoftRest command takes to complete.
 	// But the MFRC522 might have been in soft power-down mode (triggered by bit 4 of CommandReg) 
 	// Section 8.8.2 in the datasheet says the oscillator start-up time is the start up time of the crystal + 37,74μs. Let us be generous: 50ms.
 	uint8_t count = 0;
 	do {
 		// Wait for the PowerDown bit in CommandReg to be cleared (max 3x50ms)
-		delay(50);
+		PCD_Bus().wait(50000);
 	} while ((PCD_ReadRegister(CommandReg) & (1 << 4)) && (++count) < 3);
 } // End PCD_Reset()
 
@@ -306,6 +591,103 @@ void MFRC522::PCD_SetAntennaGain(byte mask) {
 	}
 } // End PCD_SetAntennaGain()
 
+/**
+ * Selects interrupt mode for command completion.
+ * With an Arduino pin connected to the MFRC522's IRQ output (Pin 23) the driver programs ComIEnReg/DivIEnReg
+ * for each command and waits for the pin instead of polling ComIrqReg and DivIrqReg over SPI.
+ * The IRQ output is configured as active low push-pull. Pass UNUSED_PIN to return to polling.
+ */
+void MFRC522::PCD_SetIrqPin(	byte irqPin	///< Arduino pin connected to MFRC522's IRQ output, or UNUSED_PIN
+							) {
+	_irqPin = irqPin;
+	if (_irqPin != UNUSED_PIN) {
+		pinMode(_irqPin, INPUT_PULLUP);
+	}
+	else {
+		PCD_WriteRegister(ComIEnReg, 0x80);		// Reset value, no interrupt sources on the IRQ pin
+		PCD_WriteRegister(DivIEnReg, 0x00);
+	}
+} // End PCD_SetIrqPin()
+
+/**
+ * Waits for the IRQ pin to go low without touching the SPI bus.
+ * 
+ * @return true if the pin was asserted, false on timeout.
+ */
+bool MFRC522::PCD_WaitForIrqPin(	uint32_t timeoutUs	///< Maximum time to wait in μs.
+								) {
+	const uint32_t start = PCD_Bus().now();
+	while (digitalRead(_irqPin) != LOW) {
+		if (PCD_Bus().now() - start > timeoutUs) {
+			return false;
+		}
+		yield();	// Let the core run background tasks (WiFi stack on ESP8266/ESP32) while the PICC answers
+	}
+	return true;
+} // End PCD_WaitForIrqPin()
+
+/**
+ * Sets how long the PCD waits for a PICC answer for one class of commands.
+ * The timeout is counted by the MFRC522 timer from the end of the transmission, so it does not depend on the host CPU speed.
+ * Short timeouts make polling an empty field and trying wrong keys fast; too short values make slow PICCs fail.
+ */
+void MFRC522::PCD_SetTimeout(	PCD_TimeoutClass timeoutClass,	///< The command class. One of the PCD_TimeoutClass enums.
+								uint32_t timeoutUs				///< Timeout in μs, 25μs resolution up to 1.6s, 604μs resolution beyond.
+							) {
+	if (timeoutClass < TIMEOUT_CLASS_COUNT && timeoutUs > 0) {
+		_timeouts[timeoutClass] = timeoutUs;
+	}
+} // End PCD_SetTimeout()
+
+/**
+ * Returns the timeout set for a class of commands.
+ * 
+ * @return Timeout in μs.
+ */
+uint32_t MFRC522::PCD_GetTimeout(	PCD_TimeoutClass timeoutClass	///< The command class. One of the PCD_TimeoutClass enums.
+								) {
+	return timeoutClass < TIMEOUT_CLASS_COUNT ? _timeouts[timeoutClass] : 0;
+} // End PCD_GetTimeout()
+
+/**
+ * Sets the FIFO water level of PCD_TransceiveStream(), 1 to 32 bytes.
+ * It is the margin the host has to refill or drain the FIFO after the LoAlert or HiAlert: at 106 kbit/s the
+ * default of 16 bytes leaves 1.3ms, at 848 kbit/s 170μs. Raise it if interrupts or other devices on the bus delay
+ * the host longer; lower values need fewer SPI transactions per frame.
+ */
+void MFRC522::PCD_SetWaterLevel(	byte level	///< FIFO level for LoAlert and free space for HiAlert in bytes.
+								) {
+	_waterLevel = level < 1 ? 1 : (level > FIFO_SIZE / 2 ? FIFO_SIZE / 2 : level);
+} // End PCD_SetWaterLevel()
+
+/**
+ * Programs the MFRC522 timer that signals TimerIRq when no PICC answer arrives.
+ * The registers are only written when the timeout differs from the one programmed last.
+ * f_timer = 13.56 MHz / (2*TPreScaler+1) where TPreScaler = [TPrescaler_Hi:TPrescaler_Lo].
+ */
+void MFRC522::PCD_ProgramTimer(	uint32_t timeoutUs	///< Timeout in μs.
+							) {
+	if (timeoutUs == _timerTimeout) {
+		return;
+	}
+	uint16_t prescaler = 0x0A9;						// 169 => f_timer=40kHz, ie a timer period of 25μs.
+	uint32_t reload = (timeoutUs + 24) / 25;
+	if (reload > 0xFFFF) {
+		prescaler = 0xFFF;							// 4095 => a timer period of 604μs, up to 39s.
+		reload = (timeoutUs + 603) / 604;
+		if (reload > 0xFFFF) {
+			reload = 0xFFFF;
+		}
+	}
+	PCD_BeginBatch();
+	PCD_WriteRegister(TModeReg, 0x80 | (prescaler >> 8));	// TAuto=1; timer starts automatically at the end of the transmission
+	PCD_WriteRegister(TPrescalerReg, prescaler & 0xFF);
+	PCD_WriteRegister(TReloadRegH, reload >> 8);
+	PCD_WriteRegister(TReloadRegL, reload & 0xFF);
+	PCD_EndBatch();
+	_timerTimeout = timeoutUs;
+} // End PCD_ProgramTimer()
+
 /**
  * Performs a self-test of the MFRC522
  * See 16.1.1 in http://www.nxp.com/documents/data_sheet/MFRC522.pdf
@@ -399,24 +781,29 @@ bool MFRC522::PCD_PerformSelfTest() {
 //For more details about power control, refer to the datasheet - page 33 (8.6)
 
 void MFRC522::PCD_SoftPowerDown(){//Note : Only soft power down mode is available throught software
-	byte val = PCD_ReadRegister(CommandReg); // Read state of the command register 
-	val |= (1<<4);// set PowerDown bit ( bit 4 ) to 1 
-	PCD_WriteRegister(CommandReg, val);//write new value to the command register
+	_presenceArmed = false;
+	PCD_WriteRegister(CommandReg, (1<<4) | PCD_NoCmdChange);// set PowerDown bit ( bit 4 ) to 1, keep the command
 }
 
-void MFRC522::PCD_SoftPowerUp(){
-	byte val = PCD_ReadRegister(CommandReg); // Read state of the command register 
-	val &= ~(1<<4);// set PowerDown bit ( bit 4 ) to 0 
-	PCD_WriteRegister(CommandReg, val);//write new value to the command register
+/**
+ * Leaves soft power-down and waits until the oscillator runs, ie until the MFRC522 clears the PowerDown bit.
+ * 
+ * @return STATUS_OK on success, STATUS_TIMEOUT if the MFRC522 did not wake up within 500ms.
+ */
+MFRC522::StatusCode MFRC522::PCD_SoftPowerUp(	uint32_t *wakeUpTime	///< Out: The time in μs the wake up took, nullptr if not needed.
+											) {
+	const uint32_t start = PCD_Bus().now();
+	PCD_WriteRegister(CommandReg, PCD_NoCmdChange);// set PowerDown bit ( bit 4 ) to 0, keep the command
 	// wait until PowerDown bit is cleared (this indicates end of wake up procedure) 
-	const uint32_t timeout = (uint32_t)millis() + 500;// create timer for timeout (just in case) 
-	
-	while(millis()<=timeout){ // set timeout to 500 ms 
-		val = PCD_ReadRegister(CommandReg);// Read state of the command register
-		if(!(val & (1<<4))){ // if powerdown bit is 0 
-			break;// wake up procedure is finished 
+	do {
+		if (!(PCD_ReadRegister(CommandReg) & (1<<4))) { // if powerdown bit is 0 
+			if (wakeUpTime) {
+				*wakeUpTime = PCD_Bus().now() - start;
+			}
+			return STATUS_OK; // wake up procedure is finished 
 		}
-	}
+	} while (PCD_Bus().now() - start < 500000); // timeout 500 ms, just in case
+	return STATUS_TIMEOUT;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -435,15 +822,17 @@ MFRC522::StatusCode MFRC522::PCD_TransceiveData(	byte *sendData,		///< Pointer t
 													byte *backLen,		///< In: Max number of bytes to write to *backData. Out: The number of bytes returned.
 													byte *validBits,	///< In/Out: The number of valid bits in the last byte. 0 for 8 valid bits. Default nullptr.
 													byte rxAlign,		///< In: Defines the bit position in backData[0] for the first bit received. Default 0.
-													bool checkCRC		///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+													bool checkCRC,		///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+													PCD_TimeoutClass timeoutClass	///< In: Selects how long to wait for the PICC. Default TIMEOUT_DEFAULT.
 								 ) {
 	byte waitIRq = 0x30;		// RxIRq and IdleIRq
-	return PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, sendData, sendLen, backData, backLen, validBits, rxAlign, checkCRC);
+	return PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, sendData, sendLen, backData, backLen, validBits, rxAlign, checkCRC, timeoutClass);
 } // End PCD_TransceiveData()
 
 /**
  * Transfers data to the MFRC522 FIFO, executes a command, waits for completion and transfers data back from the FIFO.
  * CRC validation can only be done if backData and backLen are specified.
+ * This is a blocking wrapper around PCD_StartCommunication(), PCD_PollCommunication() and PCD_FinishCommunication().
  *
  * @return STATUS_OK on success, STATUS_??? otherwise.
  */
@@ -455,44 +844,295 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(	byte command,		///< The co
 														byte *backLen,		///< In: Max number of bytes to write to *backData. Out: The number of bytes returned.
 														byte *validBits,	///< In/Out: The number of valid bits in the last byte. 0 for 8 valid bits.
 														byte rxAlign,		///< In: Defines the bit position in backData[0] for the first bit received. Default 0.
-														bool checkCRC		///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+														bool checkCRC,		///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+														PCD_TimeoutClass timeoutClass	///< In: Selects how long to wait for the PICC. Default TIMEOUT_DEFAULT.
 									 ) {
+	MFRC522::StatusCode status = PCD_StartCommunication(command, waitIRq, sendData, sendLen, validBits ? *validBits : 0, rxAlign, timeoutClass);
+	if (status != STATUS_OK) {
+		return status;
+	}
+	
+	// Wait for the command to complete.
+	status = PCD_WaitForCommunication();
+	if (status != STATUS_OK) {
+		return status;
+	}
+	
+	return PCD_FinishCommunication(backData, backLen, validBits, checkCRC);
+} // End PCD_CommunicateWithPICC()
+
+/**
+ * Executes the Transceive command with frames that do not fit into the 64 byte FIFO, in both directions.
+ * The FIFO is refilled while the frame is sent and drained while the answer is received: LoAlert signals that
+ * no more than the water level of bytes are left to send, HiAlert that no more than the water level of bytes
+ * are free. See PCD_SetWaterLevel(). In between the host does not poll the MFRC522. In interrupt mode
+ * (PCD_SetIrqPin()) it waits for the IRQ pin, otherwise for the time the bytes take at the bit rate, which is
+ * 85μs per byte at 106 kbit/s. A 924 byte FAST_READ answer needs about a hundred short SPI transactions instead of
+ * polling the MFRC522 all the time.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_TransceiveStream(	byte *sendData,		///< Pointer to the data to transfer to the PICC.
+													uint16_t sendLen,	///< Number of bytes to transfer to the PICC.
+													byte *backData,		///< Pointer to the buffer for the answer.
+													uint16_t *backLen,	///< In: Max number of bytes to write to *backData. Out: The number of bytes returned.
+													byte *validBits,	///< Out: The number of valid bits in the last byte. 0 for 8 valid bits. nullptr if not needed.
+													bool checkCRC,		///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+													PCD_TimeoutClass timeoutClass	///< In: Selects how long to wait for the PICC. Default TIMEOUT_DEFAULT.
+												) {
+	if (sendData == nullptr || sendLen == 0 || backData == nullptr || backLen == nullptr) {
+		return STATUS_INVALID;
+	}
+	
+	// Time in μs per byte, 9 bit periods of 128/fc at 106 kbit/s, halved for each step of the bit rate.
+	const byte txRate = (PCD_ShadowedValue(TxModeReg) >> 4) & 0x03;
+	const byte rxRate = (PCD_ShadowedValue(RxModeReg) >> 4) & 0x03;
+	const byte highLevel = FIFO_SIZE - _waterLevel;
+	const byte pollBytes = (_waterLevel + 1) / 2;	// Longest wait while receiving, bounds the delay after the end of the answer
+	
+	PCD_WriteRegister(WaterLevelReg, _waterLevel);	// Skipped when unchanged
+	uint16_t sent = sendLen < FIFO_SIZE ? sendLen : FIFO_SIZE;
+	MFRC522::StatusCode status = PCD_StartCommunication(PCD_Transceive, 0x30, sendData, sent, 0, 0, timeoutClass);	// RxIRq and IdleIRq
+	if (status != STATUS_OK) {
+		return status;
+	}
+	_pending.guard += 100 * (uint32_t)(sendLen - sent);
+	if (_irqPin != UNUSED_PIN) {
+		PCD_WriteRegister(ComIEnReg, 0x80 | _pending.waitIRq | 0x01 | (sent < sendLen ? 0x04 : 0x08));	// LoAlertIEn while sending, then HiAlertIEn
+	}
+	
+	uint16_t received = 0;
+	byte irq;
+	byte level;
+	for (;;) {
+		// ComIrqReg first: if RxIRq is already set, the FIFO level read after it covers the whole answer.
+		PCD_BeginBatch();
+		irq = PCD_ReadRegister(ComIrqReg);	// ComIrqReg[7..0] bits are: Set1 TxIRq RxIRq IdleIRq HiAlertIRq LoAlertIRq ErrIRq TimerIRq
+		level = PCD_ReadRegister(FIFOLevelReg) & 0x7F;
+		uint32_t waitTime;
+		if (sent < sendLen) {
+			if (irq & 0x40) {				// TxIRq before the last byte: the FIFO ran empty and the frame was cut short
+				PCD_WriteRegister(CommandReg, PCD_Idle);
+				PCD_EndBatch();
+				_pending.command = PCD_Idle;
+				return STATUS_ERROR;
+			}
+			if (level <= _waterLevel) {		// LoAlert
+				uint16_t count = FIFO_SIZE - level;
+				if (count > sendLen - sent) {
+					count = sendLen - sent;
+				}
+				PCD_WriteRegister(FIFODataReg, count, &sendData[sent]);
+				sent += count;
+				level += count;
+				if (_irqPin != UNUSED_PIN) {
+					PCD_WriteRegister(ComIrqReg, 0x04);		// Clear LoAlertIRq
+					if (sent == sendLen) {
+						PCD_WriteRegister(ComIEnReg, 0x80 | _pending.waitIRq | 0x01 | 0x08);
+					}
+				}
+				_pending.started = PCD_Bus().now();
+			}
+			waitTime = (uint32_t)(sent < sendLen ? level - _waterLevel : level) * 85 >> txRate;
+		}
+		else if (!(irq & 0x40)) {			// The FIFO holds the end of the frame being sent
+			waitTime = (uint32_t)level * 85 >> txRate;
+		}
+		else {
+			if (level > 0 && (level >= highLevel || (irq & _pending.waitIRq))) {		// HiAlert or end of the answer
+				if (received + level > *backLen) {
+					PCD_WriteRegister(CommandReg, PCD_Idle);
+					PCD_EndBatch();
+					_pending.command = PCD_Idle;
+					return STATUS_NO_ROOM;
+				}
+				PCD_ReadRegister(FIFODataReg, level, &backData[received]);
+				received += level;
+				level = 0;
+				if (_irqPin != UNUSED_PIN) {
+					PCD_WriteRegister(ComIrqReg, 0x08);		// Clear HiAlertIRq
+				}
+				_pending.started = PCD_Bus().now();
+			}
+			waitTime = (uint32_t)(highLevel - level < pollBytes ? highLevel - level : pollBytes) * 85 >> rxRate;
+		}
+		PCD_EndBatch();
+		
+		if (irq & _pending.waitIRq) {
+			break;
+		}
+		if ((irq & 0x01) || PCD_Bus().now() - _pending.started > _pending.guard) {
+			_pending.command = PCD_Idle;
+			return STATUS_TIMEOUT;	// Timer interrupt - the PICC did not answer in time, or the MFRC522 is down
+		}
+		if (_irqPin != UNUSED_PIN) {
+			PCD_WaitForIrqPin(_pending.guard);
+		}
+		else if (waitTime > 0) {
+			PCD_Bus().wait(waitTime);
+		}
+	}
+	_pending.command = PCD_Idle;
+	
+	// Stop now if any errors except collisions were detected.
+	const PCD_Register statusRegs[] = {ErrorReg, ControlReg};
+	byte statusValues[2];
+	PCD_ReadRegisters(2, statusRegs, statusValues);
+	if (statusValues[0] & 0x13) {	 // BufferOvfl ParityErr ProtocolErr
+		return STATUS_ERROR;
+	}
+	byte _validBits = statusValues[1] & 0x07;	// RxLastBits[2:0]
+	if (validBits) {
+		*validBits = _validBits;
+	}
+	*backLen = received;
+	
+	// Tell about collisions
+	if (statusValues[0] & 0x08) {		// CollErr
+		return STATUS_COLLISION;
+	}
+	
+	// Perform CRC_A validation if requested.
+	if (checkCRC) {
+		// In this case a MIFARE Classic NAK is not OK.
+		if (received == 1 && _validBits == 4) {
+			return STATUS_MIFARE_NACK;
+		}
+		// We need at least the CRC_A value and all 8 bits of the last byte must be received.
+		if (received < 2 || _validBits != 0) {
+			return STATUS_CRC_WRONG;
+		}
+		// The CRC_A over the data and its own CRC_A is 0.
+		if (CRC_Calculate(backData, received) != 0) {
+			return STATUS_CRC_WRONG;
+		}
+	}
+	return STATUS_OK;
+} // End PCD_TransceiveStream()
+
+/**
+ * Transfers data to the MFRC522 FIFO and starts a command without waiting for it to complete.
+ * Use PCD_PollCommunication() until it no longer returns STATUS_PENDING, then PCD_FinishCommunication() to collect the result.
+ * Only one command can be in progress per MFRC522 instance, but several readers can have commands in progress at the same time.
+ *
+ * @return STATUS_OK if the command was started, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_StartCommunication(	byte command,		///< The command to execute. One of the PCD_Command enums.
+														byte waitIRq,		///< The bits in the ComIrqReg register that signals successful completion of the command.
+														byte *sendData,		///< Pointer to the data to transfer to the FIFO.
+														byte sendLen,		///< Number of bytes to transfer to the FIFO.
+														byte txLastBits,	///< The number of valid bits in the last byte to send. 0 for 8 valid bits.
+														byte rxAlign,		///< Defines the bit position in the first byte received for the first bit received.
+														PCD_TimeoutClass timeoutClass	///< Selects how long to wait for the PICC. One of the PCD_TimeoutClass enums.
+													) {
+	if (timeoutClass >= TIMEOUT_CLASS_COUNT) {
+		return STATUS_INVALID;
+	}
+	
 	// Prepare values for BitFramingReg
-	byte txLastBits = validBits ? *validBits : 0;
 	byte bitFraming = (rxAlign << 4) + txLastBits;		// RxAlign = BitFramingReg[6..4]. TxLastBits = BitFramingReg[2..0]
+	_presenceArmed = false;
 	
+	// All setup writes share one SPI transaction.
+	PCD_BeginBatch();
 	PCD_WriteRegister(CommandReg, PCD_Idle);			// Stop any active command.
+	PCD_ProgramTimer(_timeouts[timeoutClass]);			// Timeout for the PICC answer
 	PCD_WriteRegister(ComIrqReg, 0x7F);					// Clear all seven interrupt request bits
+	if (_irqPin != UNUSED_PIN) {
+		PCD_WriteRegister(ComIEnReg, 0x80 | waitIRq | 0x01);	// IRqInv=1 (IRQ pin active low), completion and TimerIEn
+		PCD_WriteRegister(DivIEnReg, 0x80);					// IRQPushPull=1, no DivIrqReg sources
+	}
 	PCD_WriteRegister(FIFOLevelReg, 0x80);				// FlushBuffer = 1, FIFO initialization
 	PCD_WriteRegister(FIFODataReg, sendLen, sendData);	// Write sendData to the FIFO
 	PCD_WriteRegister(BitFramingReg, bitFraming);		// Bit adjustments
 	PCD_WriteRegister(CommandReg, command);				// Execute the command
 	if (command == PCD_Transceive) {
-		PCD_SetRegisterBitMask(BitFramingReg, 0x80);	// StartSend=1, transmission of data starts
+		PCD_WriteRegister(BitFramingReg, bitFraming | 0x80);	// StartSend=1, transmission of data starts
 	}
+	PCD_EndBatch();
 	
-	// Wait for the command to complete.
-	// In PCD_Init() we set the TAuto flag in TModeReg. This means the timer automatically starts when the PCD stops transmitting.
-	// Each iteration of the do-while-loop takes 17.86μs.
-	// TODO check/modify for other architectures than Arduino Uno 16bit
-	uint16_t i;
-	for (i = 2000; i > 0; i--) {
+	_pending.command	= command;
+	_pending.waitIRq	= waitIRq;
+	_pending.rxAlign	= rxAlign;
+	// The host side guard covers the transmission, the MFRC522 timer and some margin.
+	// It only expires when the MFRC522 does not respond at all.
+	_pending.started	= PCD_Bus().now();
+	_pending.guard		= _timeouts[timeoutClass] + 10000 + 100 * (uint32_t)sendLen;
+	return STATUS_OK;
+} // End PCD_StartCommunication()
+
+/**
+ * Checks whether the command started by PCD_StartCommunication() has completed.
+ * Each call performs at most one register read; in interrupt mode (PCD_SetIrqPin()) no SPI traffic occurs until the IRQ pin is asserted.
+ * In PCD_Init() we set the TAuto flag in TModeReg. This means the timer automatically starts when the PCD stops transmitting.
+ * The timer is programmed with the timeout of the PCD_TimeoutClass given to PCD_StartCommunication().
+ *
+ * @return STATUS_PENDING while the command is running, STATUS_OK when PCD_FinishCommunication() can be called, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_PollCommunication() {
+	if (_pending.command == PCD_Idle) {
+		return STATUS_INVALID;	// Nothing has been started
+	}
+	if (_irqPin == UNUSED_PIN || digitalRead(_irqPin) == LOW) {
 		byte n = PCD_ReadRegister(ComIrqReg);	// ComIrqReg[7..0] bits are: Set1 TxIRq RxIRq IdleIRq HiAlertIRq LoAlertIRq ErrIRq TimerIRq
-		if (n & waitIRq) {					// One of the interrupts that signal success has been set.
-			break;
+		if (n & _pending.waitIRq) {			// One of the interrupts that signal success has been set.
+			return STATUS_OK;
 		}
-		if (n & 0x01) {						// Timer interrupt - nothing received in 25ms
+		if (n & 0x01) {						// Timer interrupt - the PICC did not answer in time
+			_pending.command = PCD_Idle;
 			return STATUS_TIMEOUT;
 		}
 	}
-	// 35.7ms and nothing happend. Communication with the MFRC522 might be down.
-	if (i == 0) {
+	// The guard time passed and nothing happend. Communication with the MFRC522 might be down.
+	if (PCD_Bus().now() - _pending.started > _pending.guard) {
+		_pending.command = PCD_Idle;
 		return STATUS_TIMEOUT;
 	}
+	return STATUS_PENDING;
+} // End PCD_PollCommunication()
+
+/**
+ * Calls PCD_PollCommunication() until the command started by PCD_StartCommunication() is no longer pending.
+ *
+ * @return STATUS_OK when PCD_FinishCommunication() can be called, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_WaitForCommunication() {
+	MFRC522::StatusCode status;
+	while ((status = PCD_PollCommunication()) == STATUS_PENDING) {
+		if (_irqPin != UNUSED_PIN) {
+			yield();	// No SPI traffic while waiting for the IRQ pin, let the core run background tasks
+		}
+	}
+	return status;
+} // End PCD_WaitForCommunication()
+
+/**
+ * Transfers data back from the FIFO after PCD_PollCommunication() returned STATUS_OK.
+ * CRC validation can only be done if backData and backLen are specified.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_FinishCommunication(	byte *backData,		///< nullptr or pointer to buffer if data should be read back after executing the command.
+														byte *backLen,		///< In: Max number of bytes to write to *backData. Out: The number of bytes returned.
+														byte *validBits,	///< Out: The number of valid bits in the last byte. 0 for 8 valid bits.
+														bool checkCRC		///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+													) {
+	if (_pending.command == PCD_Idle) {
+		return STATUS_INVALID;	// Nothing has been started
+	}
+	byte rxAlign = _pending.rxAlign;
+	_pending.command = PCD_Idle;
+	
+	// Collect the error state, the FIFO level and RxLastBits with a single chip select.
+	const PCD_Register statusRegs[] = {ErrorReg, FIFOLevelReg, ControlReg};
+	byte statusValues[3];
+	PCD_BeginBatch();
+	PCD_ReadRegisters(3, statusRegs, statusValues);
 	
 	// Stop now if any errors except collisions were detected.
-	byte errorRegValue = PCD_ReadRegister(ErrorReg); // ErrorReg[7..0] bits are: WrErr TempErr reserved BufferOvfl CollErr CRCErr ParityErr ProtocolErr
+	byte errorRegValue = statusValues[0]; // ErrorReg[7..0] bits are: WrErr TempErr reserved BufferOvfl CollErr CRCErr ParityErr ProtocolErr
 	if (errorRegValue & 0x13) {	 // BufferOvfl ParityErr ProtocolErr
+		PCD_EndBatch();
 		return STATUS_ERROR;
 	}
   
@@ -500,17 +1140,19 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(	byte command,		///< The co
 	
 	// If the caller wants data back, get it from the MFRC522.
 	if (backData && backLen) {
-		byte n = PCD_ReadRegister(FIFOLevelReg);	// Number of bytes in the FIFO
+		byte n = statusValues[1];	// Number of bytes in the FIFO
 		if (n > *backLen) {
+			PCD_EndBatch();
 			return STATUS_NO_ROOM;
 		}
 		*backLen = n;											// Number of bytes returned
 		PCD_ReadRegister(FIFODataReg, n, backData, rxAlign);	// Get received data from FIFO
-		_validBits = PCD_ReadRegister(ControlReg) & 0x07;		// RxLastBits[2:0] indicates the number of valid bits in the last received byte. If this value is 000b, the whole byte is valid.
+		_validBits = statusValues[2] & 0x07;		// RxLastBits[2:0] indicates the number of valid bits in the last received byte. If this value is 000b, the whole byte is valid.
 		if (validBits) {
 			*validBits = _validBits;
 		}
 	}
+	PCD_EndBatch();
 	
 	// Tell about collisions
 	if (errorRegValue & 0x08) {		// CollErr
@@ -539,7 +1181,7 @@ MFRC522::StatusCode MFRC522::PCD_CommunicateWithPICC(	byte command,		///< The co
 	}
 	
 	return STATUS_OK;
-} // End PCD_CommunicateWithPICC()
+} // End PCD_FinishCommunication()
 
 /**
  * Transmits a REQuest command, Type A. Invites PICCs in state IDLE to go to READY and prepare for anticollision or selection. 7 bit frame.
@@ -575,15 +1217,59 @@ MFRC522::StatusCode MFRC522::PICC_REQA_or_WUPA(	byte command, 		///< The command
 												byte *bufferATQA,	///< The buffer to store the ATQA (Answer to request) in
 												byte *bufferSize	///< Buffer size, at least two bytes. Also number of bytes returned if STATUS_OK.
 											) {
-	byte validBits;
 	MFRC522::StatusCode status;
 	
 	if (bufferATQA == nullptr || *bufferSize < 2) {	// The ATQA response is 2 bytes long.
 		return STATUS_NO_ROOM;
 	}
+	status = PICC_StartREQA_or_WUPA(command);
+	if (status != STATUS_OK) {
+		return status;
+	}
+	status = PCD_WaitForCommunication();
+	if (status != STATUS_OK) {
+		return status;
+	}
+	return PICC_FinishREQA_or_WUPA(bufferATQA, bufferSize);
+} // End PICC_REQA_or_WUPA()
+
+/**
+ * Starts transmission of a REQA or WUPA command without waiting for the answer.
+ * Poll with PCD_PollCommunication(), then collect the ATQA with PICC_FinishREQA_or_WUPA().
+ * REQA and WUPA are always sent at 106 kbit/s, so the bit rates and ModWidthReg a PICC may have negotiated are reset.
+ * 
+ * @return STATUS_OK if the command was started, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_StartREQA_or_WUPA(	byte command	///< The command to send - PICC_CMD_REQA or PICC_CMD_WUPA
+													) {
+	// Reset baud rates and ModWidthReg. The registers are shadowed, so this costs nothing when they are unchanged.
+	const PCD_RegisterWrite defaults[] = {
+		{TxModeReg,		0x00},
+		{RxModeReg,		0x00},
+		{ModWidthReg,	0x26}
+	};
+	PCD_WriteRegisters(3, defaults);
 	PCD_ClearRegisterBitMask(CollReg, 0x80);		// ValuesAfterColl=1 => Bits received after collision are cleared.
-	validBits = 7;									// For REQA and WUPA we need the short frame format - transmit only 7 bits of the last (and only) byte. TxLastBits = BitFramingReg[2..0]
-	status = PCD_TransceiveData(&command, 1, bufferATQA, bufferSize, &validBits);
+	// For REQA and WUPA we need the short frame format - transmit only 7 bits of the last (and only) byte. TxLastBits = BitFramingReg[2..0]
+	return PCD_StartCommunication(PCD_Transceive, 0x30, &command, 1, 7, 0, TIMEOUT_REQA);	// RxIRq and IdleIRq
+} // End PICC_StartREQA_or_WUPA()
+
+/**
+ * Collects the ATQA after PICC_StartREQA_or_WUPA() and PCD_PollCommunication() returned STATUS_OK.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_FinishREQA_or_WUPA(	byte *bufferATQA,	///< The buffer to store the ATQA (Answer to request) in
+														byte *bufferSize	///< Buffer size, at least two bytes. Also number of bytes returned if STATUS_OK.
+													) {
+	byte validBits;
+	MFRC522::StatusCode status;
+	
+	if (bufferATQA == nullptr || *bufferSize < 2) {	// The ATQA response is 2 bytes long.
+		_pending.command = PCD_Idle;
+		return STATUS_NO_ROOM;
+	}
+	status = PCD_FinishCommunication(bufferATQA, bufferSize, &validBits);
 	if (status != STATUS_OK) {
 		return status;
 	}
@@ -591,7 +1277,7 @@ MFRC522::StatusCode MFRC522::PICC_REQA_or_WUPA(	byte command, 		///< The command
 		return STATUS_ERROR;
 	}
 	return STATUS_OK;
-} // End PICC_REQA_or_WUPA()
+} // End PICC_FinishREQA_or_WUPA()
 
 /**
  * Transmits SELECT/ANTICOLLISION commands to select a single PICC.
@@ -750,7 +1436,7 @@ MFRC522::StatusCode MFRC522::PICC_Select(	Uid *uid,			///< Pointer to Uid struct
 			PCD_WriteRegister(BitFramingReg, (rxAlign << 4) + txLastBits);	// RxAlign = BitFramingReg[6..4]. TxLastBits = BitFramingReg[2..0]
 			
 			// Transmit the buffer and receive the response.
-			result = PCD_TransceiveData(buffer, bufferUsed, responseBuffer, &responseLength, &txLastBits, rxAlign);
+			result = PCD_TransceiveData(buffer, bufferUsed, responseBuffer, &responseLength, &txLastBits, rxAlign, false, TIMEOUT_ANTICOLLISION);
 			if (result == STATUS_COLLISION) { // More than one PICC in the field => collision.
 				byte valueOfCollReg = PCD_ReadRegister(CollReg); // CollReg[7..0] bits are: ValuesAfterColl reserved CollPosNotValid CollPos[4:0]
 				if (valueOfCollReg & 0x20) { // CollPosNotValid
@@ -845,15 +1531,235 @@ MFRC522::StatusCode MFRC522::PICC_HaltA() {
 	//		If the PICC responds with any modulation during a period of 1 ms after the end of the frame containing the
 	//		HLTA command, this response shall be interpreted as 'not acknowledge'.
 	// We interpret that this way: Only STATUS_TIMEOUT is a success.
-	result = PCD_TransceiveData(buffer, sizeof(buffer), nullptr, 0);
+	result = PCD_TransceiveData(buffer, sizeof(buffer), nullptr, 0, nullptr, 0, false, TIMEOUT_REQA);
 	if (result == STATUS_TIMEOUT) {
 		return STATUS_OK;
 	}
 	if (result == STATUS_OK) { // That is ironically NOT ok in this case ;-)
 		return STATUS_ERROR;
 	}
-	return result;
-} // End PICC_HaltA()
+	return result;
+} // End PICC_HaltA()
+
+/**
+ * Wakes up and selects a PICC whose UID is known, eg after PICC_HaltA() or a failed authentication.
+ * Sends WUPA and one SELECT per cascade level with the complete UID, without ANTICOLLISION.
+ * If the PICC does not answer the SELECT the full cascade of PICC_Select() is run instead, which may select another
+ * PICC. *uid is updated in that case, compare it with the UID expected.
+ * 
+ * @return STATUS_OK on success, STATUS_TIMEOUT if no PICC is in the field, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_SelectKnown(	Uid *uid	///< In: The UID to select, uid->size must be 4, 7 or 10. Out: The PICC selected with its SAK.
+											) {
+	MFRC522::StatusCode result;
+	byte path[12];			// SELECT data of all cascade levels, including CT
+	byte branches[12];
+	byte bufferATQA[2];
+	byte bufferSize = sizeof(bufferATQA);
+	byte levels;
+	Uid selected;
+	
+	switch (uid->size) {
+		case 4:		levels = 1;	break;
+		case 7:		levels = 2;	break;
+		case 10:	levels = 3;	break;
+		default:	return STATUS_INVALID;
+	}
+	for (byte level = 0; level < levels; level++) {
+		if (level < levels - 1) {
+			path[4 * level] = PICC_CMD_CT;
+			memcpy(&path[4 * level + 1], &uid->uidByte[3 * level], 3);
+		}
+		else {
+			memcpy(&path[4 * level], &uid->uidByte[3 * level], 4);
+		}
+	}
+	memset(branches, 0, sizeof(branches));
+	
+	result = PICC_WakeupA(bufferATQA, &bufferSize);
+	if (result != STATUS_OK && result != STATUS_COLLISION) {
+		return result;
+	}
+	result = PICC_SelectPath(path, 32 * levels, branches, &selected);
+	if (result == STATUS_OK) {
+		uid->sak = selected.sak;
+		return STATUS_OK;
+	}
+	
+	// The PICC did not answer its UID: the PICCs are back in IDLE or HALT, run the full cascade.
+	bufferSize = sizeof(bufferATQA);
+	result = PICC_WakeupA(bufferATQA, &bufferSize);
+	if (result != STATUS_OK && result != STATUS_COLLISION) {
+		return result;
+	}
+	return PICC_Select(uid);
+} // End PICC_SelectKnown()
+
+/**
+ * Finds all PICCs in state IDLE in the field and halts them.
+ * The anticollision tree is walked depth first over all cascade levels. Each pass sends REQA, selects the UID bits
+ * known from the previous pass directly and resolves the next unexplored branch with ANTICOLLISION, so every
+ * collision is resolved once. The PICC found is halted, so it does not take part in the following passes.
+ * 
+ * @return STATUS_OK if all PICCs were found or maxCount was reached, STATUS_TIMEOUT if the time budget ran out,
+ * 			STATUS_??? otherwise. *count is set in all cases.
+ */
+MFRC522::StatusCode MFRC522::PICC_Inventory(	Uid *uids,			///< Out: Array of maxCount Uid structs for the PICCs found.
+												byte maxCount,		///< In: The number of entries in uids.
+												byte *count,		///< Out: The number of PICCs found.
+												uint32_t timeBudget	///< In: Time in μs after which no new pass is started. 0 for no limit.
+											) {
+	MFRC522::StatusCode result;
+	byte path[12];			// SELECT data of all cascade levels of the current path, including CT
+	byte branches[12];		// Bit n set: bit n of the path was a collision, the branch with bit n = 0 is left to explore
+	byte pathBits = 0;		// Number of path bits known at the start of the next pass
+	byte bufferATQA[2];
+	byte bufferSize;
+	const uint32_t start = PCD_Bus().now();
+	
+	*count = 0;
+	memset(branches, 0, sizeof(branches));
+	while (*count < maxCount) {
+		if (timeBudget && PCD_Bus().now() - start >= timeBudget) {
+			return STATUS_TIMEOUT;
+		}
+		
+		// PICCs left in READY by the last pass ignore the first REQA but go back to IDLE, so ask twice before giving up.
+		bufferSize = sizeof(bufferATQA);
+		result = PICC_RequestA(bufferATQA, &bufferSize);
+		if (result == STATUS_TIMEOUT) {
+			bufferSize = sizeof(bufferATQA);
+			result = PICC_RequestA(bufferATQA, &bufferSize);
+		}
+		if (result == STATUS_TIMEOUT) {
+			return STATUS_OK;		// All PICCs halted
+		}
+		if (result != STATUS_OK && result != STATUS_COLLISION) {	// PICCs with different ATQA collide
+			return result;
+		}
+		
+		result = PICC_SelectPath(path, pathBits, branches, &uids[*count]);
+		if (result == STATUS_OK) {
+			PICC_HaltA();
+			(*count)++;
+		}
+		else if (result != STATUS_TIMEOUT || pathBits == 0) {
+			return result;
+		}
+		
+		// Continue with the deepest branch left. If there is none the tree is complete, the next REQA confirms it.
+		pathBits = 8 * sizeof(branches);
+		while (pathBits > 0 && !(branches[(pathBits - 1) / 8] & (1 << ((pathBits - 1) % 8)))) {
+			pathBits--;
+		}
+		if (pathBits) {
+			byte mask = 1 << ((pathBits - 1) % 8);
+			branches[(pathBits - 1) / 8] &= ~mask;
+			path[(pathBits - 1) / 8] &= ~mask;
+		}
+	}
+	return STATUS_OK;
+} // End PICC_Inventory()
+
+/**
+ * Selects a PICC following the given UID bits, resolving collisions after them by taking the branch with the bit set.
+ * Used by PICC_Inventory(). Levels fully covered by pathBits are selected without ANTICOLLISION.
+ * 
+ * @return STATUS_OK on success, STATUS_TIMEOUT if no PICC matches the path, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PICC_SelectPath(	byte *path,			///< In/Out: SELECT data of the cascade levels, 4 bytes per level. Out: the path of the PICC selected.
+												byte pathBits,		///< In: The number of known bits in path.
+												byte *branches,		///< In/Out: Bit n is set for each collision found at bit n of path.
+												Uid *uid			///< Out: The PICC selected.
+											) {
+	MFRC522::StatusCode result;
+	byte buffer[9];					// SEL, NVB, 4 bytes UID data or CT, BCC, CRC_A
+	byte responseBuffer[3];			// SAK and CRC_A
+	byte responseLength;
+	byte txLastBits;
+	byte uidIndex = 0;
+	
+	PCD_ClearRegisterBitMask(CollReg, 0x80);		// ValuesAfterColl=1 => Bits received after collision are cleared.
+	for (byte level = 0; level < 3; level++) {
+		byte *levelPath = &path[4 * level];
+		byte knownBits = pathBits > 32 * level ? pathBits - 32 * level : 0;
+		if (knownBits > 32) {
+			knownBits = 32;
+		}
+		buffer[0] = PICC_CMD_SEL_CL1 + 2 * level;
+		memcpy(&buffer[2], levelPath, 4);
+		
+		// ANTICOLLISION until all 32 bits of the level are known
+		while (knownBits < 32) {
+			txLastBits = knownBits % 8;
+			byte index = 2 + knownBits / 8;
+			buffer[1] = (index << 4) + txLastBits;			// NVB - Number of Valid Bits
+			responseLength = sizeof(buffer) - index;
+			byte validBits = txLastBits;
+			result = PCD_TransceiveData(buffer, index + (txLastBits ? 1 : 0), &buffer[index], &responseLength, &validBits, txLastBits, false, TIMEOUT_ANTICOLLISION);
+			if (result == STATUS_COLLISION) {
+				byte valueOfCollReg = PCD_ReadRegister(CollReg); // CollReg[7..0] bits are: ValuesAfterColl reserved CollPosNotValid CollPos[4:0]
+				if (valueOfCollReg & 0x20) {	// CollPosNotValid
+					return STATUS_COLLISION;
+				}
+				// CollPos counts from bit 0 of the first byte received, ie it includes RxAlign. 0 means bit 32.
+				byte collisionPos = (valueOfCollReg & 0x1F) ? (valueOfCollReg & 0x1F) : 32;
+				collisionPos += 8 * (knownBits / 8);
+				if (collisionPos <= knownBits || collisionPos > 32) {
+					return STATUS_INTERNAL_ERROR;
+				}
+				// Take the branch with the bit set, remember the other one
+				byte bit = collisionPos - 1;
+				buffer[2 + bit / 8] |= 1 << (bit % 8);
+				bit += 32 * level;
+				branches[bit / 8] |= 1 << (bit % 8);
+				knownBits = collisionPos;
+			}
+			else if (result != STATUS_OK) {
+				return result;
+			}
+			else if ((buffer[2] ^ buffer[3] ^ buffer[4] ^ buffer[5]) != buffer[6]) {	// BCC
+				return STATUS_ERROR;
+			}
+			else {
+				knownBits = 32;
+			}
+		}
+		
+		// SELECT
+		buffer[1] = 0x70;
+		buffer[6] = buffer[2] ^ buffer[3] ^ buffer[4] ^ buffer[5];
+		result = PCD_CalculateCRC(buffer, 7, &buffer[7]);
+		if (result != STATUS_OK) {
+			return result;
+		}
+		responseLength = sizeof(responseBuffer);
+		txLastBits = 0;
+		result = PCD_TransceiveData(buffer, sizeof(buffer), responseBuffer, &responseLength, &txLastBits, 0, true, TIMEOUT_ANTICOLLISION);
+		if (result != STATUS_OK) {
+			return result;
+		}
+		if (responseLength != 3) {		// SAK must be exactly 24 bits (1 byte + CRC_A).
+			return STATUS_ERROR;
+		}
+		memcpy(levelPath, &buffer[2], 4);
+		
+		if (responseBuffer[0] & 0x04) {	// Cascade bit set - UID not complete yet
+			if (buffer[2] != PICC_CMD_CT) {
+				return STATUS_ERROR;
+			}
+			memcpy(&uid->uidByte[uidIndex], &buffer[3], 3);
+			uidIndex += 3;
+		}
+		else {
+			memcpy(&uid->uidByte[uidIndex], &buffer[2], 4);
+			uid->size = uidIndex + 4;
+			uid->sak = responseBuffer[0];
+			return STATUS_OK;
+		}
+	}
+	return STATUS_ERROR;		// Cascade bit set on level 3
+} // End PICC_SelectPath()
 
 /////////////////////////////////////////////////////////////////////////////////////
 // Functions for communicating with MIFARE PICCs
@@ -876,8 +1782,30 @@ MFRC522::StatusCode MFRC522::PCD_Authenticate(byte command,		///< PICC_CMD_MF_AU
 											MIFARE_Key *key,	///< Pointer to the Crypteo1 key to use (6 bytes)
 											Uid *uid			///< Pointer to Uid struct. The first 4 bytes of the UID is used.
 											) {
-	byte waitIRq = 0x10;		// IdleIRq
-	
+	MFRC522::StatusCode status = PCD_StartAuthenticate(command, blockAddr, key, uid);
+	if (status != STATUS_OK) {
+		return status;
+	}
+	status = PCD_WaitForCommunication();
+	if (status != STATUS_OK) {
+		return status;
+	}
+	return PCD_FinishCommunication();
+} // End PCD_Authenticate()
+
+/**
+ * Starts the MFRC522 MFAuthent command without waiting for it to complete.
+ * Poll with PCD_PollCommunication(), then call PCD_FinishCommunication() without arguments.
+ * See PCD_Authenticate() for details.
+ * Remember to call PCD_StopCrypto1() after communicating with the authenticated PICC.
+ * 
+ * @return STATUS_OK if the command was started, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::PCD_StartAuthenticate(	byte command,		///< PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+													byte blockAddr, 	///< The block number. See numbering in the comments in the .h file.
+													MIFARE_Key *key,	///< Pointer to the Crypteo1 key to use (6 bytes)
+													Uid *uid			///< Pointer to Uid struct. The first 4 bytes of the UID is used.
+													) {
 	// Build command buffer
 	byte sendData[12];
 	sendData[0] = command;
@@ -892,10 +1820,8 @@ MFRC522::StatusCode MFRC522::PCD_Authenticate(byte command,		///< PICC_CMD_MF_AU
 	for (byte i = 0; i < 4; i++) {				// The last 4 bytes of the UID
 		sendData[8+i] = uid->uidByte[i+uid->size-4];
 	}
-	
-	// Start the authentication.
-	return PCD_CommunicateWithPICC(PCD_MFAuthent, waitIRq, &sendData[0], sizeof(sendData));
-} // End PCD_Authenticate()
+	return PCD_StartCommunication(PCD_MFAuthent, 0x10, sendData, sizeof(sendData), 0, 0, TIMEOUT_AUTH);	// IdleIRq
+} // End PCD_StartAuthenticate()
 
 /**
  * Used to exit the PCD from its authenticated state.
@@ -906,6 +1832,81 @@ void MFRC522::PCD_StopCrypto1() {
 	PCD_ClearRegisterBitMask(Status2Reg, 0x08); // Status2Reg[7..0] bits are: TempSensClear I2CForceHS reserved reserved MFCrypto1On ModemState[2:0]
 } // End PCD_StopCrypto1()
 
+/**
+ * Brings a PICC back to state ACTIVE after a failed authentication or a NAK left it in state IDLE or HALT.
+ * Stops the encrypted session, then wakes the PICC with WUPA and selects it by its known UID with
+ * PICC_SelectKnown(), ie without anticollision. This costs two frames for a single size UID.
+ * 
+ * @return STATUS_OK on success, STATUS_??? if the PICC is gone.
+ */
+MFRC522::StatusCode MFRC522::PICC_Reactivate(	Uid *uid	///< Pointer to Uid struct of the PICC. Not changed.
+											) {
+	const uint32_t start = PCD_Bus().now();
+	PCD_StopCrypto1();
+	Uid known = *uid;
+	MFRC522::StatusCode result = PICC_SelectKnown(&known);
+	if (result == STATUS_OK) {
+		_reactivateTime = PCD_Bus().now() - start;
+	}
+	return result;
+} // End PICC_Reactivate()
+
+/**
+ * Authenticates a block with the first of several keys that works, eg for readers that accept several key schemes.
+ * After each wrong key the PICC is brought back with PICC_Reactivate().
+ * The PICC must be selected - ie in state ACTIVE - before calling this function. It stays ACTIVE unless it left the field.
+ * Remember to call PCD_StopCrypto1() after communicating with the authenticated PICC.
+ * 
+ * @return STATUS_OK on success, STATUS_TIMEOUT if no key worked within the budget, STATUS_??? if the PICC is gone.
+ */
+MFRC522::StatusCode MFRC522::PCD_AuthenticateKeys(	byte command,		///< PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+													byte blockAddr,		///< The block number. See numbering in the comments in the .h file.
+													MIFARE_Key *keys,	///< Array of keyCount keys, tried in order
+													byte keyCount,		///< Number of keys
+													Uid *uid,			///< Pointer to Uid struct of the PICC
+													byte *keyIndex,		///< Out: Index of the key that worked. nullptr if not needed.
+													uint32_t timeBudget	///< Time in μs after which no further key is tried. 0 for no limit.
+												) {
+	const uint32_t start = PCD_Bus().now();
+	MFRC522::StatusCode result;
+	for (byte i = 0; i < keyCount; i++) {
+		// Do not start an attempt that cannot fail within the budget.
+		if (i > 0 && timeBudget && PCD_AuthenticateAttempts(timeBudget - (PCD_Bus().now() - start)) == 0) {
+			break;
+		}
+		result = PCD_Authenticate(command, blockAddr, &keys[i], uid);
+		if (result == STATUS_OK) {
+			if (keyIndex != nullptr) {
+				*keyIndex = i;
+			}
+			return result;
+		}
+		result = PICC_Reactivate(uid);
+		if (result != STATUS_OK) {
+			return result;
+		}
+		if (timeBudget && PCD_Bus().now() - start >= timeBudget) {
+			break;
+		}
+	}
+	return STATUS_TIMEOUT;
+} // End PCD_AuthenticateKeys()
+
+/**
+ * Returns the number of failed authentications, each followed by PICC_Reactivate(), that fit in a time budget.
+ * Uses the MFAuthent timeout and the duration of the last reactivation. Until the first reactivation the
+ * REQA and ANTICOLLISION timeouts are used instead, so the estimate errs on the low side.
+ */
+uint16_t MFRC522::PCD_AuthenticateAttempts(	uint32_t timeBudget	///< Time in μs
+											) {
+	uint32_t reactivate = _reactivateTime;
+	if (reactivate == 0) {
+		reactivate = _timeouts[TIMEOUT_REQA] + 2 * _timeouts[TIMEOUT_ANTICOLLISION];	// WUPA, SELECT per level
+	}
+	uint32_t attempts = timeBudget / (_timeouts[TIMEOUT_AUTH] + reactivate);
+	return attempts < UINT16_MAX ? attempts : UINT16_MAX;
+} // End PCD_AuthenticateAttempts()
+
 /**
  * Reads 16 bytes (+ 2 bytes CRC_A) from the active PICC.
  * 
@@ -933,18 +1934,187 @@ MFRC522::StatusCode MFRC522::MIFARE_Read(	byte blockAddr, 	///< MIFARE Classic:
 		return STATUS_NO_ROOM;
 	}
 	
+	result = MIFARE_StartRead(blockAddr);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	result = PCD_WaitForCommunication();
+	if (result != STATUS_OK) {
+		return result;
+	}
+	// Receive the response, validate CRC_A.
+	return MIFARE_FinishRead(buffer, bufferSize);
+} // End MIFARE_Read()
+
+/**
+ * Starts a MIFARE READ without waiting for the answer.
+ * Poll with PCD_PollCommunication(), then collect the data with MIFARE_FinishRead().
+ * See MIFARE_Read() for details.
+ * 
+ * @return STATUS_OK if the command was started, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::MIFARE_StartRead(	byte blockAddr	///< MIFARE Classic: The block (0-0xff) number. MIFARE Ultralight: The first page to return data from.
+											) {
+	MFRC522::StatusCode result;
+	byte cmdBuffer[4];
+	
 	// Build command buffer
-	buffer[0] = PICC_CMD_MF_READ;
-	buffer[1] = blockAddr;
+	cmdBuffer[0] = PICC_CMD_MF_READ;
+	cmdBuffer[1] = blockAddr;
 	// Calculate CRC_A
-	result = PCD_CalculateCRC(buffer, 2, &buffer[2]);
+	result = PCD_CalculateCRC(cmdBuffer, 2, &cmdBuffer[2]);
 	if (result != STATUS_OK) {
 		return result;
 	}
+	return PCD_StartCommunication(PCD_Transceive, 0x30, cmdBuffer, 4, 0, 0, TIMEOUT_READ_WRITE);	// RxIRq and IdleIRq
+} // End MIFARE_StartRead()
+
+/**
+ * Collects the data after MIFARE_StartRead() and PCD_PollCommunication() returned STATUS_OK.
+ * Checks the CRC_A before returning STATUS_OK.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::MIFARE_FinishRead(	byte *buffer,		///< The buffer to store the data in
+												byte *bufferSize	///< Buffer size, at least 18 bytes. Also number of bytes returned if STATUS_OK.
+											) {
+	// Sanity check
+	if (buffer == nullptr || *bufferSize < 18) {
+		_pending.command = PCD_Idle;
+		return STATUS_NO_ROOM;
+	}
+	return PCD_FinishCommunication(buffer, bufferSize, nullptr, true);
+} // End MIFARE_FinishRead()
+
+/**
+ * Reads all blocks of a MIFARE Classic sector, the sector trailer included, with a single authentication.
+ * 
+ * The blocks are stored in the buffer in ascending order, 16 bytes each. Sectors 0-31 have 4 blocks, sectors 32-39
+ * of the MIFARE Classic 4K have 16 blocks, see MIFARE_BlockCount().
+ * 
+ * A PICC that fails the authentication or a READ falls back to state IDLE or HALT. This function then brings it
+ * back with PICC_Reactivate(), authenticates again and goes on with the next block, so a block the access bits
+ * deny does not cost the other blocks. The PICC is left in state ACTIVE, and authenticated if the last block was
+ * read. Remember to call PCD_StopCrypto1() when done with the PICC.
+ * Blocks that are not read because PCD_Authenticate() failed get STATUS_AUTH_FAILED. With a wrong key all blocks
+ * fail that way and STATUS_AUTH_FAILED is returned.
+ * 
+ * @return STATUS_OK if all blocks were read, the status of the first failed block otherwise.
+ */
+MFRC522::StatusCode MFRC522::MIFARE_ReadSector(	byte sector,			///< The sector to read, 0..39.
+												byte command,			///< PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+												MIFARE_Key *key,		///< The key for the sector
+												Uid *uid,				///< Pointer to Uid struct of the selected PICC
+												byte *buffer,			///< The buffer to store the blocks in
+												uint16_t *bufferSize,	///< Buffer size, at least 16 bytes per block. Also number of bytes returned.
+												StatusCode *blockStatus	///< Out: The status of each block, MIFARE_BlockCount() entries. nullptr if not needed.
+											) {
+	const byte blockCount = MIFARE_BlockCount(sector);
+	const byte firstBlock = MIFARE_FirstBlock(sector);
+	
+	// Sanity check
+	if (blockCount == 0 || key == nullptr || uid == nullptr) {
+		return STATUS_INVALID;
+	}
+	if (buffer == nullptr || *bufferSize < 16 * blockCount) {
+		return STATUS_NO_ROOM;
+	}
+	*bufferSize = 16 * blockCount;
 	
-	// Transmit the buffer and receive the response, validate CRC_A.
-	return PCD_TransceiveData(buffer, 4, buffer, bufferSize, nullptr, 0, true);
-} // End MIFARE_Read()
+	MFRC522::StatusCode result = STATUS_OK;
+	MFRC522::StatusCode status;
+	bool authenticated = false;
+	byte readBuffer[18];
+	byte readSize;
+	byte i = 0;
+	while (i < blockCount) {
+		byte failed = i;			// First block of the blocks that fail with status
+		if (!authenticated) {
+			status = PCD_Authenticate(command, firstBlock, key, uid);
+			if (status != STATUS_OK) {
+				status = STATUS_AUTH_FAILED;
+				failed = blockCount;	// A wrong key fails the whole rest of the sector
+			}
+			authenticated = (status == STATUS_OK);
+		}
+		if (authenticated) {
+			readSize = sizeof(readBuffer);
+			status = MIFARE_Read(firstBlock + i, readBuffer, &readSize);
+			if (status == STATUS_OK) {
+				memcpy(&buffer[16 * i], readBuffer, 16);
+				if (blockStatus != nullptr) {
+					blockStatus[i] = STATUS_OK;
+				}
+				i++;
+				continue;
+			}
+			failed = i + 1;
+		}
+		if (result == STATUS_OK) {
+			result = status;
+		}
+		
+		// The PICC fell back to IDLE or HALT. Select it again and reauthenticate for the next block.
+		// If it is gone, the remaining blocks fail with it.
+		authenticated = false;
+		if (PICC_Reactivate(uid) != STATUS_OK) {
+			failed = blockCount;
+		}
+		for (; i < failed; i++) {
+			memset(&buffer[16 * i], 0, 16);
+			if (blockStatus != nullptr) {
+				blockStatus[i] = status;
+			}
+		}
+	}
+	return result;
+} // End MIFARE_ReadSector()
+
+/**
+ * Reads all sectors of a MIFARE Classic PICC with MIFARE_ReadSector(), ie with one authentication per sector.
+ * 
+ * The blocks are stored in the buffer by block address, 16 bytes each: 320 bytes for the MIFARE Mini, 1024 for
+ * the 1K and 4096 for the 4K. Sector n is authenticated with keys[n]. Sectors from keyCount on use the last key,
+ * so a single key can be passed for the whole PICC.
+ * Remember to call PCD_StopCrypto1() when done with the PICC.
+ * 
+ * @return STATUS_OK if all blocks were read, the status of the first failed block otherwise.
+ */
+MFRC522::StatusCode MFRC522::MIFARE_ReadCard(	PICC_Type piccType,		///< PICC_TYPE_MIFARE_MINI, PICC_TYPE_MIFARE_1K or PICC_TYPE_MIFARE_4K
+												byte command,			///< PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+												MIFARE_Key *keys,		///< Array of keyCount keys, one per sector
+												byte keyCount,			///< Number of keys, at least 1
+												Uid *uid,				///< Pointer to Uid struct of the selected PICC
+												byte *buffer,			///< The buffer to store the blocks in
+												uint16_t *bufferSize,	///< Buffer size, at least 16 bytes per block. Also number of bytes returned.
+												StatusCode *blockStatus	///< Out: The status of each block, indexed by block address. nullptr if not needed.
+											) {
+	const byte sectorCount = MIFARE_SectorCount(piccType);
+	
+	// Sanity check
+	if (sectorCount == 0 || keys == nullptr || keyCount == 0) {
+		return STATUS_INVALID;
+	}
+	const uint16_t size = 16 * (MIFARE_FirstBlock(sectorCount - 1) + MIFARE_BlockCount(sectorCount - 1));
+	if (buffer == nullptr || *bufferSize < size) {
+		return STATUS_NO_ROOM;
+	}
+	*bufferSize = size;
+	
+	MFRC522::StatusCode result = STATUS_OK;
+	MFRC522::StatusCode status;
+	uint16_t sectorSize;
+	for (byte sector = 0; sector < sectorCount; sector++) {
+		const byte firstBlock = MIFARE_FirstBlock(sector);
+		sectorSize = size - 16 * firstBlock;
+		status = MIFARE_ReadSector(sector, command, &keys[sector < keyCount ? sector : keyCount - 1], uid,
+									&buffer[16 * firstBlock], &sectorSize, blockStatus ? &blockStatus[firstBlock] : nullptr);
+		if (result == STATUS_OK) {
+			result = status;
+		}
+	}
+	return result;
+} // End MIFARE_ReadCard()
 
 /**
  * Writes 16 bytes to the active PICC.
@@ -1081,7 +2251,7 @@ MFRC522::StatusCode MFRC522::MIFARE_TwoStepHelper(	byte command,	///< The comman
 	}
 	
 	// Step 2: Transfer the data
-	result = PCD_MIFARE_Transceive(	(byte *)&data, 4, true); // Adds CRC_A and accept timeout as success.
+	result = PCD_MIFARE_Transceive(	(byte *)&data, 4, true, TIMEOUT_VALUE_DATA); // Adds CRC_A and accept timeout as success.
 	if (result != STATUS_OK) {
 		return result;
 	}
@@ -1201,7 +2371,7 @@ MFRC522::StatusCode MFRC522::PCD_NTAG216_AUTH(byte* passWord, byte pACK[]) //Aut
 //	byte cmdBufferSize	= sizeof(cmdBuffer);
 	byte validBits		= 0;
 	byte rxlength		= 5;
-	result = PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, cmdBuffer, 7, cmdBuffer, &rxlength, &validBits);
+	result = PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, cmdBuffer, 7, cmdBuffer, &rxlength, &validBits, 0, false, TIMEOUT_READ_WRITE);
 	
 	pACK[0] = cmdBuffer[0];
 	pACK[1] = cmdBuffer[1];
@@ -1213,6 +2383,148 @@ MFRC522::StatusCode MFRC522::PCD_NTAG216_AUTH(byte* passWord, byte pACK[]) //Aut
 	return STATUS_OK;
 } // End PCD_NTAG216_AUTH()
 
+/**
+ * Reads the version information of a NTAG21x or MIFARE Ultralight EV1 with GET_VERSION.
+ * Byte 2 is the product type (0x04 NTAG, 0x03 Ultralight), byte 6 the storage size, see NTAG_PageCount().
+ * Other PICCs answer with NAK or not at all and fall back to state IDLE.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::NTAG_GetVersion(	byte *version	///< Out: 8 bytes
+											) {
+	byte cmdBuffer[3];
+	byte buffer[10];
+	byte size = sizeof(buffer);
+	
+	cmdBuffer[0] = PICC_CMD_NTAG_GET_VERSION;
+	MFRC522::StatusCode result = PCD_CalculateCRC(cmdBuffer, 1, &cmdBuffer[1]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	result = PCD_TransceiveData(cmdBuffer, sizeof(cmdBuffer), buffer, &size, nullptr, 0, true, TIMEOUT_READ_WRITE);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	if (size != sizeof(buffer)) {
+		return STATUS_ERROR;
+	}
+	memcpy(version, buffer, 8);
+	return STATUS_OK;
+} // End NTAG_GetVersion()
+
+/**
+ * Returns the number of pages of a NTAG21x or MIFARE Ultralight EV1 from its GET_VERSION answer, 0 if unknown.
+ */
+byte MFRC522::NTAG_PageCount(	const byte *version	///< The 8 bytes returned by NTAG_GetVersion()
+							) {
+	switch (version[6]) {
+		case 0x0B:	return 20;	// NTAG210, Ultralight EV1 MF0UL11
+		case 0x0E:	return 41;	// NTAG212, Ultralight EV1 MF0UL21
+		case 0x0F:	return 45;	// NTAG213
+		case 0x11:	return 135;	// NTAG215
+		case 0x13:	return 231;	// NTAG216
+		default:	return 0;
+	}
+} // End NTAG_PageCount()
+
+/**
+ * Reads the pages startPage to endPage of a NTAG21x with a single FAST_READ.
+ * 
+ * The answer can be longer than the FIFO, eg 924 bytes for a whole NTAG216. It is collected while it is
+ * received, see PCD_TransceiveStream(). A page range that touches protected pages is answered with NAK, after which
+ * the PICC is in state IDLE.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::NTAG_FastRead(	byte startPage,			///< The first page
+											byte endPage,			///< The last page, at least startPage
+											byte *buffer,			///< The buffer to store the data in
+											uint16_t *bufferSize	///< Buffer size, at least 4 * (endPage - startPage + 1) + 2 bytes for the CRC_A. Also number of data bytes returned.
+										) {
+	if (endPage < startPage) {
+		return STATUS_INVALID;
+	}
+	const uint16_t size = 4 * (endPage - startPage + 1);
+	if (buffer == nullptr || *bufferSize < size + 2) {
+		return STATUS_NO_ROOM;
+	}
+	
+	byte cmdBuffer[5];
+	cmdBuffer[0] = PICC_CMD_NTAG_FAST_READ;
+	cmdBuffer[1] = startPage;
+	cmdBuffer[2] = endPage;
+	MFRC522::StatusCode result = PCD_CalculateCRC(cmdBuffer, 3, &cmdBuffer[3]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	uint16_t received = *bufferSize;
+	result = PCD_TransceiveStream(cmdBuffer, sizeof(cmdBuffer), buffer, &received, nullptr, true, TIMEOUT_READ_WRITE);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	if (received != size + 2) {
+		return STATUS_ERROR;
+	}
+	*bufferSize = size;
+	return STATUS_OK;
+} // End NTAG_FastRead()
+
+/**
+ * Reads the NFC counter of a NTAG21x with READ_CNT. The counter must be enabled in the configuration pages.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::NTAG_ReadCounter(	uint32_t *counter	///< Out: The 24 bit counter
+											) {
+	byte cmdBuffer[4];
+	byte buffer[5];
+	byte size = sizeof(buffer);
+	
+	cmdBuffer[0] = PICC_CMD_NTAG_READ_CNT;
+	cmdBuffer[1] = 0x02;			// The NFC counter is counter 2
+	MFRC522::StatusCode result = PCD_CalculateCRC(cmdBuffer, 2, &cmdBuffer[2]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	result = PCD_TransceiveData(cmdBuffer, sizeof(cmdBuffer), buffer, &size, nullptr, 0, true, TIMEOUT_READ_WRITE);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	if (size != sizeof(buffer)) {
+		return STATUS_ERROR;
+	}
+	*counter = (uint32_t(buffer[2])<<16) | (uint32_t(buffer[1])<<8) | uint32_t(buffer[0]);
+	return STATUS_OK;
+} // End NTAG_ReadCounter()
+
+/**
+ * Reads the originality signature of a NTAG21x with READ_SIG, an ECC signature of the UID by NXP.
+ * 
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522::NTAG_ReadSignature(	byte *signature	///< Out: 32 bytes
+												) {
+	byte cmdBuffer[4];
+	byte buffer[34];
+	byte size = sizeof(buffer);
+	
+	cmdBuffer[0] = PICC_CMD_NTAG_READ_SIG;
+	cmdBuffer[1] = 0x00;
+	MFRC522::StatusCode result = PCD_CalculateCRC(cmdBuffer, 2, &cmdBuffer[2]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	result = PCD_TransceiveData(cmdBuffer, sizeof(cmdBuffer), buffer, &size, nullptr, 0, true, TIMEOUT_READ_WRITE);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	if (size != sizeof(buffer)) {
+		return STATUS_ERROR;
+	}
+	memcpy(signature, buffer, 32);
+	return STATUS_OK;
+} // End NTAG_ReadSignature()
+
 
 /////////////////////////////////////////////////////////////////////////////////////
 // Support functions
@@ -1226,7 +2538,8 @@ MFRC522::StatusCode MFRC522::PCD_NTAG216_AUTH(byte* passWord, byte pACK[]) //Aut
  */
 MFRC522::StatusCode MFRC522::PCD_MIFARE_Transceive(	byte *sendData,		///< Pointer to the data to transfer to the FIFO. Do NOT include the CRC_A.
 													byte sendLen,		///< Number of bytes in sendData.
-													bool acceptTimeout	///< True => A timeout is also success
+													bool acceptTimeout,	///< True => A timeout is also success
+													PCD_TimeoutClass timeoutClass	///< The timeout class of the command
 												) {
 	MFRC522::StatusCode result;
 	byte cmdBuffer[18]; // We need room for 16 bytes data and 2 bytes CRC_A.
@@ -1248,7 +2561,7 @@ MFRC522::StatusCode MFRC522::PCD_MIFARE_Transceive(	byte *sendData,		///< Pointe
 	byte waitIRq = 0x30;		// RxIRq and IdleIRq
 	byte cmdBufferSize = sizeof(cmdBuffer);
 	byte validBits = 0;
-	result = PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, cmdBuffer, sendLen, cmdBuffer, &cmdBufferSize, &validBits);
+	result = PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, cmdBuffer, sendLen, cmdBuffer, &cmdBufferSize, &validBits, 0, false, timeoutClass);
 	if (acceptTimeout && result == STATUS_TIMEOUT) {
 		return STATUS_OK;
 	}
@@ -1281,6 +2594,9 @@ const __FlashStringHelper *MFRC522::GetStatusCodeName(MFRC522::StatusCode code	/
 		case STATUS_INTERNAL_ERROR:	return F("Internal error in the code. Should not happen.");
 		case STATUS_INVALID:		return F("Invalid argument.");
 		case STATUS_CRC_WRONG:		return F("The CRC_A does not match.");
+		case STATUS_PENDING:		return F("The command is still in progress.");
+		case STATUS_AUTH_FAILED:	return F("The authentication failed.");
+		case STATUS_FIELD_RESET:	return F("The field was reset to activate the PICC.");
 		case STATUS_MIFARE_NACK:	return F("A MIFARE PICC responded with NAK.");
 		default:					return F("Unknown error");
 	}
@@ -1313,6 +2629,43 @@ MFRC522::PICC_Type MFRC522::PICC_GetType(byte sak		///< The SAK byte returned fr
 	}
 } // End PICC_GetType()
 
+/**
+ * Returns the number of sectors of a MIFARE Classic PICC, 0 for other PICC types.
+ */
+byte MFRC522::MIFARE_SectorCount(PICC_Type piccType	///< One of the PICC_Type enums.
+								) {
+	switch (piccType) {
+		case PICC_TYPE_MIFARE_MINI:	return 5;
+		case PICC_TYPE_MIFARE_1K:	return 16;
+		case PICC_TYPE_MIFARE_4K:	return 40;
+		default:					return 0;
+	}
+} // End MIFARE_SectorCount()
+
+/**
+ * Returns the address of the first block of a MIFARE Classic sector.
+ */
+byte MFRC522::MIFARE_FirstBlock(byte sector	///< The sector, 0..39.
+								) {
+	return sector < 32 ? sector * 4 : 128 + (sector - 32) * 16;
+} // End MIFARE_FirstBlock()
+
+/**
+ * Returns the number of blocks of a MIFARE Classic sector, the sector trailer included. 0 for sectors beyond 39.
+ */
+byte MFRC522::MIFARE_BlockCount(byte sector	///< The sector, 0..39.
+								) {
+	return sector < 32 ? 4 : (sector < 40 ? 16 : 0);
+} // End MIFARE_BlockCount()
+
+/**
+ * Returns the sector of a MIFARE Classic block.
+ */
+byte MFRC522::MIFARE_SectorOf(byte blockAddr	///< The block (0-0xff) number.
+							) {
+	return blockAddr < 128 ? blockAddr / 4 : 32 + (blockAddr - 128) / 16;
+} // End MIFARE_SectorOf()
+
 /**
  * Returns a __FlashStringHelper pointer to the PICC type name.
  * 
@@ -1633,27 +2986,47 @@ void MFRC522::PICC_DumpMifareClassicSectorToSerial(Uid *uid,			///< Pointer to U
  */
 void MFRC522::PICC_DumpMifareUltralightToSerial() {
 	MFRC522::StatusCode status;
-	byte byteCount;
-	byte buffer[18];
+	byte buffer[66];
 	byte i;
 	
+	// NTAG21x and Ultralight EV1 tell their size and read 16 pages per FAST_READ.
+	// The original Ultralight answers GET_VERSION with NAK and must be selected again.
+	byte version[8];
+	byte pageCount = 0;
+	if (NTAG_GetVersion(version) == STATUS_OK) {
+		pageCount = NTAG_PageCount(version);
+	}
+	else {
+		PICC_Reactivate(&uid);
+	}
+	const byte pagesPerRead = pageCount ? 16 : 4;
+	if (pageCount == 0) {
+		pageCount = 16;		// Try the pages of the original Ultralight. Ultralight C has more pages.
+	}
+	
 	Serial.println(F("Page  0  1  2  3"));
-	// Try the mpages of the original Ultralight. Ultralight C has more pages.
-	for (byte page = 0; page < 16; page +=4) { // Read returns data for 4 pages at a time.
+	for (byte page = 0; page < pageCount; page += pagesPerRead) {
 		// Read pages
-		byteCount = sizeof(buffer);
-		status = MIFARE_Read(page, buffer, &byteCount);
+		byte count = (pageCount - page < pagesPerRead) ? pageCount - page : pagesPerRead;
+		if (pagesPerRead == 4) {
+			byte byteCount = sizeof(buffer);
+			status = MIFARE_Read(page, buffer, &byteCount);	// Read returns data for 4 pages at a time.
+		}
+		else {
+			uint16_t byteCount = sizeof(buffer);
+			status = NTAG_FastRead(page, page + count - 1, buffer, &byteCount);
+		}
 		if (status != STATUS_OK) {
-			Serial.print(F("MIFARE_Read() failed: "));
+			Serial.print(pagesPerRead == 4 ? F("MIFARE_Read() failed: ") : F("NTAG_FastRead() failed: "));
 			Serial.println(GetStatusCodeName(status));
 			break;
 		}
 		// Dump data
-		for (byte offset = 0; offset < 4; offset++) {
+		for (byte offset = 0; offset < count; offset++) {
 			i = page + offset;
 			if(i < 10)
 				Serial.print(F("  ")); // Pad with spaces
-			else
+			else if(i < 100)
 				Serial.print(F(" ")); // Pad with spaces
 			Serial.print(i);
 			Serial.print(F("  "));
@@ -1903,16 +3276,92 @@ bool MFRC522::PICC_IsNewCardPresent() {
 	byte bufferATQA[2];
 	byte bufferSize = sizeof(bufferATQA);
 
-	// Reset baud rates
-	PCD_WriteRegister(TxModeReg, 0x00);
-	PCD_WriteRegister(RxModeReg, 0x00);
-	// Reset ModWidthReg
-	PCD_WriteRegister(ModWidthReg, 0x26);
-
+	// PICC_RequestA() resets the baud rates and ModWidthReg
 	MFRC522::StatusCode result = PICC_RequestA(bufferATQA, &bufferSize);
 	return (result == STATUS_OK || result == STATUS_COLLISION);
 } // End PICC_IsNewCardPresent()
 
+/**
+ * Low cost replacement for PICC_IsNewCardPresent() in idle loops.
+ * The first call sets the MFRC522 up for REQA. Later calls only clear the interrupt requests, restart Transceive, flush
+ * the FIFO, put REQA into it and set StartSend, all in one SPI transaction. Then ComIrqReg is read every 250μs until a
+ * PICC answered or the REQA timeout expired, or once after the IRQ pin signalled either.
+ * Transceive must be restarted: after a timeout it keeps waiting for an answer and ignores StartSend. The FIFO is
+ * flushed so bytes left by an aborted frame are not taken for an answer.
+ * The ATQA is only read and checked when a PICC answered.
+ * Any other communication with PICCs ends the mode, the next call sets it up again.
+ * 
+ * @return true if a PICC answered. It is in state READY, continue with PICC_ReadCardSerial().
+ */
+bool MFRC522::PICC_PollPresence() {
+	const uint32_t timeout = _timeouts[TIMEOUT_REQA];
+	if (!_presenceArmed) {
+		const PCD_RegisterWrite setup[] = {
+			{CommandReg,	PCD_Idle},		// Stop any active command.
+			{TxModeReg,		0x00},			// Reset baud rates and ModWidthReg
+			{RxModeReg,		0x00},
+			{ModWidthReg,	0x26},
+			{FIFOLevelReg,	0x80}			// FlushBuffer = 1, FIFO initialization
+		};
+		PCD_BeginBatch();
+		PCD_WriteRegisters(5, setup);
+		PCD_ClearRegisterBitMask(CollReg, 0x80);		// ValuesAfterColl=1 => Bits received after collision are cleared.
+		PCD_ProgramTimer(timeout);
+		if (_irqPin != UNUSED_PIN) {
+			PCD_WriteRegister(ComIEnReg, 0x80 | 0x20 | 0x01);	// IRqInv=1 (IRQ pin active low), RxIEn and TimerIEn
+			PCD_WriteRegister(DivIEnReg, 0x80);					// IRQPushPull=1, no DivIrqReg sources
+		}
+		PCD_EndBatch();
+		_presenceArmed = true;
+	}
+	
+	PCD_BeginBatch();
+	PCD_WriteRegister(ComIrqReg, 0x7F);					// Clear all seven interrupt request bits
+	PCD_WriteRegister(CommandReg, PCD_Idle);			// Leave the receiver of the last poll
+	PCD_WriteRegister(FIFOLevelReg, 0x80);				// FlushBuffer = 1, FIFO initialization
+	PCD_WriteRegister(CommandReg, PCD_Transceive);
+	PCD_WriteRegister(FIFODataReg, PICC_CMD_REQA);
+	PCD_WriteRegister(BitFramingReg, 0x87);				// StartSend=1, TxLastBits=7 for the short frame
+	PCD_EndBatch();
+	
+	// REQA, the frame delay time and the ATQA take about 250μs on air, so no answer can be complete before that.
+	const uint32_t interval = 250;
+	const uint32_t start = PCD_Bus().now();
+	const uint32_t guard = timeout + 10000;
+	byte n = 0;
+	if (_irqPin != UNUSED_PIN) {
+		if (!PCD_WaitForIrqPin(guard)) {
+			_presenceArmed = false;
+			return false;
+		}
+	}
+	else {
+		PCD_Bus().wait(interval);
+	}
+	while (!((n = PCD_ReadRegister(ComIrqReg)) & 0x21)) {	// RxIRq or TimerIRq
+		if (PCD_Bus().now() - start > guard) {				// Communication with the MFRC522 might be down
+			_presenceArmed = false;
+			return false;
+		}
+		if (_irqPin == UNUSED_PIN) {
+			PCD_Bus().wait(interval);
+		}
+	}
+	if (!(n & 0x20)) {
+		return false;		// Timeout, the field is empty
+	}
+	
+	// Something answered: check the ATQA like PICC_RequestA() does. The FIFO is read, so set up again next time.
+	_presenceArmed = false;
+	_pending.command = PCD_Transceive;
+	_pending.waitIRq = 0x30;
+	_pending.rxAlign = 0;
+	byte bufferATQA[2];
+	byte bufferSize = sizeof(bufferATQA);
+	MFRC522::StatusCode result = PICC_FinishREQA_or_WUPA(bufferATQA, &bufferSize);
+	return (result == STATUS_OK || result == STATUS_COLLISION);
+} // End PICC_PollPresence()
+
 /**
  * Simple wrapper around PICC_Select.
  * Returns true if a UID could be read.
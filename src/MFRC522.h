@@ -84,9 +84,22 @@
 #include <stdint.h>
 #include <Arduino.h>
 #include <SPI.h>
+#include "MFRC522Bus.h"
 
-#ifndef MFRC522_SPICLOCK
-#define MFRC522_SPICLOCK SPI_CLOCK_DIV4			// MFRC522 accept upto 10MHz
+// How CRC_A is calculated for the frames exchanged with PICCs, see PCD_CalculateCRC()
+// 	MFRC522_CRC_HARDWARE	The CRC coprocessor of the MFRC522, costs three SPI transactions per frame. The default.
+// 	MFRC522_CRC_TABLE		In software with a 256 entry table in flash (512 bytes).
+// 	MFRC522_CRC_NIBBLE		In software with a 16 entry table in flash (32 bytes), about half as fast as the 256 entry table.
+#define MFRC522_CRC_HARDWARE	0
+#define MFRC522_CRC_TABLE		1
+#define MFRC522_CRC_NIBBLE		2
+#ifndef MFRC522_CRC_MODE
+#define MFRC522_CRC_MODE MFRC522_CRC_HARDWARE
+#endif
+
+// Default FIFO water level of PCD_TransceiveStream(), see PCD_SetWaterLevel()
+#ifndef MFRC522_WATER_LEVEL
+#define MFRC522_WATER_LEVEL 16
 #endif
 
 // Firmware data for self-test
@@ -255,6 +268,20 @@ public:
 		RxGain_max				= 0x07 << 4		// 111b - 48 dB, maximum, convenience for RxGain_48dB
 	};
 	
+	// Command classes with individual timeouts, see PCD_SetTimeout().
+	// The timeout is the time the PCD waits for the PICC after the end of its own transmission.
+	enum PCD_TimeoutClass : byte {
+		TIMEOUT_DEFAULT			,	// Commands not listed below, eg raw PCD_TransceiveData() calls
+		TIMEOUT_REQA			,	// REQA, WUPA and HLTA
+		TIMEOUT_ANTICOLLISION	,	// ANTICOLLISION and SELECT
+		TIMEOUT_AUTH			,	// MFAuthent
+		TIMEOUT_READ_WRITE		,	// MIFARE Classic / Ultralight read, write and value commands
+		TIMEOUT_ISO_DEP			,	// ISO/IEC 14443-4: RATS, PPS and DESELECT
+		TIMEOUT_VALUE_DATA		,	// Data part of MIFARE Classic INCREMENT, DECREMENT and RESTORE, answered only by a NAK
+		TIMEOUT_FWT				,	// ISO/IEC 14443-4 T=CL blocks, set from the FWI of the PICC by MFRC522Extended
+		TIMEOUT_CLASS_COUNT
+	};
+	
 	// Commands sent to the PICC.
 	enum PICC_Command : byte {
 		// The commands used by the PCD to manage communication with several PICCs (ISO 14443-3, Type A, section 6.4)
@@ -279,7 +306,12 @@ public:
 		PICC_CMD_MF_TRANSFER	= 0xB0,		// Writes the contents of the internal data register to a block.
 		// The commands used for MIFARE Ultralight (from http://www.nxp.com/documents/data_sheet/MF0ICU1.pdf, Section 8.6)
 		// The PICC_CMD_MF_READ and PICC_CMD_MF_WRITE can also be used for MIFARE Ultralight.
-		PICC_CMD_UL_WRITE		= 0xA2		// Writes one 4 byte page to the PICC.
+		PICC_CMD_UL_WRITE		= 0xA2,		// Writes one 4 byte page to the PICC.
+		// The commands added by NTAG21x and MIFARE Ultralight EV1 (from https://www.nxp.com/docs/en/data-sheet/NTAG213_215_216.pdf, Section 10)
+		PICC_CMD_NTAG_GET_VERSION	= 0x60,	// Returns 8 bytes of vendor, product type and storage size.
+		PICC_CMD_NTAG_FAST_READ		= 0x3A,	// Reads an arbitrary range of pages in one frame.
+		PICC_CMD_NTAG_READ_CNT		= 0x39,	// Reads the 24 bit NFC counter.
+		PICC_CMD_NTAG_READ_SIG		= 0x3C	// Reads the 32 byte ECC originality signature.
 	};
 	
 	// MIFARE constants that does not fit anywhere else
@@ -315,6 +347,9 @@ public:
 		STATUS_INTERNAL_ERROR	,	// Internal error in the code. Should not happen ;-)
 		STATUS_INVALID			,	// Invalid argument.
 		STATUS_CRC_WRONG		,	// The CRC_A does not match
+		STATUS_PENDING			,	// The command started with PCD_StartCommunication() is still in progress
+		STATUS_AUTH_FAILED		,	// The PICC rejected the key, or left during the authentication
+		STATUS_FIELD_RESET		,	// The PICC is active after a reset of the field, which ended all other PICC sessions
 		STATUS_MIFARE_NACK		= 0xff	// A MIFARE PICC responded with NAK.
 	};
 	
@@ -325,6 +360,12 @@ public:
 		byte		sak;			// The SAK (Select acknowledge) byte returned from the PICC after successful selection.
 	} Uid;
 
+	// A struct used for passing a register write to PCD_WriteRegisters().
+	typedef struct {
+		PCD_Register	reg;
+		byte			value;
+	} PCD_RegisterWrite;
+
 	// A struct used for passing a MIFARE Crypto1 key
 	typedef struct {
 		byte		keyByte[MF_KEY_SIZE];
@@ -340,17 +381,24 @@ public:
 	DEPRECATED_MSG("use MFRC522(byte chipSelectPin, byte resetPowerDownPin)")
 	MFRC522(byte resetPowerDownPin);
 	MFRC522(byte chipSelectPin, byte resetPowerDownPin);
+	MFRC522(MFRC522Bus &bus, byte resetPowerDownPin = UNUSED_PIN);
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Basic interface functions for communicating with the MFRC522
 	/////////////////////////////////////////////////////////////////////////////////////
+	void PCD_BeginBatch();
+	void PCD_EndBatch();
 	void PCD_WriteRegister(PCD_Register reg, byte value);
 	void PCD_WriteRegister(PCD_Register reg, byte count, byte *values);
+	void PCD_WriteRegisters(byte count, const PCD_RegisterWrite *writes);
 	byte PCD_ReadRegister(PCD_Register reg);
 	void PCD_ReadRegister(PCD_Register reg, byte count, byte *values, byte rxAlign = 0);
+	void PCD_ReadRegisters(byte count, const PCD_Register *regs, byte *values);
 	void PCD_SetRegisterBitMask(PCD_Register reg, byte mask);
 	void PCD_ClearRegisterBitMask(PCD_Register reg, byte mask);
+	void PCD_InvalidateRegisterCache();
 	StatusCode PCD_CalculateCRC(byte *data, byte length, byte *result);
+	static uint16_t CRC_Calculate(const byte *data, uint16_t length, uint16_t crc = 0x6363);
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for manipulating the MFRC522
@@ -364,31 +412,57 @@ public:
 	void PCD_AntennaOff();
 	byte PCD_GetAntennaGain();
 	void PCD_SetAntennaGain(byte mask);
+	void PCD_SetIrqPin(byte irqPin);
+	void PCD_SetTimeout(PCD_TimeoutClass timeoutClass, uint32_t timeoutUs);
+	uint32_t PCD_GetTimeout(PCD_TimeoutClass timeoutClass);
+	void PCD_SetWaterLevel(byte level);
 	bool PCD_PerformSelfTest();
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Power control functions
 	/////////////////////////////////////////////////////////////////////////////////////
 	void PCD_SoftPowerDown();
-	void PCD_SoftPowerUp();
+	StatusCode PCD_SoftPowerUp(uint32_t *wakeUpTime = nullptr);
+	MFRC522Bus &PCD_Bus() { return _bus ? *_bus : _spiBus; }	// The transport, also the time base of all timeouts
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for communicating with PICCs
 	/////////////////////////////////////////////////////////////////////////////////////
-	StatusCode PCD_TransceiveData(byte *sendData, byte sendLen, byte *backData, byte *backLen, byte *validBits = nullptr, byte rxAlign = 0, bool checkCRC = false);
-	StatusCode PCD_CommunicateWithPICC(byte command, byte waitIRq, byte *sendData, byte sendLen, byte *backData = nullptr, byte *backLen = nullptr, byte *validBits = nullptr, byte rxAlign = 0, bool checkCRC = false);
+	StatusCode PCD_TransceiveData(byte *sendData, byte sendLen, byte *backData, byte *backLen, byte *validBits = nullptr, byte rxAlign = 0, bool checkCRC = false, PCD_TimeoutClass timeoutClass = TIMEOUT_DEFAULT);
+	StatusCode PCD_CommunicateWithPICC(byte command, byte waitIRq, byte *sendData, byte sendLen, byte *backData = nullptr, byte *backLen = nullptr, byte *validBits = nullptr, byte rxAlign = 0, bool checkCRC = false, PCD_TimeoutClass timeoutClass = TIMEOUT_DEFAULT);
+	StatusCode PCD_TransceiveStream(byte *sendData, uint16_t sendLen, byte *backData, uint16_t *backLen, byte *validBits = nullptr, bool checkCRC = false, PCD_TimeoutClass timeoutClass = TIMEOUT_DEFAULT);
 	StatusCode PICC_RequestA(byte *bufferATQA, byte *bufferSize);
 	StatusCode PICC_WakeupA(byte *bufferATQA, byte *bufferSize);
 	StatusCode PICC_REQA_or_WUPA(byte command, byte *bufferATQA, byte *bufferSize);
+	
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Non-blocking functions for communicating with PICCs
+	// Start the operation, call PCD_PollCommunication() until it no longer returns STATUS_PENDING, then finish it.
+	/////////////////////////////////////////////////////////////////////////////////////
+	StatusCode PCD_StartCommunication(byte command, byte waitIRq, byte *sendData, byte sendLen, byte txLastBits = 0, byte rxAlign = 0, PCD_TimeoutClass timeoutClass = TIMEOUT_DEFAULT);
+	StatusCode PCD_PollCommunication();
+	StatusCode PCD_FinishCommunication(byte *backData = nullptr, byte *backLen = nullptr, byte *validBits = nullptr, bool checkCRC = false);
+	StatusCode PICC_StartREQA_or_WUPA(byte command);
+	StatusCode PICC_FinishREQA_or_WUPA(byte *bufferATQA, byte *bufferSize);
+	StatusCode PCD_StartAuthenticate(byte command, byte blockAddr, MIFARE_Key *key, Uid *uid);
+	StatusCode MIFARE_StartRead(byte blockAddr);
+	StatusCode MIFARE_FinishRead(byte *buffer, byte *bufferSize);
 	virtual StatusCode PICC_Select(Uid *uid, byte validBits = 0);
 	StatusCode PICC_HaltA();
+	StatusCode PICC_SelectKnown(Uid *uid);
+	StatusCode PICC_Inventory(Uid *uids, byte maxCount, byte *count, uint32_t timeBudget = 0);
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for communicating with MIFARE PICCs
 	/////////////////////////////////////////////////////////////////////////////////////
 	StatusCode PCD_Authenticate(byte command, byte blockAddr, MIFARE_Key *key, Uid *uid);
 	void PCD_StopCrypto1();
+	StatusCode PICC_Reactivate(Uid *uid);
+	StatusCode PCD_AuthenticateKeys(byte command, byte blockAddr, MIFARE_Key *keys, byte keyCount, Uid *uid, byte *keyIndex, uint32_t timeBudget = 0);
+	uint16_t PCD_AuthenticateAttempts(uint32_t timeBudget);
 	StatusCode MIFARE_Read(byte blockAddr, byte *buffer, byte *bufferSize);
+	StatusCode MIFARE_ReadSector(byte sector, byte command, MIFARE_Key *key, Uid *uid, byte *buffer, uint16_t *bufferSize, StatusCode *blockStatus = nullptr);
+	StatusCode MIFARE_ReadCard(PICC_Type piccType, byte command, MIFARE_Key *keys, byte keyCount, Uid *uid, byte *buffer, uint16_t *bufferSize, StatusCode *blockStatus = nullptr);
 	StatusCode MIFARE_Write(byte blockAddr, byte *buffer, byte bufferSize);
 	StatusCode MIFARE_Ultralight_Write(byte page, byte *buffer, byte bufferSize);
 	StatusCode MIFARE_Decrement(byte blockAddr, int32_t delta);
@@ -398,15 +472,24 @@ public:
 	StatusCode MIFARE_GetValue(byte blockAddr, int32_t *value);
 	StatusCode MIFARE_SetValue(byte blockAddr, int32_t value);
 	StatusCode PCD_NTAG216_AUTH(byte *passWord, byte pACK[]);
+	StatusCode NTAG_GetVersion(byte *version);
+	StatusCode NTAG_FastRead(byte startPage, byte endPage, byte *buffer, uint16_t *bufferSize);
+	StatusCode NTAG_ReadCounter(uint32_t *counter);
+	StatusCode NTAG_ReadSignature(byte *signature);
+	static byte NTAG_PageCount(const byte *version);
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Support functions
 	/////////////////////////////////////////////////////////////////////////////////////
-	StatusCode PCD_MIFARE_Transceive(byte *sendData, byte sendLen, bool acceptTimeout = false);
+	StatusCode PCD_MIFARE_Transceive(byte *sendData, byte sendLen, bool acceptTimeout = false, PCD_TimeoutClass timeoutClass = TIMEOUT_READ_WRITE);
 	// old function used too much memory, now name moved to flash; if you need char, copy from flash to memory
 	//const char *GetStatusCodeName(byte code);
 	static const __FlashStringHelper *GetStatusCodeName(StatusCode code);
 	static PICC_Type PICC_GetType(byte sak);
+	static byte MIFARE_SectorCount(PICC_Type piccType);
+	static byte MIFARE_FirstBlock(byte sector);
+	static byte MIFARE_BlockCount(byte sector);
+	static byte MIFARE_SectorOf(byte blockAddr);
 	// old function used too much memory, now name moved to flash; if you need char, copy from flash to memory
 	//const char *PICC_GetTypeName(byte type);
 	static const __FlashStringHelper *PICC_GetTypeName(PICC_Type type);
@@ -434,11 +517,44 @@ public:
 	/////////////////////////////////////////////////////////////////////////////////////
 	virtual bool PICC_IsNewCardPresent();
 	virtual bool PICC_ReadCardSerial();
+	bool PICC_PollPresence();
 	
 protected:
 	byte _chipSelectPin;		// Arduino pin connected to MFRC522's SPI slave select input (Pin 24, NSS, active low)
+	MFRC522SPIBus _spiBus;		// Default transport, hardware SPI on the global SPI object with _chipSelectPin
+	MFRC522Bus *_bus;			// Transport given to the constructor, nullptr to use _spiBus
 	byte _resetPowerDownPin;	// Arduino pin connected to MFRC522's reset and power down input (Pin 6, NRSTPD, active low)
+	byte _irqPin;				// Arduino pin connected to MFRC522's IRQ output (Pin 23), UNUSED_PIN for polling mode
+	byte _batchDepth;			// Nesting depth of PCD_BeginBatch(). The SPI bus is claimed while > 0.
+	bool _presenceArmed;		// The MFRC522 is set up for PICC_PollPresence(), Transceive is running
+	struct {
+		byte		command;		// PCD_Command in progress, PCD_Idle if none
+		byte		waitIRq;		// ComIrqReg bits that signal completion
+		byte		rxAlign;		// Bit position of the first received bit
+		uint32_t	started;		// PCD_Bus().now() when the command was started
+		uint32_t	guard;			// Host side timeout in μs, in case the MFRC522 timer never fires
+	} _pending;					// State of the command started by PCD_StartCommunication()
+	uint32_t _timeouts[TIMEOUT_CLASS_COUNT];	// PICC timeout in μs for each PCD_TimeoutClass
+	uint32_t _timerTimeout;		// Timeout in μs currently programmed into the MFRC522 timer, 0 if unknown
+	uint32_t _reactivateTime;	// Duration in μs of the last PICC_Reactivate(), 0 if none yet
+	byte _waterLevel;			// FIFO level for LoAlert and free space for HiAlert in PCD_TransceiveStream()
+	
+	// Write-through shadow of the configuration registers only the host changes, see PCD_ShadowSlot().
+	enum PCD_ShadowFlags : byte {
+		SHADOW_READ				= 0x01,		// Reads are served from the shadow
+		SHADOW_SKIP				= 0x02		// Writes of an unchanged value are skipped
+	};
+	static constexpr byte SHADOW_SIZE = 17;
+	static constexpr byte SHADOW_NONE = 0xFF;
+	byte _shadowValue[SHADOW_SIZE];
+	uint32_t _shadowValid;		// Bit n set => _shadowValue[n] matches the chip
 	StatusCode MIFARE_TwoStepHelper(byte command, byte blockAddr, int32_t data);
+	bool PCD_WaitForIrqPin(uint32_t timeoutUs);
+	byte PCD_ShadowedValue(PCD_Register reg);
+	static byte PCD_ShadowSlot(PCD_Register reg, byte *mask, byte *flags);
+	void PCD_ProgramTimer(uint32_t timeoutUs);
+	StatusCode PCD_WaitForCommunication();
+	StatusCode PICC_SelectPath(byte *path, byte pathBits, byte *branches, Uid *uid);
 };
 
 #endif
@@ -0,0 +1,206 @@
+/*
+ * ISO/IEC 7816-4 command APDUs sent to an ISO/IEC 14443-4 PICC, built and answered in one caller-owned buffer.
+ */
+#include "MFRC522Apdu.h"
+
+/**
+ * Constructor.
+ */
+MFRC522Apdu::MFRC522Apdu(	MFRC522Extended &reader,			///< The reader
+							MFRC522Extended::TagInfo *tag,		///< The PICC, activated with PICC_Select()
+							byte *buffer,						///< HEADROOM bytes, then room for the command and the response
+							uint16_t size						///< Size of buffer
+						) : _reader(reader), _tag(tag), _buffer(buffer), _size(size) {
+	_lc = 0;
+	_le = 0;
+	_extended = false;
+	_responseLength = 0;
+	_sw = 0;
+	_callback = NULL;
+	_context = NULL;
+	_heldCount = 0;
+} // End constructor
+
+/**
+ * Starts a command APDU: writes the header, Lc and Le into the buffer.
+ * The data field goes between them; write its lc bytes at the pointer returned before transceive().
+ *
+ * @return the data field, NULL if the command does not fit into the buffer.
+ */
+byte *MFRC522Apdu::begin(	byte cla,		///< Class byte
+							byte ins,		///< Instruction byte
+							byte p1,		///< Parameter 1
+							byte p2,		///< Parameter 2
+							uint16_t lc,	///< Length of the data field, 0 for none
+							uint32_t le		///< Expected response length Ne, 0 for none, at most 65536
+						) {
+	_header[0] = cla;
+	_header[1] = ins;
+	_header[2] = p1;
+	_header[3] = p2;
+	_lc = lc;
+	_le = le > 65536 ? 65536 : le;
+	_extended = lc > 255 || le > 256;
+	_responseLength = 0;
+	_sw = 0;
+
+	uint16_t bodyOffset = 4 + (lc ? (_extended ? 3 : 1) : 0);
+	if ((uint32_t)HEADROOM + bodyOffset + lc + 3 > _size) {
+		return NULL;
+	}
+	encode();
+	return _buffer + HEADROOM + bodyOffset;
+} // End begin()
+
+/**
+ * Sends the command APDU and receives the response, see the class description for 61xx and 6Cxx.
+ * The status word is in sw() whenever the PICC answered, also for other values than SW_OK.
+ *
+ * @return STATUS_OK if the PICC answered, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Apdu::transceive() {
+	byte *apdu = _buffer + HEADROOM;
+	uint16_t capacity = _size - HEADROOM;
+	uint16_t length = encode();
+	bool repeated = false;
+	_responseLength = 0;
+	_heldCount = 0;
+	_sw = 0;
+
+	for (;;) {
+		// The response lands behind the data received before; GET RESPONSE is built there as well.
+		uint16_t offset = _callback ? 0 : _responseLength;
+		byte *command = apdu + offset;
+		byte saved[HEADROOM];
+		memcpy(saved, command - HEADROOM, HEADROOM);
+		uint16_t received = 0;
+		MFRC522::StatusCode result = _reader.TCL_TransceiveInPlace(_tag, command, length, capacity - offset, &received, _callback ? chunk : NULL, this);
+		if (offset) {
+			memcpy(command - HEADROOM, saved, HEADROOM);	// The prologue took the last bytes of the data before
+		}
+		if (result != MFRC522::STATUS_OK) {
+			return result;
+		}
+
+		// Take SW1 SW2 off the response
+		byte *status;
+		if (_callback) {
+			if (_heldCount < 2) {
+				return MFRC522::STATUS_ERROR;
+			}
+			_heldCount = 0;
+			status = _held;
+		} else {
+			if (received < 2) {
+				return MFRC522::STATUS_ERROR;
+			}
+			_responseLength += received - 2;
+			status = command + received - 2;
+		}
+		_sw = (uint16_t)status[0] << 8 | status[1];
+
+		if (status[0] == 0x61) {
+			// More data available: GET RESPONSE with Ne SW2, on the logical channel of the command
+			if (capacity - (_callback ? 0 : _responseLength) < 5) {
+				return MFRC522::STATUS_NO_ROOM;
+			}
+			command = apdu + (_callback ? 0 : _responseLength);
+			byte le = status[1];
+			command[0] = _header[0] & 0x03;
+			command[1] = 0xC0;
+			command[2] = 0x00;
+			command[3] = 0x00;
+			command[4] = le;
+			length = 5;
+		}
+		else if (status[0] == 0x6C && !repeated && _responseLength == 0) {
+			// Wrong Le: send the command again with Ne SW2
+			repeated = true;
+			_le = status[1] ? status[1] : 256;
+			length = encode();
+		}
+		else {
+			return MFRC522::STATUS_OK;
+		}
+	}
+} // End transceive()
+
+/**
+ * Hands the response data to a function as it arrives instead of collecting it in the buffer.
+ * The function gets the data without SW1 SW2; responseLength() counts all bytes it got.
+ */
+void MFRC522Apdu::setChunkCallback(	MFRC522Extended::TCL_ChunkCallback callback,	///< NULL to collect the response in the buffer
+									void *context									///< Passed to the function
+								) {
+	_callback = callback;
+	_context = context;
+} // End setChunkCallback()
+
+/**
+ * Writes header, Lc and Le of the command APDU around the data field in the buffer.
+ *
+ * @return the length of the command APDU.
+ */
+uint16_t MFRC522Apdu::encode() {
+	byte *apdu = _buffer + HEADROOM;
+	memcpy(apdu, _header, sizeof(_header));
+	uint16_t length = sizeof(_header);
+	if (_lc) {
+		if (_extended) {
+			apdu[length++] = 0x00;
+			apdu[length++] = _lc >> 8;
+		}
+		apdu[length++] = _lc & 0xFF;
+		length += _lc;
+	}
+	if (_le) {
+		// Ne 256 and 65536 are encoded as 0
+		if (_extended) {
+			if (!_lc) {
+				apdu[length++] = 0x00;
+			}
+			apdu[length++] = (_le >> 8) & 0xFF;
+		}
+		apdu[length++] = _le & 0xFF;
+	}
+	return length;
+} // End encode()
+
+/**
+ * Passes response data to the callback, except for the last two bytes so far: they are SW1 SW2 unless more follows.
+ */
+void MFRC522Apdu::deliver(const byte *data, uint16_t length) {
+	if (length >= 2) {
+		pass(_held, _heldCount);
+		pass(data, length - 2);
+		_held[0] = data[length - 2];
+		_held[1] = data[length - 1];
+		_heldCount = 2;
+	}
+	else if (length == 1) {
+		if (_heldCount == 2) {
+			pass(_held, 1);
+			_held[0] = _held[1];
+			_held[1] = data[0];
+		} else {
+			_held[_heldCount++] = data[0];
+		}
+	}
+} // End deliver()
+
+/**
+ * Hands response data to the callback and counts it in responseLength().
+ */
+void MFRC522Apdu::pass(const byte *data, uint16_t length) {
+	if (length) {
+		_callback(data, length, _context);
+		_responseLength += length;
+	}
+} // End pass()
+
+/**
+ * TCL_ChunkCallback of TCL_TransceiveInPlace(): takes the INF field of one response block for the MFRC522Apdu in context.
+ */
+void MFRC522Apdu::chunk(const byte *data, uint16_t length, void *context) {
+	((MFRC522Apdu *)context)->deliver(data, length);
+} // End chunk()
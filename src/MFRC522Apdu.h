@@ -0,0 +1,67 @@
+/**
+ * ISO/IEC 7816-4 command APDUs sent to an ISO/IEC 14443-4 PICC, built and answered in one caller-owned buffer.
+ *
+ * The buffer holds the command APDU and then its response, behind MFRC522Apdu::HEADROOM bytes for the block
+ * prologue. Write the data field at the pointer begin() returns, then call transceive():
+ * 		byte buffer[MFRC522Apdu::HEADROOM + 260];
+ * 		MFRC522Apdu apdu(mfrc522, &mfrc522.tag, buffer, sizeof(buffer));
+ * 		byte *body = apdu.begin(0x00, 0xD6, 0x00, 0x00, 200);		// UPDATE BINARY with 200 data bytes
+ * 		memcpy(body, data, 200);
+ * 		if (apdu.transceive() == MFRC522::STATUS_OK && apdu.sw() == MFRC522Apdu::SW_OK) {
+ * 			...
+ * 		}
+ * 		apdu.begin(0x00, 0xB0, 0x00, 0x00, 0, 256);				// READ BINARY, Le 256
+ * 		apdu.transceive();											// apdu.response(), apdu.responseLength()
+ *
+ * Lc and Le are encoded in extended length when Lc is above 255 or Le above 256. The APDU is sent with
+ * MFRC522Extended::TCL_TransceiveInPlace(), so neither the command nor the response is copied on the way to and
+ * from the FIFO, and the stack holds no frame buffer.
+ *
+ * SW1 SW2 are taken off the response, see sw(). After 61xx the remaining data is fetched with GET RESPONSE and
+ * appended; after 6Cxx the command is sent once more with Le xx.
+ *
+ * With setChunkCallback() the response data is handed over block by block as it arrives, and the buffer only
+ * needs room for the command and one block, whatever the length of the response.
+ */
+#ifndef MFRC522Apdu_h
+#define MFRC522Apdu_h
+
+#include "MFRC522Extended.h"
+
+class MFRC522Apdu {
+public:
+	static constexpr byte HEADROOM = MFRC522Extended::TCL_HEADROOM;
+	static constexpr uint16_t SW_OK = 0x9000;
+
+	MFRC522Apdu(MFRC522Extended &reader, MFRC522Extended::TagInfo *tag, byte *buffer, uint16_t size);
+
+	byte *begin(byte cla, byte ins, byte p1, byte p2, uint16_t lc = 0, uint32_t le = 0);
+	MFRC522::StatusCode transceive();
+	void setChunkCallback(MFRC522Extended::TCL_ChunkCallback callback, void *context = NULL);
+	uint16_t sw() const { return _sw; };								// SW1 SW2 of the last response, 0 if none
+	byte *response() const { return _buffer + HEADROOM; };			// Response data, without SW1 SW2
+	uint16_t responseLength() const { return _responseLength; };	// Response bytes, all chunks with a callback
+
+protected:
+	MFRC522Extended &_reader;
+	MFRC522Extended::TagInfo *_tag;
+	byte *_buffer;
+	uint16_t _size;
+	byte _header[4];					// CLA INS P1 P2, the response overwrites them in the buffer
+	uint16_t _lc;
+	uint32_t _le;						// 0 if absent, up to 65536
+	bool _extended;						// Lc and Le in extended length
+	uint16_t _responseLength;
+	uint16_t _sw;
+	MFRC522Extended::TCL_ChunkCallback _callback;
+	void *_context;
+	byte _held[2];						// Last bytes received through the callback, SW1 SW2 if no more follow
+	byte _heldCount;
+
+	uint16_t encode();
+	void deliver(const byte *data, uint16_t length);
+	void pass(const byte *data, uint16_t length);
+	static void chunk(const byte *data, uint16_t length, void *context);
+};
+
+#endif
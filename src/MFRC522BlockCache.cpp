@@ -0,0 +1,317 @@
+/*
+ * Write-back cache of the blocks of a MIFARE Classic or pages of a MIFARE Ultralight / NTAG PICC.
+ */
+#include "MFRC522BlockCache.h"
+#include "MFRC522KeySearch.h"
+
+/**
+ * Constructor.
+ */
+MFRC522BlockCache::MFRC522BlockCache(	MFRC522 &reader	///< The reader
+									) : _reader(reader) {
+	_search = nullptr;
+	_command = MFRC522::PICC_CMD_MF_AUTH_KEY_A;
+	memset(_key.keyByte, 0xFF, sizeof(_key.keyByte));	// Transport key
+	_classic = true;
+	_authSector = NO_SECTOR;
+	_authentications = 0;
+	invalidate();
+} // End constructor
+
+/**
+ * Starts a session with the PICC in the reader's uid member, which must be in state ACTIVE.
+ * Forgets the lines of the previous session, dirty or not.
+ *
+ * @return STATUS_OK on success, STATUS_INVALID if the PICC is not a MIFARE Classic, Ultralight or NTAG.
+ */
+MFRC522::StatusCode MFRC522BlockCache::begin() {
+	invalidate();
+	_authSector = NO_SECTOR;
+	_authentications = 0;
+	MFRC522::PICC_Type piccType = MFRC522::PICC_GetType(_reader.uid.sak);
+	_classic = (MFRC522::MIFARE_SectorCount(piccType) != 0);
+	if (!_classic && piccType != MFRC522::PICC_TYPE_MIFARE_UL) {
+		return MFRC522::STATUS_INVALID;
+	}
+	return MFRC522::STATUS_OK;
+} // End begin()
+
+/**
+ * Sets the key for all MIFARE Classic sectors. The default is key A FFFFFFFFFFFFh.
+ */
+void MFRC522BlockCache::setKey(	byte command,				///< PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+								MFRC522::MIFARE_Key *key	///< The key, copied
+							) {
+	_command = command;
+	_key = *key;
+	_search = nullptr;
+} // End setKey()
+
+/**
+ * Authenticates the MIFARE Classic sectors with a key search instead of the key from setKey().
+ */
+void MFRC522BlockCache::setKeySearch(MFRC522KeySearch *search	///< The key search, nullptr to use setKey() again
+									) {
+	_search = search;
+} // End setKeySearch()
+
+/**
+ * Forgets all lines, dirty or not.
+ */
+void MFRC522BlockCache::invalidate() {
+	_lineCount = 0;
+	memset(&_pending, 0, sizeof(_pending));
+} // End invalidate()
+
+/**
+ * Returns true if a line holds data not yet written to the PICC.
+ */
+bool MFRC522BlockCache::isDirty() const {
+	for (byte i = 0; i < _lineCount; i++) {
+		if (_lines[i].dirty) {
+			return true;
+		}
+	}
+	return false;
+} // End isDirty()
+
+/**
+ * Returns true if a line holds no data for the PICC, ie can be replaced.
+ */
+bool MFRC522BlockCache::hasClean() const {
+	for (byte i = 0; i < _lineCount; i++) {
+		if (!_lines[i].dirty) {
+			return true;
+		}
+	}
+	return false;
+} // End hasClean()
+
+/**
+ * Reads a block (MIFARE Classic) or page (Ultralight, NTAG). Only the first access to a line talks to the PICC.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522BlockCache::read(	byte address,	///< The block or page
+												byte *buffer	///< Out: 16 bytes for a block, 4 bytes for a page
+											) {
+	Line *line;
+	MFRC522::StatusCode status = fetch(address, &line);
+	if (status != MFRC522::STATUS_OK) {
+		return status;
+	}
+	memcpy(buffer, &line->data[(address - line->address) * unitSize()], unitSize());
+	return status;
+} // End read()
+
+/**
+ * Writes a block (MIFARE Classic) or page (Ultralight, NTAG) to the cache. flush() writes it to the PICC.
+ * The line is fetched from the PICC first, so a write of unchanged data can be skipped.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522BlockCache::write(	byte address,		///< The block or page
+												const byte *buffer	///< 16 bytes for a block, 4 bytes for a page
+											) {
+	Line *line;
+	MFRC522::StatusCode status = fetch(address, &line);
+	if (status != MFRC522::STATUS_OK) {
+		return status;
+	}
+	byte unit = address - line->address;
+	byte *data = &line->data[unit * unitSize()];
+	if (memcmp(data, buffer, unitSize()) == 0) {
+		_pending.skipped++;
+		return status;
+	}
+	memcpy(data, buffer, unitSize());
+	line->dirty |= 1 << unit;
+	return status;
+} // End write()
+
+/**
+ * Writes the dirty blocks or pages to the PICC, in ascending address order. MIFARE Classic sectors are
+ * authenticated once each. A block or page that fails stays dirty, the others are still written.
+ *
+ * @return STATUS_OK if all were written, the status of the first failure otherwise.
+ */
+MFRC522::StatusCode MFRC522BlockCache::flush(FlushReport *report	///< Out: What was written. nullptr if not needed.
+											) {
+	FlushReport result;
+	MFRC522::StatusCode status = writeBack(&result);
+
+	// Add the skipped writes and what fetch() wrote back to free a line since the last flush()
+	result.written += _pending.written;
+	result.skipped += _pending.skipped;
+	result.authentications += _pending.authentications;
+	memset(&_pending, 0, sizeof(_pending));
+	if (report != nullptr) {
+		*report = result;
+	}
+	return status;
+} // End flush()
+
+/**
+ * Writes the dirty blocks or pages to the PICC for flush() and fetch().
+ *
+ * @return STATUS_OK if all were written, the status of the first failure otherwise.
+ */
+MFRC522::StatusCode MFRC522BlockCache::writeBack(FlushReport *report	///< Out: What was written
+												) {
+	FlushReport result = {0, 0, 0, 0, 0};
+	const byte authentications = _authentications;
+	MFRC522::StatusCode status = MFRC522::STATUS_OK;
+	int16_t previous = -1;
+	while (true) {
+		// The dirty line with the next higher address
+		Line *next = nullptr;
+		for (byte i = 0; i < _lineCount; i++) {
+			if (_lines[i].dirty && _lines[i].address > previous && (next == nullptr || _lines[i].address < next->address)) {
+				next = &_lines[i];
+			}
+		}
+		if (next == nullptr) {
+			break;
+		}
+		previous = next->address;
+		for (byte unit = 0; unit < 4; unit++) {
+			if (!(next->dirty & (1 << unit))) {
+				continue;
+			}
+			MFRC522::StatusCode written = writeUnit(next, unit);
+			if (written == MFRC522::STATUS_OK) {
+				next->dirty &= ~(1 << unit);
+				result.written++;
+				continue;
+			}
+			if (result.failed++ == 0) {
+				result.firstFailed = next->address + unit;
+				status = written;
+			}
+		}
+	}
+	result.authentications = _authentications - authentications;
+	*report = result;
+	return status;
+} // End writeBack()
+
+/**
+ * Returns the line of a block or page, fetched from the PICC if needed.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522BlockCache::fetch(	byte address,	///< The block or page
+												Line **line		///< Out: The line
+											) {
+	const byte base = lineAddress(address);
+	Line *found = nullptr;
+	for (byte i = 0; i < _lineCount; i++) {
+		if (_lines[i].age < 0xFF) {
+			_lines[i].age++;
+		}
+		if (_lines[i].address == base) {
+			found = &_lines[i];
+		}
+	}
+	if (found != nullptr) {
+		found->age = 0;
+		*line = found;
+		return MFRC522::STATUS_OK;
+	}
+
+	// A free line, or the least recently used clean one. Flush if all are dirty.
+	MFRC522::StatusCode status;
+	if (_lineCount < MFRC522_BLOCKCACHE_LINES) {
+		found = &_lines[_lineCount];
+	}
+	else {
+		if (!hasClean()) {
+			// The next flush() reports what is written here. Failed units stay dirty, it retries and counts them.
+			FlushReport report;
+			status = writeBack(&report);
+			_pending.written += report.written;
+			_pending.authentications += report.authentications;
+			if (status != MFRC522::STATUS_OK) {
+				return status;
+			}
+		}
+		for (byte i = 0; i < _lineCount; i++) {
+			if (!_lines[i].dirty && (found == nullptr || _lines[i].age > found->age)) {
+				found = &_lines[i];
+			}
+		}
+	}
+
+	// Fill it. A READ returns one MIFARE Classic block or four pages.
+	if (_classic && (status = authenticate(MFRC522::MIFARE_SectorOf(base))) != MFRC522::STATUS_OK) {
+		return status;
+	}
+	byte buffer[18];
+	byte size = sizeof(buffer);
+	status = _reader.MIFARE_Read(base, buffer, &size);
+	if (status != MFRC522::STATUS_OK) {
+		_authSector = NO_SECTOR;
+		_reader.PICC_Reactivate(&_reader.uid);	// A NAK sends the PICC to IDLE
+		return status;
+	}
+	if (found == &_lines[_lineCount]) {
+		_lineCount++;
+	}
+	found->address = base;
+	found->dirty = 0;
+	found->age = 0;
+	memcpy(found->data, buffer, sizeof(found->data));
+	*line = found;
+	return status;
+} // End fetch()
+
+/**
+ * Authenticates a MIFARE Classic sector unless it is the sector authenticated last.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522BlockCache::authenticate(byte sector	///< The sector
+													) {
+	if (sector == _authSector) {
+		return MFRC522::STATUS_OK;
+	}
+	MFRC522::StatusCode status;
+	_authentications++;
+	if (_search != nullptr) {
+		status = _search->authenticate(sector);			// Reactivates the PICC after a wrong key itself
+	}
+	else {
+		status = _reader.PCD_Authenticate(_command, MFRC522::MIFARE_FirstBlock(sector), &_key, &_reader.uid);
+		if (status != MFRC522::STATUS_OK) {
+			_reader.PICC_Reactivate(&_reader.uid);
+		}
+	}
+	_authSector = (status == MFRC522::STATUS_OK) ? sector : NO_SECTOR;
+	return status;
+} // End authenticate()
+
+/**
+ * Writes one block or page of a line to the PICC.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522BlockCache::writeUnit(	Line *line,	///< The line
+													byte unit	///< The page in the line, 0 for a block
+												) {
+	MFRC522::StatusCode status;
+	if (_classic) {
+		status = authenticate(MFRC522::MIFARE_SectorOf(line->address));
+		if (status != MFRC522::STATUS_OK) {
+			return status;
+		}
+		status = _reader.MIFARE_Write(line->address, line->data, sizeof(line->data));
+	}
+	else {
+		status = _reader.MIFARE_Ultralight_Write(line->address + unit, &line->data[4 * unit], 4);
+	}
+	if (status != MFRC522::STATUS_OK) {
+		_authSector = NO_SECTOR;
+		_reader.PICC_Reactivate(&_reader.uid);	// A NAK sends the PICC to IDLE
+	}
+	return status;
+} // End writeUnit()
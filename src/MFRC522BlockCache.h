@@ -0,0 +1,93 @@
+/**
+ * Write-back cache of the blocks of a MIFARE Classic or pages of a MIFARE Ultralight / NTAG PICC.
+ *
+ * Read and write through the cache for the whole session with a PICC, then flush it:
+ * 		MFRC522BlockCache cache(mfrc522);
+ * 		...
+ * 		if (mfrc522.PICC_IsNewCardPresent() && mfrc522.PICC_ReadCardSerial()) {
+ * 			cache.begin();							// Uses mfrc522.uid
+ * 			cache.setKey(MFRC522::PICC_CMD_MF_AUTH_KEY_A, &key);
+ * 			cache.read(4, buffer);					// Fetched from the PICC
+ * 			buffer[0]++;
+ * 			cache.write(4, buffer);					// Only marked dirty
+ * 			cache.read(4, buffer);					// Served from the cache
+ * 			cache.flush(&report);					// One authentication per sector, unchanged data is not written
+ * 			mfrc522.PICC_HaltA();
+ * 			mfrc522.PCD_StopCrypto1();
+ * 		}
+ *
+ * The address is a block number (16 bytes) for MIFARE Classic and a page number (4 bytes) for MIFARE Ultralight
+ * and NTAG. The cache holds MFRC522_BLOCKCACHE_LINES lines of 16 bytes, one block or four pages that a single READ
+ * returns. Each line takes 19 bytes of RAM.
+ *
+ * A write of the data the cache already holds is skipped. A line is fetched before the first write to it, so
+ * unchanged data is never written to the PICC. Data changed and changed back within a session is written.
+ * When all lines are dirty, a read or write of a new line flushes the cache first.
+ *
+ * MIFARE Classic sectors are authenticated with the key from setKey(), or with a MFRC522KeySearch. The cache
+ * remembers the authenticated sector, so do not talk to the PICC directly between begin() and the last flush().
+ */
+#ifndef MFRC522BlockCache_h
+#define MFRC522BlockCache_h
+
+#include "MFRC522.h"
+
+class MFRC522KeySearch;
+
+#ifndef MFRC522_BLOCKCACHE_LINES
+#define MFRC522_BLOCKCACHE_LINES 8				// Lines of 16 bytes
+#endif
+
+class MFRC522BlockCache {
+public:
+	static constexpr byte NO_SECTOR = 0xFF;
+
+	// Result of a flush(), and of the writes since begin() or the last flush()
+	typedef struct {
+		byte written;				// Blocks or pages written to the PICC
+		byte skipped;				// Blocks or pages not written because their data did not change
+		byte failed;				// Blocks or pages that could not be written, they stay dirty
+		byte firstFailed;			// Address of the first of them
+		byte authentications;		// MIFARE Classic authentications done for the flush
+	} FlushReport;
+
+	MFRC522BlockCache(MFRC522 &reader);
+
+	MFRC522::StatusCode begin();
+	void setKey(byte command, MFRC522::MIFARE_Key *key);
+	void setKeySearch(MFRC522KeySearch *search);
+	MFRC522::StatusCode read(byte address, byte *buffer);
+	MFRC522::StatusCode write(byte address, const byte *buffer);
+	MFRC522::StatusCode flush(FlushReport *report = nullptr);
+	void invalidate();
+	bool isDirty() const;
+
+protected:
+	typedef struct {
+		byte address;				// First block or page of the line
+		byte dirty;					// Bit n set => unit n (a page, bit 0 for a block) differs from the PICC
+		byte age;					// Accesses since the last use, for the replacement
+		byte data[16];
+	} Line;
+
+	MFRC522 &_reader;
+	MFRC522KeySearch *_search;
+	MFRC522::MIFARE_Key _key;
+	byte _command;
+	bool _classic;					// MIFARE Classic blocks, else Ultralight pages
+	byte _lineCount;				// Used lines
+	byte _authSector;				// Sector authenticated, NO_SECTOR if none
+	FlushReport _pending;			// Skipped writes and write-backs of fetch() since the last flush()
+	byte _authentications;			// Authentications since begin()
+	Line _lines[MFRC522_BLOCKCACHE_LINES];
+
+	bool hasClean() const;
+	MFRC522::StatusCode writeBack(FlushReport *report);
+	MFRC522::StatusCode fetch(byte address, Line **line);
+	MFRC522::StatusCode authenticate(byte sector);
+	MFRC522::StatusCode writeUnit(Line *line, byte unit);
+	byte lineAddress(byte address) const { return _classic ? address : address & ~0x03; };
+	byte unitSize() const { return _classic ? 16 : 4; };
+};
+
+#endif
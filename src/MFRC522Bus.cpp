@@ -0,0 +1,76 @@
+/*
+ * Register I/O transports for the MFRC522 class.
+ */
+#include "MFRC522Bus.h"
+
+/**
+ * Returns the time base the MFRC522 class uses for its timeouts.
+ */
+uint32_t MFRC522Bus::now() {
+	return micros();
+} // End now()
+
+/**
+ * Waits for the MFRC522, eg for the oscillator to start after a reset.
+ */
+void MFRC522Bus::wait(uint32_t us) {
+	delay(us / 1000);
+	delayMicroseconds(us % 1000);
+} // End wait()
+
+/**
+ * Constructor.
+ * Uses the global SPI object.
+ */
+MFRC522SPIBus::MFRC522SPIBus(	byte chipSelectPin	///< Arduino pin connected to MFRC522's SPI slave select input (Pin 24, NSS, active low)
+							): MFRC522SPIBus(SPI, chipSelectPin) {
+} // End constructor
+
+/**
+ * Constructor.
+ * The SPIClass must be initialised with begin() by the sketch, as with the global SPI object.
+ */
+MFRC522SPIBus::MFRC522SPIBus(	SPIClass &spi,			///< The SPI controller the MFRC522 is connected to
+								byte chipSelectPin,		///< Arduino pin connected to MFRC522's SPI slave select input (Pin 24, NSS, active low)
+								uint32_t clock			///< SPI clock. The MFRC522 accepts up to 10MHz.
+							) {
+	_spi = &spi;
+	_chipSelectPin = chipSelectPin;
+	_clock = clock;
+} // End constructor
+
+/**
+ * Changes the chip select pin. Call begin() afterwards.
+ */
+void MFRC522SPIBus::setChipSelectPin(	byte chipSelectPin	///< Arduino pin connected to MFRC522's SPI slave select input (Pin 24, NSS, active low)
+									) {
+	_chipSelectPin = chipSelectPin;
+} // End setChipSelectPin()
+
+/**
+ * Sets the chipSelectPin as digital output, do not select the slave yet.
+ */
+void MFRC522SPIBus::begin() {
+	pinMode(_chipSelectPin, OUTPUT);
+	digitalWrite(_chipSelectPin, HIGH);
+} // End begin()
+
+void MFRC522SPIBus::beginTransaction() {
+	_spi->beginTransaction(SPISettings(_clock, MSBFIRST, SPI_MODE0));	// Set the settings to work with SPI bus
+} // End beginTransaction()
+
+void MFRC522SPIBus::endTransaction() {
+	_spi->endTransaction(); // Stop using the SPI bus
+} // End endTransaction()
+
+void MFRC522SPIBus::select() {
+	digitalWrite(_chipSelectPin, LOW);		// Select slave
+} // End select()
+
+void MFRC522SPIBus::deselect() {
+	digitalWrite(_chipSelectPin, HIGH);		// Release slave again
+} // End deselect()
+
+byte MFRC522SPIBus::transfer(byte data) {
+	return _spi->transfer(data);
+} // End transfer()
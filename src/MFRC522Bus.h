@@ -0,0 +1,61 @@
+/**
+ * Register I/O transports for the MFRC522 class.
+ *
+ * The MFRC522 talks to the chip through a MFRC522Bus. The bus only moves bytes; the MFRC522 class builds the
+ * SPI address bytes described in section 8.1.2 of the datasheet itself, so every transport sees the same traffic.
+ *
+ * MFRC522SPIBus	Hardware SPI. Uses the global SPI object unless another SPIClass is supplied. This is the default.
+ * MFRC522MockBus	In-memory register file for the host build, see extras/host/MFRC522MockBus.h.
+ * MFRC522Simulator	Timed model of the chip and PICCs in its field for the host build, see extras/host/MFRC522Simulator.h.
+ *
+ * A transport is chosen at construction time:
+ * 		MFRC522 mfrc522(SS_PIN, RST_PIN);				// Hardware SPI on the global SPI object
+ * 		MFRC522SPIBus bus(SPI1, SS_PIN);				// Hardware SPI on a second controller
+ * 		MFRC522 mfrc522(bus, RST_PIN);
+ */
+#ifndef MFRC522Bus_h
+#define MFRC522Bus_h
+
+#include <stdint.h>
+#include <Arduino.h>
+#include <SPI.h>
+
+#ifndef MFRC522_SPICLOCK
+#define MFRC522_SPICLOCK SPI_CLOCK_DIV4			// MFRC522 accept upto 10MHz
+#endif
+
+class MFRC522Bus {
+public:
+	virtual ~MFRC522Bus() {};
+
+	virtual void begin() {};						// Prepares pins. Called from MFRC522::PCD_Init().
+	virtual void beginTransaction() = 0;			// Claims the bus for one or more frames
+	virtual void endTransaction() = 0;				// Releases the bus
+	virtual void select() = 0;						// Starts a frame, ie asserts NSS
+	virtual void deselect() = 0;					// Ends a frame, ie releases NSS
+	virtual byte transfer(byte data) = 0;			// Exchanges one byte within a frame
+	virtual uint32_t now();							// Time base for timeouts in μs, micros() unless the transport simulates time
+	virtual void wait(uint32_t us);					// Blocks for the given time, delay() unless the transport simulates time
+};
+
+class MFRC522SPIBus : public MFRC522Bus {
+public:
+	MFRC522SPIBus(byte chipSelectPin);
+	MFRC522SPIBus(SPIClass &spi, byte chipSelectPin, uint32_t clock = MFRC522_SPICLOCK);
+
+	void setChipSelectPin(byte chipSelectPin);
+
+	void begin() override;
+	void beginTransaction() override;
+	void endTransaction() override;
+	void select() override;
+	void deselect() override;
+	byte transfer(byte data) override;
+
+protected:
+	SPIClass *_spi;
+	byte _chipSelectPin;		// Arduino pin connected to MFRC522's SPI slave select input (Pin 24, NSS, active low)
+	uint32_t _clock;
+};
+
+#endif
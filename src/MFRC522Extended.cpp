@@ -17,7 +17,7 @@
  * 		double				 7						2				MIFARE Ultralight
  * 		triple				10						3				Not currently in use?
  * 
- * @return STATUS_OK on success, STATUS_??? otherwise.
+ * @return STATUS_OK on success, STATUS_FIELD_RESET if an ISO/IEC 14443-4 PICC is active after a reset of the field, STATUS_??? otherwise.
  */
 MFRC522::StatusCode MFRC522Extended::PICC_Select(	Uid *uid,			///< Pointer to Uid struct. Normally output, but can also be used to supply a known UID.
 											byte validBits		///< The number of known UID bits supplied in *uid. Normally 0. If set you must also supply uid->size.
@@ -158,7 +158,7 @@ MFRC522::StatusCode MFRC522Extended::PICC_Select(	Uid *uid,			///< Pointer to Ui
 			PCD_WriteRegister(BitFramingReg, (rxAlign << 4) + txLastBits);	// RxAlign = BitFramingReg[6..4]. TxLastBits = BitFramingReg[2..0]
 			
 			// Transmit the buffer and receive the response.
-			result = PCD_TransceiveData(buffer, bufferUsed, responseBuffer, &responseLength, &txLastBits, rxAlign);
+			result = PCD_TransceiveData(buffer, bufferUsed, responseBuffer, &responseLength, &txLastBits, rxAlign, false, TIMEOUT_ANTICOLLISION);
 			if (result == STATUS_COLLISION) { // More than one PICC in the field => collision.
 				byte valueOfCollReg = PCD_ReadRegister(CollReg); // CollReg[7..0] bits are: ValuesAfterColl reserved CollPosNotValid CollPos[4:0]
 				if (valueOfCollReg & 0x20) { // CollPosNotValid
@@ -230,111 +230,109 @@ MFRC522::StatusCode MFRC522Extended::PICC_Select(	Uid *uid,			///< Pointer to Ui
 	// A Request ATS command should be sent
 	// We also check SAK bit 3 is cero, as it stands for UID complete (1 would tell us it is incomplete)
 	if ((uid->sak & 0x24) == 0x20) {
-		Ats ats;
-		result = PICC_RequestATS(&ats);
-		if (result == STATUS_OK) {
-			// Check the ATS
-			if (ats.size > 0)
-			{
-				// TA1 has been transmitted?
-				// PPS must be supported...
-				if (ats.ta1.transmitted)
-				{
-					// TA1
-					//  8 | 7 | 6 | 5 | 4 | 3 | 2 | 1 | Description
-					// ---+---+---+---+---+---+---+---+------------------------------------------
-					//  0 | - | - | - | 0 | - | - | - | Different D for each direction supported
-					//  1 | - | - | - | 0 | - | - | - | Only same D for both direction supported
-					//  - | x | x | x | 0 | - | - | - | DS (Send D)
-					//  - | - | - | - | 0 | x | x | x | DR (Receive D)
-					//
-					// D to bitrate table
-					//  3 | 2 | 1 | Value
-					// ---+---+---+-----------------------------
-					//  1 | - | - | 848 kBaud is supported
-					//  - | 1 | - | 424 kBaud is supported
-					//  - | - | 1 | 212 kBaud is supported
-					//  0 | 0 | 0 | Only 106 kBaud is supported
-					//
-					// Note: 106 kBaud is always supported
-					//
-					// I have almost constant timeouts when changing speeds :(
-					// default never used, so only delarate
-					//TagBitRates ds = BITRATE_106KBITS; 
-					//TagBitRates dr = BITRATE_106KBITS;
-					TagBitRates ds;
-					TagBitRates dr;
-					
-					//// TODO Not working at 848 or 424
-					//if (ats.ta1.ds & 0x04) 
-					//{
-					//	ds = BITRATE_848KBITS;
-					//} 
-					//else if (ats.ta1.ds & 0x02)
-					//{
-					//	ds = BITRATE_424KBITS;
-					//}
-					//else if (ats.ta1.ds & 0x01)
-					//{
-					//	ds = BITRATE_212KBITS;
-					//}
-					//else 
-					//{
-					//	ds = BITRATE_106KBITS;
-					//}
-
-					if (ats.ta1.ds & 0x01)
-					{
-						ds = BITRATE_212KBITS;
-					}
-					else 
-					{
-						ds = BITRATE_106KBITS;
-					}
+		// The tag member holds the session of PICCs activated by PICC_Select(), with CID 0.
+		if (uid != &tag.uid) {
+			tag.uid = *uid;
+		}
+		return TCL_Activate(&tag, 0);
+	}
 
-					//// Not working at 848 or 424
-					//if (ats.ta1.dr & 0x04) 
-					//{
-					//	dr = BITRATE_848KBITS;
-					//} 
-					//else if (ats.ta1.dr & 0x02)
-					//{
-					//	dr = BITRATE_424KBITS;
-					//}
-					//else if (ats.ta1.dr & 0x01)
-					//{
-					//	dr = BITRATE_212KBITS;
-					//}
-					//else 
-					//{
-					//	dr = BITRATE_106KBITS;
-					//}
-
-					if (ats.ta1.dr & 0x01)
-					{
-						dr = BITRATE_212KBITS;
-					}
-					else
-					{
-						dr = BITRATE_106KBITS;
-					}
+	return STATUS_OK;
+} // End PICC_Select()
 
-					PICC_PPS(ds, dr);
+/**
+ * Selects a PICC and, if it is an ISO/IEC 14443-4 PICC, activates it with the given CID.
+ * Before calling this function the PICC must be placed in the READY(*) state, eg by PICC_IsNewCardPresent().
+ * Every activated PICC keeps its own session in its TagInfo: CID, block number, frame size, FWT and bit rates.
+ * The T=CL functions address the PICC by its CID, so several PICCs with different CIDs can be active at once and
+ * their exchanges interleaved. An active PICC does not answer REQA, so PICC_IsNewCardPresent() finds the next one.
+ * A PICC without CID support (TC1) ignores the CID and can only be active alone. PICC_Select() uses CID 0.
+ * If a PICC fails after PPS, the field is reset (see PCD_SetMaxBitRate()), which ends all other sessions.
+ *
+ * @return STATUS_OK on success, STATUS_FIELD_RESET if the PICC is active after a reset of the field, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::PICC_Activate(	TagInfo *tag,	///< Out: The UID and, for ISO/IEC 14443-4, the session of the PICC
+													byte cid		///< Card identifier, 0 to 14, not used by another active PICC
+												) {
+	if (cid > 14) {
+		return STATUS_INVALID;	// CID 15 is RFU
+	}
+	MFRC522::StatusCode result = MFRC522::PICC_Select(&tag->uid);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	if ((tag->uid.sak & 0x24) != 0x20) {
+		return STATUS_OK;		// Not ISO/IEC 14443-4
+	}
+	return TCL_Activate(tag, cid);
+} // End PICC_Activate()
+
+/**
+ * Activates a selected ISO/IEC 14443-4 PICC: RATS with the CID, then PPS to the fastest common bit rates.
+ * A PICC that does not answer after PPS is reset with the field and activated again at 106 kbit/s. The reset also
+ * ends the sessions of all other PICCs, so it is reported as STATUS_FIELD_RESET instead of STATUS_OK.
+ *
+ * @return STATUS_OK on success, STATUS_FIELD_RESET if the PICC is active after a reset of the field, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::TCL_Activate(	TagInfo *tag,	///< The selected PICC, with its UID. Out: Its session.
+													byte cid		///< Card identifier, 0 to 14
+												) {
+	// The ATS is kept for the T=CL functions, the PCD block number starts with 0 after activation.
+	Ats &ats = tag->ats;
+	tag->cid = cid;
+	tag->blockNumber = false;
+	tag->ds = BITRATE_106KBITS;
+	tag->dr = BITRATE_106KBITS;
+	MFRC522::StatusCode result = PICC_RequestATS(&ats, cid);
+	tag->fwt = TCL_FrameWaitingTime(ats.tb1.fwi);
+	if (result == STATUS_OK && ats.size > 0 && ats.ta1.transmitted) {
+		// Escalate to the fastest bit rates both the PICC (TA1) and the PCD (PCD_SetMaxBitRate()) support.
+		// With sameD only a bit rate the PICC offers in both directions will do.
+		TagBitRates ds = TCL_FastestBitRate(ats.ta1.ds);
+		TagBitRates dr = TCL_FastestBitRate(ats.ta1.dr);
+		if (ats.ta1.sameD) {
+			ds = dr = TCL_FastestBitRate(ats.ta1.ds & ats.ta1.dr);
+		}
+		if ((ds != BITRATE_106KBITS || dr != BITRATE_106KBITS) && PICC_PPS(ds, dr, cid) == STATUS_OK) {
+			tag->ds = ds;
+			tag->dr = dr;
+			if (TCL_PresenceCheck(tag) != STATUS_OK) {
+				// The PICC does not answer at the new bit rates. There is no way back to 106 kbit/s but a reset:
+				// switch the field off and activate the PICC again without PPS.
+				TagBitRates maxBitRate = _maxBitRate;
+				_maxBitRate = BITRATE_106KBITS;
+				PCD_ResetBitRate();
+				PCD_AntennaOff();
+				PCD_Bus().wait(5000);		// At least 5ms without field reset the PICC
+				PCD_AntennaOn();
+				PCD_Bus().wait(5000);		// The PICC must answer 5ms after the field is switched on
+				byte bufferATQA[2];
+				byte bufferSize = sizeof(bufferATQA);
+				result = PICC_WakeupA(bufferATQA, &bufferSize);
+				if (result == STATUS_OK) {
+					result = MFRC522::PICC_Select(&tag->uid, tag->uid.size * 8);
+				}
+				if (result == STATUS_OK) {
+					result = TCL_Activate(tag, cid);
 				}
+				if (result == STATUS_OK) {
+					result = STATUS_FIELD_RESET;
+				}
+				_maxBitRate = maxBitRate;
 			}
 		}
 	}
-
-	return STATUS_OK;
-} // End PICC_Select()
+	return result;
+} // End TCL_Activate()
 
 /**
  * Transmits a Request command for Answer To Select (ATS).
  *
  * @return STATUS_OK on success, STATUS_??? otherwise.
  */
-MFRC522::StatusCode MFRC522Extended::PICC_RequestATS(Ats *ats) 
-{
+MFRC522::StatusCode MFRC522Extended::PICC_RequestATS(Ats *ats,		///< Out: The ATS
+														byte cid		///< Card identifier the PICC gets, 0 to 14
+) {
 	// TODO unused variable
 	//byte count;
 	MFRC522::StatusCode result;
@@ -356,7 +354,11 @@ MFRC522::StatusCode MFRC522Extended::PICC_RequestATS(Ats *ats)
 	// ------------+-----+-----+-----+-----+-----+-----+-----+-----+-----+-----------
 	// FSD (bytes) |  16 |  24 |  32 |  40 |  48 |  64 |  96 | 128 | 256 | RFU > 256
 	//
-	bufferATS[1] = 0x50; // FSD=64, CID=0
+	byte fsdi = 0;
+	while (fsdi < 8 && TCL_FrameSize(fsdi + 1) <= MFRC522_TCL_FRAME_SIZE) {
+		fsdi++;
+	}
+	bufferATS[1] = (fsdi << 4) | (cid & 0x0F); // FSD=MFRC522_TCL_FRAME_SIZE
 
 	// Calculate CRC_A
 	result = PCD_CalculateCRC(bufferATS, 2, &bufferATS[2]);
@@ -365,7 +367,7 @@ MFRC522::StatusCode MFRC522Extended::PICC_RequestATS(Ats *ats)
 	}
 
 	// Transmit the buffer and receive the response, validate CRC_A.
-	result = PCD_TransceiveData(bufferATS, 4, bufferATS, &bufferSize, NULL, 0, true);
+	result = PCD_TransceiveData(bufferATS, 4, bufferATS, &bufferSize, NULL, 0, true, TIMEOUT_ISO_DEP);
 	if (result != STATUS_OK) {
 		PICC_HaltA();
 	}
@@ -396,41 +398,7 @@ MFRC522::StatusCode MFRC522Extended::PICC_RequestATS(Ats *ats)
 		ats->tc1.transmitted = (bool)(bufferATS[1] & 0x10);
 
 		// Decode FSCI
-		switch (bufferATS[1] & 0x0F)
-		{
-			case 0x00:
-				ats->fsc = 16;
-				break;
-			case 0x01:
-				ats->fsc = 24;
-				break;
-			case 0x02:
-				ats->fsc = 32;
-				break;
-			case 0x03:
-				ats->fsc = 40;
-				break;
-			case 0x04:
-				ats->fsc = 48;
-				break;
-			case 0x05:
-				ats->fsc = 64;
-				break;
-			case 0x06:
-				ats->fsc = 96;
-				break;
-			case 0x07:
-				ats->fsc = 128;
-				break;
-			case 0x08:
-				// This value cannot be hold by a byte
-				// The reason I ignore it is that MFRC255 FIFO is 64 bytes so this is not a possible value (or atleast it shouldn't)
-				//ats->fsc = 256;
-				break;
-				// TODO: What to do with RFU (Reserved for future use)?
-			default:
-				break;
-		}
+		ats->fsc = TCL_FrameSize(bufferATS[1] & 0x0F);
 
 		// TA1
 		if (ats->ta1.transmitted)
@@ -460,7 +428,7 @@ MFRC522::StatusCode MFRC522Extended::PICC_RequestATS(Ats *ats)
 		else
 		{
 			// Defaults for TB1
-			ats->tb1.fwi = 0;	// TODO: Don't know the default for this!
+			ats->tb1.fwi = 4;	// The default value of FWI is 4 (FWT = 4.8ms)
 			ats->tb1.sfgi = 0;	// The default value of SFGI is 0 (meaning that the card does not need any particular SFGT)
 		}
 
@@ -501,7 +469,7 @@ MFRC522::StatusCode MFRC522Extended::PICC_RequestATS(Ats *ats)
 
 		// Defaults for TB1
 		ats->tb1.transmitted = false;
-		ats->tb1.fwi = 0;	// TODO: Don't know the default for this!
+		ats->tb1.fwi = 4;	// The default value of FWI is 4 (FWT = 4.8ms)
 		ats->tb1.sfgi = 0;	// The default value of SFGI is 0 (meaning that the card does not need any particular SFGT)
 
 		// Defaults for TC1
@@ -520,8 +488,8 @@ MFRC522::StatusCode MFRC522Extended::PICC_RequestATS(Ats *ats)
  *
  * @return STATUS_OK on success, STATUS_??? otherwise.
  */
-MFRC522::StatusCode MFRC522Extended::PICC_PPS()
-{
+MFRC522::StatusCode MFRC522Extended::PICC_PPS(byte cid		///< CID of the PICC, as sent in RATS
+) {
 	StatusCode result;
 
 	byte ppsBuffer[4];
@@ -529,7 +497,7 @@ MFRC522::StatusCode MFRC522Extended::PICC_PPS()
 	// Start byte: The start byte (PPS) consists of two parts:
 	//  –The upper nibble(b8–b5) is set to’D'to identify the PPS. All other values are RFU.
 	//  -The lower nibble(b4–b1), which is called the ‘card identifier’ (CID), defines the logical number of the addressed card.
-	ppsBuffer[0] = 0xD0;	// CID is hardcoded as 0 in RATS
+	ppsBuffer[0] = 0xD0 | (cid & 0x0F);
 	ppsBuffer[1] = 0x00;	// PPS0 indicates whether PPS1 is present
 
 	// Calculate CRC_A
@@ -539,7 +507,7 @@ MFRC522::StatusCode MFRC522Extended::PICC_PPS()
 	}
 
 	// Transmit the buffer and receive the response, validate CRC_A.
-	result = PCD_TransceiveData(ppsBuffer, 4, ppsBuffer, &ppsBufferSize, NULL, 0, true);
+	result = PCD_TransceiveData(ppsBuffer, 4, ppsBuffer, &ppsBufferSize, NULL, 0, true, TIMEOUT_ISO_DEP);
 	if (result == STATUS_OK)
 	{
 		// Enable CRC for T=CL
@@ -559,7 +527,8 @@ MFRC522::StatusCode MFRC522Extended::PICC_PPS()
  * @return STATUS_OK on success, STATUS_??? otherwise.
  */
 MFRC522::StatusCode MFRC522Extended::PICC_PPS(TagBitRates sendBitRate,	          ///< DS
-                                      TagBitRates receiveBitRate		  ///< DR
+                                      TagBitRates receiveBitRate,		  ///< DR
+                                      byte cid							  ///< CID of the PICC, as sent in RATS
 ) {
 	StatusCode result;
 
@@ -572,13 +541,12 @@ MFRC522::StatusCode MFRC522Extended::PICC_PPS(TagBitRates sendBitRate,
 	// Start byte: The start byte (PPS) consists of two parts:
 	//  –The upper nibble(b8–b5) is set to’D'to identify the PPS. All other values are RFU.
 	//  -The lower nibble(b4–b1), which is called the ‘card identifier’ (CID), defines the logical number of the addressed card.
-	ppsBuffer[0] = 0xD0;	// CID is hardcoded as 0 in RATS
+	ppsBuffer[0] = 0xD0 | (cid & 0x0F);
 	ppsBuffer[1] = 0x11;	// PPS0 indicates whether PPS1 is present
 
-	// Bit 8 - Set to '0' as MFRC522 allows different bit rates for send and receive
-	// Bit 4 - Set to '0' as it is Reserved for future use.
-	//ppsBuffer[2] = (((sendBitRate & 0x03) << 4) | (receiveBitRate & 0x03)) & 0xE7;
-	ppsBuffer[2] = (((sendBitRate & 0x03) << 2) | (receiveBitRate & 0x03)) & 0xE7;
+	// PPS1: bits 8..5 are RFU and set to '0', bits 4..3 are DSI, bits 2..1 are DRI.
+	// Masking bit 4 would turn DSI 424 and 848 kbit/s into 106 and 212 kbit/s.
+	ppsBuffer[2] = ((sendBitRate & 0x03) << 2) | (receiveBitRate & 0x03);
 
 	// Calculate CRC_A
 	result = PCD_CalculateCRC(ppsBuffer, 3, &ppsBuffer[3]);
@@ -587,12 +555,12 @@ MFRC522::StatusCode MFRC522Extended::PICC_PPS(TagBitRates sendBitRate,
 	}
 	
 	// Transmit the buffer and receive the response, validate CRC_A.
-	result = PCD_TransceiveData(ppsBuffer, 5, ppsBuffer, &ppsBufferSize, NULL, 0, true);
+	result = PCD_TransceiveData(ppsBuffer, 5, ppsBuffer, &ppsBufferSize, NULL, 0, true, TIMEOUT_ISO_DEP);
 	if (result == STATUS_OK)
 	{
 		// Make sure it is an answer to our PPS
 		// We should receive our PPS byte and 2 CRC bytes
-		if ((ppsBufferSize == 3) && (ppsBuffer[0] == 0xD0)) {
+		if ((ppsBufferSize == 3) && (ppsBuffer[0] == (0xD0 | (cid & 0x0F)))) {
 			byte txReg = PCD_ReadRegister(TxModeReg) & 0x8F;
 			byte rxReg = PCD_ReadRegister(RxModeReg) & 0x8F;
 
@@ -607,8 +575,8 @@ MFRC522::StatusCode MFRC522Extended::PICC_PPS(TagBitRates sendBitRate,
 			PCD_WriteRegister(TxModeReg, txReg);
 			PCD_WriteRegister(RxModeReg, rxReg);
 
-			// At 212kBps
-			switch (sendBitRate) {
+			// The modulation width follows the bit rate PCD to PICC
+			switch (receiveBitRate) {
 				case BITRATE_212KBITS:
 					{
 						//PCD_WriteRegister(ModWidthReg, 0x13);
@@ -651,13 +619,19 @@ MFRC522::StatusCode MFRC522Extended::PICC_PPS(TagBitRates sendBitRate,
 // Functions for communicating with ISO/IEC 14433-4 cards
 /////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Exchanges one block with the PICC. Blocks that do not fit into the FIFO are streamed, see PCD_TransceiveStream().
+ * The PICC must answer within the TIMEOUT_FWT timeout, see TCL_TransceiveBlock().
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
 MFRC522::StatusCode MFRC522Extended::TCL_Transceive(PcbBlock *send, PcbBlock *back)
 {
 	MFRC522::StatusCode result;
-	byte inBuffer[FIFO_SIZE];
-	byte inBufferSize = FIFO_SIZE;
+	byte inBuffer[MFRC522_TCL_FRAME_SIZE];
+	uint16_t inBufferSize = sizeof(inBuffer);
 	byte outBuffer[send->inf.size + 5]; // PCB + CID + NAD + INF + EPILOGUE (CRC)
-	byte outBufferOffset = 1;
+	uint16_t outBufferOffset = 1;
 	byte inBufferOffset = 1;
 
 	// Set the PCB byte
@@ -681,24 +655,34 @@ MFRC522::StatusCode MFRC522Extended::TCL_Transceive(PcbBlock *send, PcbBlock *ba
 		outBufferOffset += send->inf.size;
 	}
 
-	// Is the CRC enabled for transmission?
-	byte txModeReg = PCD_ReadRegister(TxModeReg);
-	if ((txModeReg & 0x80) != 0x80) {
-		// Calculate CRC_A
-		result = PCD_CalculateCRC(outBuffer, outBufferOffset, &outBuffer[outBufferOffset]);
-		if (result != STATUS_OK) {
-			return result;
-		}
-
-		outBufferOffset += 2;
+	// Is the CRC enabled for transmission? PICC_PPS() enables it in both directions.
+	if ((PCD_ShadowedValue(TxModeReg) & 0x80) != 0x80) {
+		uint16_t crc = CRC_Calculate(outBuffer, outBufferOffset);
+		outBuffer[outBufferOffset++] = crc & 0xFF;
+		outBuffer[outBufferOffset++] = crc >> 8;
 	}
+	bool checkCRC = (PCD_ShadowedValue(RxModeReg) & 0x80) != 0x80;
 
 	// Transceive the block
-	result = PCD_TransceiveData(outBuffer, outBufferOffset, inBuffer, &inBufferSize);
+	if (outBufferOffset <= FIFO_SIZE && inBufferSize <= FIFO_SIZE) {
+		byte size = inBufferSize;
+		result = PCD_TransceiveData(outBuffer, outBufferOffset, inBuffer, &size, NULL, 0, checkCRC, TIMEOUT_FWT);
+		inBufferSize = size;
+	} else {
+		result = PCD_TransceiveStream(outBuffer, outBufferOffset, inBuffer, &inBufferSize, NULL, checkCRC, TIMEOUT_FWT);
+	}
 	if (result != STATUS_OK) {
 		return result;
 	}
 
+	// Take away the CRC bytes if the MFRC522 did not
+	if (checkCRC) {
+		inBufferSize -= 2;
+	}
+	if (inBufferSize < 1) {
+		return STATUS_ERROR;
+	}
+
 	// We want to turn the received array back to a PcbBlock
 	back->prologue.pcb = inBuffer[0];
 
@@ -714,33 +698,6 @@ MFRC522::StatusCode MFRC522Extended::TCL_Transceive(PcbBlock *send, PcbBlock *ba
 		inBufferOffset++;
 	}
 
-	// Check if CRC is taken care of by MFRC522
-	byte rxModeReg = PCD_ReadRegister(TxModeReg);
-	if ((rxModeReg & 0x80) != 0x80) {
-		Serial.print("CRC is not taken care of by MFRC522: ");
-		Serial.println(rxModeReg, HEX);
-
-		// Check the CRC
-		// We need at least the CRC_A value.
-		if ((int)(inBufferSize - inBufferOffset) < 2) {
-			return STATUS_CRC_WRONG;
-		}
-
-		// Verify CRC_A - do our own calculation and store the control in controlBuffer.
-		byte controlBuffer[2];
-		MFRC522::StatusCode status = PCD_CalculateCRC(inBuffer, inBufferSize - 2, controlBuffer);
-		if (status != STATUS_OK) {
-			return status;
-		}
-
-		if ((inBuffer[inBufferSize - 2] != controlBuffer[0]) || (inBuffer[inBufferSize - 1] != controlBuffer[1])) {
-			return STATUS_CRC_WRONG;
-		}
-
-		// Take away the CRC bytes
-		inBufferSize -= 2;
-	}
-
 	// Got more data?
 	if (inBufferSize > inBufferOffset) {
 		if ((inBufferSize - inBufferOffset) > back->inf.size) {
@@ -754,99 +711,407 @@ MFRC522::StatusCode MFRC522Extended::TCL_Transceive(PcbBlock *send, PcbBlock *ba
 	}
 
 	// If the response is a R-Block check NACK
-	if (((inBuffer[0] & 0xC0) == 0x80) && (inBuffer[0] & 0x20)) {
+	if (((inBuffer[0] & 0xE6) == 0xA2) && (inBuffer[0] & 0x10)) {
 		return STATUS_MIFARE_NACK;
 	}
 	
 	return result;
-}
+} // End TCL_Transceive()
+
 /**
- * Send an I-Block (Application)
+ * Exchanges one block with an activated PICC within its frame waiting time.
+ * The MFRC522 timer is programmed with the FWT of the PICC, see TCL_FrameWaitingTime(). A PICC that needs more
+ * time answers with S(WTX); it gets the requested multiple of FWT for its next block, which may ask again.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
  */
-MFRC522::StatusCode MFRC522Extended::TCL_Transceive(TagInfo *tag, byte *sendData, byte sendLen, byte *backData, byte *backLen)
-{
+MFRC522::StatusCode MFRC522Extended::TCL_TransceiveBlock(	TagInfo *tag,		///< The PICC, activated with PICC_Select()
+															PcbBlock *send,		///< The block to send
+															PcbBlock *back		///< In: Buffer for the INF field. Out: The block received, not S(WTX).
+														) {
+	byte *infData = back->inf.data;
+	byte infSize = back->inf.size;
+	PCD_SetBitRate(tag);
+	PCD_SetTimeout(TIMEOUT_FWT, tag->fwt);
+	MFRC522::StatusCode result = TCL_Transceive(send, back);
+
+	// S(WTX) request: answer with the same WTXM, the timeout is extended for this exchange only.
+	while (result == STATUS_OK && (back->prologue.pcb & 0xF7) == 0xF2 && back->inf.size >= 1) {
+		byte wtxm = back->inf.data[0] & 0x3F;
+		if (wtxm == 0 || wtxm > 59) {
+			return STATUS_ERROR;	// Protocol error, ISO/IEC 14443-4 7.3
+		}
+		byte wtxInf = wtxm;
+		PcbBlock wtx;
+		wtx.prologue.pcb = 0xF2 | (send->prologue.pcb & 0x08);
+		wtx.prologue.cid = send->prologue.cid;
+		wtx.prologue.nad = 0x00;
+		wtx.inf.size = 1;
+		wtx.inf.data = &wtxInf;
+		back->inf.data = infData;
+		back->inf.size = infSize;
+
+		// FWT_TEMP = FWT * WTXM, at most FWT_MAX (FWI 14) + ΔFWT
+		uint32_t maxTime = TCL_FrameWaitingTime(14);
+		PCD_SetTimeout(TIMEOUT_FWT, tag->fwt > maxTime / wtxm ? maxTime : tag->fwt * wtxm);
+		result = TCL_Transceive(&wtx, back);
+	}
+	PCD_SetTimeout(TIMEOUT_FWT, tag->fwt);
+	return result;
+} // End TCL_TransceiveBlock()
+
+/**
+ * Exchanges one frame that already holds its prologue, with the CRC_A added and checked by the MFRC522.
+ * Frame waiting time and S(WTX) are handled as in TCL_TransceiveBlock(). Nothing is copied: the frame is sent
+ * from send and the answer is received at back.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::TCL_ExchangeFrame(	TagInfo *tag,		///< The PICC, activated with PICC_Select()
+														byte *send,			///< The frame to send: prologue and INF field
+														uint16_t sendLen,	///< Number of bytes to send
+														byte *back,			///< Buffer for the frame received
+														uint16_t *backLen	///< In: Max number of bytes to write to *back. Out: The number of bytes received, not S(WTX).
+													) {
+	MFRC522::StatusCode result;
+	const uint16_t backSize = *backLen;
+	byte wtx[3];
+
+	PCD_SetBitRate(tag);
+	PCD_SetTimeout(TIMEOUT_FWT, tag->fwt);
+	for (;;) {
+		if (sendLen <= FIFO_SIZE && MFRC522_TCL_FRAME_SIZE <= FIFO_SIZE) {
+			byte size = backSize < FIFO_SIZE ? backSize : FIFO_SIZE;
+			result = PCD_TransceiveData(send, sendLen, back, &size, NULL, 0, false, TIMEOUT_FWT);
+			*backLen = size;
+		} else {
+			*backLen = backSize;
+			result = PCD_TransceiveStream(send, sendLen, back, backLen, NULL, false, TIMEOUT_FWT);
+		}
+		if (result != STATUS_OK) {
+			break;
+		}
+		if (PCD_ReadRegister(ErrorReg) & 0x04) {	// CRCErr, the MFRC522 checked the CRC_A
+			result = STATUS_CRC_WRONG;
+			break;
+		}
+		if (*backLen < 1) {
+			result = STATUS_ERROR;
+			break;
+		}
+
+		// S(WTX) request: answer with the same WTXM, the timeout is extended for this exchange only.
+		byte infOffset = (back[0] & 0x08) ? 2 : 1;
+		if ((back[0] & 0xF7) != 0xF2 || *backLen <= infOffset) {
+			break;
+		}
+		byte wtxm = back[infOffset] & 0x3F;
+		if (wtxm == 0 || wtxm > 59) {
+			result = STATUS_ERROR;	// Protocol error, ISO/IEC 14443-4 7.3
+			break;
+		}
+		wtx[0] = 0xF2 | (send[0] & 0x08);
+		wtx[1] = send[1];
+		sendLen = (send[0] & 0x08) ? 3 : 2;
+		wtx[sendLen - 1] = wtxm;
+		send = wtx;
+
+		// FWT_TEMP = FWT * WTXM, at most FWT_MAX (FWI 14) + ΔFWT
+		uint32_t maxTime = TCL_FrameWaitingTime(14);
+		PCD_SetTimeout(TIMEOUT_FWT, tag->fwt > maxTime / wtxm ? maxTime : tag->fwt * wtxm);
+	}
+	PCD_SetTimeout(TIMEOUT_FWT, tag->fwt);
+	return result;
+} // End TCL_ExchangeFrame()
+
+/**
+ * Writes the prologue of a block for the PICC: the PCB with its block number and, if the PICC supports it, the CID.
+ *
+ * @return the length of the prologue, 1 or 2.
+ */
+byte MFRC522Extended::TCL_Prologue(	TagInfo *tag,	///< The PICC, activated with PICC_Select()
+									byte *frame,	///< Start of the frame
+									byte pcb		///< I-block or R-block PCB without block number and CID bit
+								) {
+	if (tag->blockNumber) {
+		pcb |= 0x01;
+	}
+	if (!tag->ats.tc1.supportsCID) {
+		frame[0] = pcb;
+		return 1;
+	}
+	frame[0] = pcb | 0x08;
+	frame[1] = tag->cid;
+	return 2;
+} // End TCL_Prologue()
+
+/**
+ * Sends an APDU in I-blocks and collects the response.
+ * Data longer than the frame size is sent in chained I-blocks: the frame size is the smaller of the FSC of the
+ * PICC and MFRC522_TCL_FRAME_SIZE, and the PICC acknowledges each block but the last with R(ACK).
+ * A chained response is requested with R(ACK) and reassembled in backData, which can be of any size.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::TCL_TransceiveExtended(	TagInfo *tag,		///< The PICC, activated with PICC_Select()
+																byte *sendData,		///< The data to send, eg a command APDU
+																uint16_t sendLen,	///< Number of bytes to send
+																byte *backData,		///< NULL or buffer for the response
+																uint16_t *backLen	///< In: Max number of bytes to write to *backData. Out: The number of bytes returned.
+															) {
 	MFRC522::StatusCode result;
 
 	PcbBlock out;
 	PcbBlock in;
-	byte outBuffer[FIFO_SIZE];
-	byte outBufferSize = FIFO_SIZE;
-	byte totalBackLen = *backLen;
+	byte inBuffer[MFRC522_TCL_FRAME_SIZE];
+	uint16_t totalBackLen = (backData && backLen) ? *backLen : 0;
+	uint16_t received = 0;
 
-	// This command sends an I-Block
-	out.prologue.pcb = 0x02;
-
-	if (tag->ats.tc1.supportsCID) {
-		out.prologue.pcb |= 0x08;
-		out.prologue.cid = 0x00;	// CID is curentlly hardcoded as 0x00
-	}
+	// The INF field of a block gets what the frame leaves after PCB, CID and CRC_A.
+	uint16_t frameSize = tag->ats.fsc < MFRC522_TCL_FRAME_SIZE ? tag->ats.fsc : MFRC522_TCL_FRAME_SIZE;
+	uint16_t maxInf = frameSize - (tag->ats.tc1.supportsCID ? 4 : 3);
 
 	// This command doe not support NAD
-	out.prologue.pcb &= 0xFB;
 	out.prologue.nad = 0x00;
+	out.prologue.cid = tag->cid;
+
+	uint16_t sent = 0;
+	do {
+		uint16_t size = sendLen - sent;
+		bool chaining = size > maxInf;
+		if (chaining) {
+			size = maxInf;
+		}
 
-	// Set the block number
-	if (tag->blockNumber) {
-		out.prologue.pcb |= 0x01;
-	}
-
-	// Do we have data to send?
-	if (sendData && (sendLen > 0)) {
-		out.inf.size = sendLen;
-		out.inf.data = sendData;
-	} else {
-		out.inf.size = 0;
-		out.inf.data = NULL;
-	}
+		// This command sends an I-Block, with the chaining bit on all but the last one
+		out.prologue.pcb = chaining ? 0x12 : 0x02;
+		if (tag->ats.tc1.supportsCID) {
+			out.prologue.pcb |= 0x08;
+		}
 
-	// Initialize the receiving data
-	// TODO Warning: Value escapes the local scope
-	in.inf.data = outBuffer;
-	in.inf.size = outBufferSize;
+		// Set the block number
+		if (tag->blockNumber) {
+			out.prologue.pcb |= 0x01;
+		}
 
-	result = TCL_Transceive(&out, &in);
-	if (result != STATUS_OK) {
-		return result;
-	}
+		out.inf.size = size;
+		out.inf.data = size ? &sendData[sent] : NULL;
 
-	// Swap block number on success
-	tag->blockNumber = !tag->blockNumber;
+		// Initialize the receiving data
+		in.inf.data = inBuffer;
+		in.inf.size = sizeof(inBuffer) - 3;
 
-	if (backData && (backLen > 0)) {
-		if (*backLen < in.inf.size)
-			return STATUS_NO_ROOM;
+		result = TCL_TransceiveBlock(tag, &out, &in);
+		if (result != STATUS_OK) {
+			return result;
+		}
 
-		*backLen = in.inf.size;
-		memcpy(backData, in.inf.data, in.inf.size);
-	}
+		// Swap block number on success
+		tag->blockNumber = !tag->blockNumber;
+		sent += size;
 
-	// Check chaining
-	if ((in.prologue.pcb & 0x10) == 0x00)
-		return result;
+		// Each chained block must be acknowledged before the next one is sent
+		if (chaining && (in.prologue.pcb & 0xF6) != 0xA2) {
+			return STATUS_ERROR;
+		}
+	} while (sent < sendLen);
 
-	// Result is chained
-	// Send an ACK to receive more data
-	// TODO: Should be checked I've never needed to send an ACK
-	while (in.prologue.pcb & 0x10) {
-		byte ackData[FIFO_SIZE];
-		byte ackDataSize = FIFO_SIZE;
+	// The last block is answered with an I-Block, which may be the first of a chain.
+	for (;;) {
+		if ((in.prologue.pcb & 0xE2) != 0x02) {
+			return STATUS_ERROR;
+		}
+		if (backData && backLen) {
+			if (received + in.inf.size > totalBackLen) {
+				return STATUS_NO_ROOM;
+			}
+			memcpy(&backData[received], in.inf.data, in.inf.size);
+		}
+		received += in.inf.size;
+		if (backLen) {
+			*backLen = received;
+		}
 
-		result = TCL_TransceiveRBlock(tag, true, ackData, &ackDataSize);
-		if (result != STATUS_OK)
+		// Check chaining
+		if ((in.prologue.pcb & 0x10) == 0x00) {
 			return result;
+		}
 
-		if (backData && (backLen > 0)) {
-			if ((*backLen + ackDataSize) > totalBackLen)
-				return STATUS_NO_ROOM;
+		// Result is chained
+		// Send an ACK to receive more data
+		out.prologue.pcb = 0xA2;
+		if (tag->ats.tc1.supportsCID) {
+			out.prologue.pcb |= 0x08;
+		}
+		if (tag->blockNumber) {
+			out.prologue.pcb |= 0x01;
+		}
+		out.inf.size = 0;
+		out.inf.data = NULL;
+		in.inf.data = inBuffer;
+		in.inf.size = sizeof(inBuffer) - 3;
 
-			memcpy(&(backData[*backLen]), ackData, ackDataSize);
-			*backLen += ackDataSize;
+		result = TCL_TransceiveBlock(tag, &out, &in);
+		if (result != STATUS_OK) {
+			return result;
 		}
+		tag->blockNumber = !tag->blockNumber;
+	}
+} // End TCL_TransceiveExtended()
+
+/**
+ * Send an I-Block (Application).
+ * Same as TCL_TransceiveExtended() with byte lengths: a response of more than 255 bytes fails with STATUS_NO_ROOM.
+ */
+MFRC522::StatusCode MFRC522Extended::TCL_Transceive(TagInfo *tag, byte *sendData, byte sendLen, byte *backData, byte *backLen)
+{
+	uint16_t length = backLen ? *backLen : 0;
+	MFRC522::StatusCode result = TCL_TransceiveExtended(tag, sendData, sendLen, backData, backLen ? &length : NULL);
+	if (backLen) {
+		*backLen = length;
 	}
-	
 	return result;
 } // End TCL_Transceive()
 
+/**
+ * Sends an APDU and receives the response in the same buffer, without copying either.
+ * Each block is built around its part of data: the prologue temporarily replaces the bytes in front of it, so
+ * data needs TCL_HEADROOM bytes in front that are not part of the APDU. Blocks are streamed between data and the
+ * FIFO with the CRC_A added and checked by the MFRC522. TxCRCEn and RxCRCEn are switched on for the exchange and
+ * set back afterwards, so the base class functions, which add the CRC_A themselves, keep working.
+ * Chaining works as in TCL_TransceiveExtended().
+ * The response overwrites data. With a callback the INF field of each response block is handed over at data
+ * instead, so a response of any length only needs capacity for one block.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::TCL_TransceiveInPlace(	TagInfo *tag,		///< The PICC, activated with PICC_Select()
+															byte *data,			///< The data to send, with TCL_HEADROOM bytes in front. Out: The response.
+															uint16_t sendLen,	///< Number of bytes to send
+															uint16_t capacity,	///< Max number of response bytes to write to *data
+															uint16_t *backLen,	///< NULL or out: The number of response bytes, in all blocks with a callback
+															TCL_ChunkCallback callback,	///< NULL or function that takes the response block by block
+															void *context		///< Passed to the callback
+														) {
+	const byte txCRC = PCD_ShadowedValue(TxModeReg) & 0x80;
+	const byte rxCRC = PCD_ShadowedValue(RxModeReg) & 0x80;
+	PCD_WriteRegister(TxModeReg, PCD_ShadowedValue(TxModeReg) | 0x80);	// TxCRCEn
+	PCD_WriteRegister(RxModeReg, PCD_ShadowedValue(RxModeReg) | 0x80);	// RxCRCEn
+
+	MFRC522::StatusCode result = TCL_ExchangeInPlace(tag, data, sendLen, capacity, backLen, callback, context);
+
+	// The bit rates may have changed to those of the PICC, only the CRC bits are set back.
+	PCD_WriteRegister(TxModeReg, (PCD_ShadowedValue(TxModeReg) & 0x7F) | txCRC);
+	PCD_WriteRegister(RxModeReg, (PCD_ShadowedValue(RxModeReg) & 0x7F) | rxCRC);
+	return result;
+} // End TCL_TransceiveInPlace()
+
+/**
+ * Exchanges the blocks of TCL_TransceiveInPlace(), with TxCRCEn and RxCRCEn switched on.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::TCL_ExchangeInPlace(	TagInfo *tag,		///< The PICC, activated with PICC_Select()
+															byte *data,			///< The data to send, with TCL_HEADROOM bytes in front. Out: The response.
+															uint16_t sendLen,	///< Number of bytes to send
+															uint16_t capacity,	///< Max number of response bytes to write to *data
+															uint16_t *backLen,	///< NULL or out: The number of response bytes, in all blocks with a callback
+															TCL_ChunkCallback callback,	///< NULL or function that takes the response block by block
+															void *context		///< Passed to the callback
+														) {
+	MFRC522::StatusCode result;
+	byte saved[TCL_HEADROOM];
+	byte *back;
+	uint16_t backSize;
+	byte pcb;
+
+	// The INF field of a block gets what the frame leaves after PCB, CID and CRC_A.
+	const byte prologue = tag->ats.tc1.supportsCID ? 2 : 1;
+	uint16_t frameSize = tag->ats.fsc < MFRC522_TCL_FRAME_SIZE ? tag->ats.fsc : MFRC522_TCL_FRAME_SIZE;
+	uint16_t maxInf = frameSize - prologue - 2;
+
+	// Send. The answer to the last block is received in front of data, an R(ACK) or S(WTX) on the stack.
+	byte reply[TCL_HEADROOM + 1];
+	uint16_t sent = 0;
+	bool chaining;
+	do {
+		uint16_t size = sendLen - sent;
+		chaining = size > maxInf;
+		if (chaining) {
+			size = maxInf;
+		}
+		byte *frame = data + sent - prologue;
+		memcpy(saved, frame, prologue);
+		TCL_Prologue(tag, frame, chaining ? 0x12 : 0x02);
+		back = chaining ? reply : data - prologue;
+		backSize = chaining ? sizeof(reply) : capacity + prologue;
+
+		result = TCL_ExchangeFrame(tag, frame, prologue + size, back, &backSize);
+		pcb = back[0];
+
+		// Give back the bytes the prologue took, unless the answer landed on them
+		if (chaining || result != STATUS_OK || backSize <= sent) {
+			memcpy(frame, saved, prologue);
+		}
+		if (result != STATUS_OK) {
+			return result;
+		}
+		if (backSize < prologue) {
+			return STATUS_ERROR;
+		}
+
+		// Swap block number on success
+		tag->blockNumber = !tag->blockNumber;
+		sent += size;
+
+		// Each chained block must be acknowledged before the next one is sent
+		if (chaining && (pcb & 0xF6) != 0xA2) {
+			return STATUS_ERROR;
+		}
+	} while (chaining);
+
+	// Receive. Each block lands behind the INF fields before it, its prologue on their last bytes for the time of
+	// the exchange. With a callback every block lands at data.
+	uint16_t received = 0;
+	for (;;) {
+		if ((pcb & 0xE2) != 0x02) {
+			return STATUS_ERROR;
+		}
+		uint16_t size = backSize - prologue;
+		if (callback && size) {
+			callback(data, size, context);
+		}
+		received += size;
+		if (backLen) {
+			*backLen = received;
+		}
+
+		// Check chaining
+		if ((pcb & 0x10) == 0x00) {
+			return STATUS_OK;
+		}
+
+		// Result is chained
+		// Send an ACK to receive more data
+		byte ack[TCL_HEADROOM];
+		TCL_Prologue(tag, ack, 0xA2);
+		back = (callback ? data : data + received) - prologue;
+		backSize = (callback ? capacity : capacity - received) + prologue;
+		memcpy(saved, back, prologue);
+
+		result = TCL_ExchangeFrame(tag, ack, prologue, back, &backSize);
+		pcb = back[0];
+		memcpy(back, saved, prologue);
+		if (result != STATUS_OK) {
+			return result;
+		}
+		if (backSize < prologue) {
+			return STATUS_ERROR;
+		}
+		tag->blockNumber = !tag->blockNumber;
+	}
+} // End TCL_ExchangeInPlace()
+
 /**
  * Send R-Block to the PICC.
  */
@@ -868,7 +1133,7 @@ MFRC522::StatusCode MFRC522Extended::TCL_TransceiveRBlock(TagInfo *tag, bool ack
 
 	if (tag->ats.tc1.supportsCID) {
 		out.prologue.pcb |= 0x08;
-		out.prologue.cid = 0x00;	// CID is curentlly hardcoded as 0x00
+		out.prologue.cid = tag->cid;
 	}
 
 	// This command doe not support NAD
@@ -889,7 +1154,7 @@ MFRC522::StatusCode MFRC522Extended::TCL_TransceiveRBlock(TagInfo *tag, bool ack
 	in.inf.data = outBuffer;
 	in.inf.size = outBufferSize;
 
-	result = TCL_Transceive(&out, &in);
+	result = TCL_TransceiveBlock(tag, &out, &in);
 	if (result != STATUS_OK) {
 		return result;
 	}
@@ -910,6 +1175,7 @@ MFRC522::StatusCode MFRC522Extended::TCL_TransceiveRBlock(TagInfo *tag, bool ack
 
 /**
  * Send an S-Block to deselect the card.
+ * The CID of the PICC is free for another PICC afterwards.
  */
 MFRC522::StatusCode MFRC522Extended::TCL_Deselect(TagInfo *tag)
 {
@@ -923,24 +1189,155 @@ MFRC522::StatusCode MFRC522Extended::TCL_Deselect(TagInfo *tag)
 	if (tag->ats.tc1.supportsCID)
 	{
 		outBuffer[0] |= 0x08;
-		outBuffer[1] = 0x00;  // CID is hardcoded
+		outBuffer[1] = tag->cid;
 		outBufferSize = 2;
 	}
 
-	result = PCD_TransceiveData(outBuffer, outBufferSize, inBuffer, &inBufferSize);
+	// The PICC may have other bit rates than the one addressed before, and may not have done PPS.
+	PCD_SetBitRate(tag);
+	if ((PCD_ShadowedValue(TxModeReg) & 0x80) != 0x80) {
+		uint16_t crc = CRC_Calculate(outBuffer, outBufferSize);
+		outBuffer[outBufferSize++] = crc & 0xFF;
+		outBuffer[outBufferSize++] = crc >> 8;
+	}
+	bool checkCRC = (PCD_ShadowedValue(RxModeReg) & 0x80) != 0x80;
+
+	result = PCD_TransceiveData(outBuffer, outBufferSize, inBuffer, &inBufferSize, NULL, 0, checkCRC, TIMEOUT_ISO_DEP);
 	if (result != STATUS_OK) {
 		return result;
 	}
 
-	// TODO:Maybe do some checks? In my test it returns: CA 00 (Same data as I sent to my card)
+	// The PICC answers with the same S(DESELECT), eg CA 00 with CID 0
+	if ((inBuffer[0] & 0xF7) != 0xC2) {
+		return STATUS_ERROR;
+	}
 
 	return result;
 } // End TCL_Deselect()
 
+/**
+ * Checks that an activated PICC still answers, without disturbing the APDU exchange.
+ * An R(NAK) that does not carry the PICC's block number is answered with R(ACK) (ISO/IEC 14443-4 7.5.4.2 rule 12).
+ * The block numbers are not changed.
+ *
+ * @return STATUS_OK if the PICC answered with R(ACK), STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522Extended::TCL_PresenceCheck(TagInfo *tag)
+{
+	PcbBlock out;
+	PcbBlock in;
+	byte inBuffer[1];
+
+	out.prologue.pcb = 0xB2;	// NAK
+	if (tag->ats.tc1.supportsCID) {
+		out.prologue.pcb |= 0x08;
+	}
+	if (tag->blockNumber) {
+		out.prologue.pcb |= 0x01;
+	}
+	out.prologue.cid = tag->cid;
+	out.prologue.nad = 0x00;
+	out.inf.size = 0;
+	out.inf.data = NULL;
+	in.inf.data = inBuffer;
+	in.inf.size = sizeof(inBuffer);
+
+	MFRC522::StatusCode result = TCL_TransceiveBlock(tag, &out, &in);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	if ((in.prologue.pcb & 0xF6) != 0xA2) {
+		return STATUS_ERROR;
+	}
+	return STATUS_OK;
+} // End TCL_PresenceCheck()
+
 /////////////////////////////////////////////////////////////////////////////////////
 // Support functions
 /////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Sets the fastest bit rate PICC_Select() negotiates with PPS after RATS. BITRATE_106KBITS disables PPS.
+ * The MFRC522 supports up to 848 kbit/s in both directions, but the antenna and the PICC may not. A PICC that does
+ * not answer at the new bit rate is reset and activated again at 106 kbit/s, see TCL_Activate(). The default stops
+ * at 212 kbit/s, which common antennas handle; raise it only for a reader known to work at the higher rates.
+ */
+void MFRC522Extended::PCD_SetMaxBitRate(TagBitRates maxBitRate		///< Default BITRATE_212KBITS
+) {
+	_maxBitRate = maxBitRate;
+} // End PCD_SetMaxBitRate()
+
+/**
+ * Picks the fastest bit rate of a TA1 bit mask (b1 212, b2 424, b3 848 kbit/s) that PCD_SetMaxBitRate() allows.
+ *
+ * @return The bit rate, BITRATE_106KBITS if there is no common faster one.
+ */
+MFRC522Extended::TagBitRates MFRC522Extended::TCL_FastestBitRate(byte supported		///< DS or DR bits of TA1
+) {
+	for (byte rate = _maxBitRate; rate > BITRATE_106KBITS; rate--) {
+		if (supported & (1 << (rate - 1))) {
+			return (TagBitRates)rate;
+		}
+	}
+	return BITRATE_106KBITS;
+} // End TCL_FastestBitRate()
+
+/**
+ * Sets the PCD back to 106 kbit/s in both directions, without hardware CRC, as after PCD_Init().
+ */
+void MFRC522Extended::PCD_ResetBitRate()
+{
+	const PCD_RegisterWrite defaults[] = {
+		{TxModeReg,		0x00},
+		{RxModeReg,		0x00},
+		{ModWidthReg,	0x26}
+	};
+	PCD_WriteRegisters(3, defaults);
+} // End PCD_ResetBitRate()
+
+/**
+ * Sets the PCD to the bit rates negotiated with a PICC, before an exchange with it.
+ * The registers are shadowed, so nothing is written while the same PICC or PICCs with the same bit rates are
+ * addressed. TxCRCEn and RxCRCEn are kept.
+ */
+void MFRC522Extended::PCD_SetBitRate(TagInfo *tag		///< The PICC, activated with PICC_Select() or PICC_Activate()
+) {
+	// The modulation width follows the bit rate PCD to PICC, see PICC_PPS()
+	const byte modWidth[] = {0x26, 0x15, 0x0A, 0x05};
+	const PCD_RegisterWrite rates[] = {
+		{TxModeReg,		(byte)((PCD_ShadowedValue(TxModeReg) & 0x8F) | ((tag->dr & 0x03) << 4))},
+		{RxModeReg,		(byte)((PCD_ShadowedValue(RxModeReg) & 0x8F) | ((tag->ds & 0x03) << 4))},
+		{ModWidthReg,	modWidth[tag->dr & 0x03]}
+	};
+	PCD_WriteRegisters(3, rates);
+} // End PCD_SetBitRate()
+
+/**
+ * Decodes FSCI of the ATS or FSDI of RATS. Values above 8 are RFU and treated as 8 (ISO/IEC 14443-4 5.2.3).
+ *
+ * @return The frame size in bytes, 16 to 256.
+ */
+uint16_t MFRC522Extended::TCL_FrameSize(byte fsi		///< FSCI or FSDI, 0 to 15
+) {
+	static const uint16_t frameSizes[] = {16, 24, 32, 40, 48, 64, 96, 128, 256};
+	return frameSizes[fsi < 8 ? fsi : 8];
+} // End TCL_FrameSize()
+
+/**
+ * Calculates the frame waiting time from FWI of the ATS: FWT = 256 * 16/fc * 2^FWI, plus ΔFWT = 49152/fc that
+ * ISO/IEC 14443-4 7.2 adds on the PCD side. It is counted from the end of the PCD frame to the start of the answer,
+ * so it does not depend on the bit rate. FWI 15 is RFU and treated as the default 4.
+ *
+ * @return The time in μs, 8.5ms for FWI 4, 4.95s for FWI 14.
+ */
+uint32_t MFRC522Extended::TCL_FrameWaitingTime(byte fwi		///< FWI, 0 to 15
+) {
+	if (fwi > 14) {
+		fwi = 4;
+	}
+	return (((uint32_t)77330 << fwi) >> 8) + 3625;	// 256 * 4096/fc = 77330μs
+} // End TCL_FrameWaitingTime()
+
 /**
  * Get the PICC type.
  *
@@ -1094,11 +1491,8 @@ bool MFRC522Extended::PICC_IsNewCardPresent() {
 	byte bufferATQA[2];
 	byte bufferSize = sizeof(bufferATQA);
 
-	// Reset baud rates
-	PCD_WriteRegister(TxModeReg, 0x00);
-	PCD_WriteRegister(RxModeReg, 0x00);
-	// Reset ModWidthReg
-	PCD_WriteRegister(ModWidthReg, 0x26);
+	// Reset baud rates and ModWidthReg
+	PCD_ResetBitRate();
 
 	MFRC522::StatusCode result = PICC_RequestA(bufferATQA, &bufferSize);
 
@@ -1115,7 +1509,7 @@ bool MFRC522Extended::PICC_IsNewCardPresent() {
 
 		// Defaults for TB1
 		tag.ats.tb1.transmitted = false;
-		tag.ats.tb1.fwi = 0;	// TODO: Don't know the default for this!
+		tag.ats.tb1.fwi = 4;	// The default value of FWI is 4 (FWT = 4.8ms)
 		tag.ats.tb1.sfgi = 0;	// The default value of SFGI is 0 (meaning that the card does not need any particular SFGT)
 
 		// Defaults for TC1
@@ -1126,6 +1520,7 @@ bool MFRC522Extended::PICC_IsNewCardPresent() {
 		memset(tag.ats.data, 0, FIFO_SIZE - 2);
 
 		tag.blockNumber = false;
+		tag.fwt = TCL_FrameWaitingTime(tag.ats.tb1.fwi);
 		return true;
 	}
 	return false;
@@ -1147,5 +1542,5 @@ bool MFRC522Extended::PICC_ReadCardSerial() {
 	uid.sak = tag.uid.sak;
 	memcpy(uid.uidByte, tag.uid.uidByte, sizeof(tag.uid.uidByte));
 
-	return (result == STATUS_OK);
+	return (result == STATUS_OK || result == STATUS_FIELD_RESET);
 } // End 
@@ -4,6 +4,13 @@
 #include <Arduino.h>
 #include "MFRC522.h"
 
+// Largest ISO/IEC 14443-4 frame the PCD sends and receives, announced as FSD in RATS. 16 to 256 bytes.
+// The T=CL functions keep frame buffers of this size on the stack; frames larger than the FIFO are streamed, see
+// PCD_TransceiveStream().
+#ifndef MFRC522_TCL_FRAME_SIZE
+#define MFRC522_TCL_FRAME_SIZE 64
+#endif
+
 class MFRC522Extended : public MFRC522 {
 		
 public:
@@ -18,7 +25,7 @@ public:
 	// Structure to store ISO/IEC 14443-4 ATS
 	typedef struct {
 		byte size;
-		byte fsc;                 // Frame size for proximity card
+		uint16_t fsc;             // Frame size for proximity card
 
 		struct {
 			bool transmitted;
@@ -51,6 +58,10 @@ public:
 
 		// For Block PCB
 		bool blockNumber;
+		byte cid;				// Card identifier from RATS, 0 to 14, sent in every block if the PICC supports it
+		uint32_t fwt;			// Frame waiting time in μs including ΔFWT, from the FWI of the ATS
+		TagBitRates ds;			// Bit rate PICC to PCD, negotiated with PPS
+		TagBitRates dr;			// Bit rate PCD to PICC, negotiated with PPS
 	} TagInfo;
 
 	// A struct used for passing PCB Block
@@ -66,37 +77,51 @@ public:
 		} inf;
 	} PcbBlock;
 	
+	// Bytes in front of the data of TCL_TransceiveInPlace() that the prologue of a block takes: PCB and CID
+	static constexpr byte TCL_HEADROOM = 2;
+
+	// Takes the INF field of one response block, see TCL_TransceiveInPlace(). data is valid during the call only.
+	typedef void (*TCL_ChunkCallback)(const byte *data, uint16_t length, void *context);
+
 	// Member variables
-	TagInfo tag;
+	TagInfo tag;			// The PICC of PICC_Select() and PICC_ReadCardSerial(), CID 0. See PICC_Activate() for more.
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Contructors
 	/////////////////////////////////////////////////////////////////////////////////////
-	MFRC522Extended() : MFRC522() {};
-	MFRC522Extended(uint8_t rst) : MFRC522(rst) {};
-	MFRC522Extended(uint8_t ss, uint8_t rst) : MFRC522(ss, rst) {};
+	MFRC522Extended() : MFRC522(), _maxBitRate(BITRATE_212KBITS) {};
+	MFRC522Extended(uint8_t rst) : MFRC522(rst), _maxBitRate(BITRATE_212KBITS) {};
+	MFRC522Extended(uint8_t ss, uint8_t rst) : MFRC522(ss, rst), _maxBitRate(BITRATE_212KBITS) {};
+	MFRC522Extended(MFRC522Bus &bus, uint8_t rst = UNUSED_PIN) : MFRC522(bus, rst), _maxBitRate(BITRATE_212KBITS) {};
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for communicating with PICCs
 	/////////////////////////////////////////////////////////////////////////////////////
 	StatusCode PICC_Select(Uid *uid, byte validBits = 0) override; // overrride
-	StatusCode PICC_RequestATS(Ats *ats);
-	StatusCode PICC_PPS();	                                                  // PPS command without bitrate parameter
-	StatusCode PICC_PPS(TagBitRates sendBitRate, TagBitRates receiveBitRate); // Different D values
+	StatusCode PICC_Activate(TagInfo *tag, byte cid);
+	StatusCode PICC_RequestATS(Ats *ats, byte cid = 0);
+	StatusCode PICC_PPS(byte cid = 0);	                                                      // PPS command without bitrate parameter
+	StatusCode PICC_PPS(TagBitRates sendBitRate, TagBitRates receiveBitRate, byte cid = 0); // Different D values
+	void PCD_SetMaxBitRate(TagBitRates maxBitRate);
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for communicating with ISO/IEC 14433-4 cards
 	/////////////////////////////////////////////////////////////////////////////////////
 	StatusCode TCL_Transceive(PcbBlock *send, PcbBlock *back);
-	StatusCode TCL_Transceive(TagInfo * tag, byte *sendData, byte sendLen, byte *backData = NULL, byte *backLen = NULL);
+	StatusCode TCL_Transceive(TagInfo *tag, byte *sendData, byte sendLen, byte *backData = NULL, byte *backLen = NULL);
+	StatusCode TCL_TransceiveExtended(TagInfo *tag, byte *sendData, uint16_t sendLen, byte *backData = NULL, uint16_t *backLen = NULL);
+	StatusCode TCL_TransceiveInPlace(TagInfo *tag, byte *data, uint16_t sendLen, uint16_t capacity, uint16_t *backLen, TCL_ChunkCallback callback = NULL, void *context = NULL);
 	StatusCode TCL_TransceiveRBlock(TagInfo *tag, bool ack, byte *backData = NULL, byte *backLen = NULL);
 	StatusCode TCL_Deselect(TagInfo *tag);
+	StatusCode TCL_PresenceCheck(TagInfo *tag);
 	
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Support functions
 	/////////////////////////////////////////////////////////////////////////////////////
 	static PICC_Type PICC_GetType(TagInfo *tag);
 	using MFRC522::PICC_GetType;// // make old PICC_GetType(byte sak) available, otherwise would be hidden by PICC_GetType(TagInfo *tag)
+	static uint16_t TCL_FrameSize(byte fsi);
+	static uint32_t TCL_FrameWaitingTime(byte fwi);
 
 	// Support functions for debuging
 	void PICC_DumpToSerial(TagInfo *tag);
@@ -110,6 +135,18 @@ public:
 	/////////////////////////////////////////////////////////////////////////////////////
 	bool PICC_IsNewCardPresent() override; // overrride
 	bool PICC_ReadCardSerial() override; // overrride
+
+protected:
+	TagBitRates _maxBitRate;		// Fastest bit rate negotiated with PPS, see PCD_SetMaxBitRate()
+
+	StatusCode TCL_Activate(TagInfo *tag, byte cid);
+	StatusCode TCL_TransceiveBlock(TagInfo *tag, PcbBlock *send, PcbBlock *back);
+	StatusCode TCL_ExchangeInPlace(TagInfo *tag, byte *data, uint16_t sendLen, uint16_t capacity, uint16_t *backLen, TCL_ChunkCallback callback, void *context);
+	StatusCode TCL_ExchangeFrame(TagInfo *tag, byte *send, uint16_t sendLen, byte *back, uint16_t *backLen);
+	byte TCL_Prologue(TagInfo *tag, byte *frame, byte pcb);
+	TagBitRates TCL_FastestBitRate(byte supported);
+	void PCD_ResetBitRate();
+	void PCD_SetBitRate(TagInfo *tag);
 };
 
 #endif
@@ -0,0 +1,206 @@
+/*
+ * Key dictionary search for MIFARE Classic PICCs, with a cache of the keys found per UID.
+ */
+#include "MFRC522KeySearch.h"
+
+/**
+ * Constructor.
+ */
+MFRC522KeySearch::MFRC522KeySearch(	MFRC522 &reader,		///< The reader
+									const byte *dictionary,	///< keyCount keys of MF_KEY_SIZE bytes each, in flash (PROGMEM)
+									uint16_t keyCount,		///< Number of keys in the dictionary, below KEY_NOT_FOUND
+									KeyTypes keyTypes		///< The key types each key is tried as
+								) : _reader(reader) {
+	_dictionary = dictionary;
+	_keyCount = keyCount < KEY_TYPE_B ? keyCount : KEY_TYPE_B - 1;
+	_keyTypes = keyTypes;
+	clearCache();
+} // End constructor
+
+/**
+ * Forgets all found keys and resets attempts().
+ */
+void MFRC522KeySearch::clearCache() {
+	memset(_cache, 0, sizeof(_cache));
+	_attempts = 0;
+} // End clearCache()
+
+/**
+ * Authenticates a sector of the selected PICC, the one in the reader's uid member.
+ * The cached key for the UID is used if there is one. Otherwise, or if it fails, the dictionary is searched.
+ * The PICC must be in state ACTIVE. It is left in state ACTIVE, and authenticated on success.
+ * Remember to call PCD_StopCrypto1() after communicating with the authenticated PICC.
+ *
+ * @return STATUS_OK on success, STATUS_TIMEOUT if no key of the dictionary opens the sector, STATUS_ERROR if the
+ * 		PICC is gone, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522KeySearch::authenticate(byte sector	///< The sector, 0..MFRC522_KEYSEARCH_SECTORS-1
+												) {
+	if (sector >= MFRC522_KEYSEARCH_SECTORS || _reader.uid.size > sizeof(_cache[0].uidByte)) {
+		return MFRC522::STATUS_INVALID;
+	}
+	Entry *cached = entry();
+	uint16_t found = cached->key[sector];
+	if (found == KEY_NOT_FOUND) {
+		return MFRC522::STATUS_TIMEOUT;
+	}
+	MFRC522::StatusCode status;
+	if (found != KEY_UNKNOWN) {
+		status = tryKey(sector, found);
+		if (status != MFRC522::STATUS_TIMEOUT) {
+			return status;
+		}
+		cached->key[sector] = KEY_UNKNOWN;	// The PICC was keyed anew
+	}
+
+	// Keys that opened other sectors first, then the whole dictionary.
+	for (byte other = 0; other < MFRC522_KEYSEARCH_SECTORS; other++) {
+		found = cached->key[other];
+		if (found >= KEY_NOT_FOUND) {
+			continue;
+		}
+		bool tried = false;
+		for (byte i = 0; i < other; i++) {
+			tried |= (cached->key[i] == found);
+		}
+		if (!tried && (status = tryKey(sector, found)) != MFRC522::STATUS_TIMEOUT) {
+			if (status == MFRC522::STATUS_OK) {
+				cached->key[sector] = found;
+			}
+			return status;
+		}
+	}
+	for (uint16_t index = 0; index < _keyCount; index++) {
+		for (byte type = 0; type < 2; type++) {
+			if (!(_keyTypes & (KEY_A << type))) {
+				continue;
+			}
+			found = type ? (index | KEY_TYPE_B) : index;
+			bool tried = false;
+			for (byte other = 0; other < MFRC522_KEYSEARCH_SECTORS; other++) {
+				tried |= (cached->key[other] == found);
+			}
+			if (!tried && (status = tryKey(sector, found)) != MFRC522::STATUS_TIMEOUT) {
+				if (status == MFRC522::STATUS_OK) {
+					cached->key[sector] = found;
+				}
+				return status;
+			}
+		}
+	}
+	cached->key[sector] = KEY_NOT_FOUND;
+	return MFRC522::STATUS_TIMEOUT;
+} // End authenticate()
+
+/**
+ * Searches the keys of the first sectorCount sectors of the selected PICC, see authenticate().
+ * Use MFRC522::MIFARE_SectorCount() for the sector count of a PICC type.
+ *
+ * @return STATUS_OK if all sectors were opened, STATUS_TIMEOUT if a sector was not, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522KeySearch::searchCard(byte sectorCount	///< Number of sectors, at most MFRC522_KEYSEARCH_SECTORS
+												) {
+	if (sectorCount > MFRC522_KEYSEARCH_SECTORS) {
+		return MFRC522::STATUS_INVALID;
+	}
+	MFRC522::StatusCode result = MFRC522::STATUS_OK;
+	for (byte sector = 0; sector < sectorCount; sector++) {
+		MFRC522::StatusCode status = authenticate(sector);
+		if (status == MFRC522::STATUS_TIMEOUT) {
+			result = status;
+		}
+		else if (status != MFRC522::STATUS_OK) {
+			return status;				// The PICC is gone
+		}
+	}
+	return result;
+} // End searchCard()
+
+/**
+ * Looks up the key found for a sector of the selected PICC, without talking to it.
+ *
+ * @return true if a key is cached, false if the sector was not searched or no key opened it.
+ */
+bool MFRC522KeySearch::knownKey(	byte sector,					///< The sector, 0..MFRC522_KEYSEARCH_SECTORS-1
+									byte *command,					///< Out: PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+									MFRC522::MIFARE_Key *key		///< Out: The key
+								) {
+	uint16_t found = keyIndex(sector);
+	if (found >= KEY_NOT_FOUND) {
+		return false;
+	}
+	loadKey(found, command, key);
+	return true;
+} // End knownKey()
+
+/**
+ * Returns the dictionary index of the key found for a sector of the selected PICC, or-ed with KEY_TYPE_B for a
+ * key B. KEY_UNKNOWN if the sector was not searched, KEY_NOT_FOUND if no key opened it.
+ */
+uint16_t MFRC522KeySearch::keyIndex(byte sector	///< The sector, 0..MFRC522_KEYSEARCH_SECTORS-1
+								) {
+	if (sector >= MFRC522_KEYSEARCH_SECTORS || _reader.uid.size > sizeof(_cache[0].uidByte)) {
+		return KEY_UNKNOWN;
+	}
+	return entry()->key[sector];
+} // End keyIndex()
+
+/**
+ * Returns the cache entry of the selected PICC and moves it to the front.
+ * A PICC not in the cache gets a new entry in place of the least recently used one.
+ */
+MFRC522KeySearch::Entry *MFRC522KeySearch::entry() {
+	const MFRC522::Uid &uid = _reader.uid;
+	byte index = 0;
+	while (index < MFRC522_KEYSEARCH_CACHE - 1
+			&& !(_cache[index].uidSize == uid.size && memcmp(_cache[index].uidByte, uid.uidByte, uid.size) == 0)) {
+		index++;
+	}
+	Entry found = _cache[index];
+	memmove(&_cache[1], &_cache[0], index * sizeof(Entry));
+	if (found.uidSize != uid.size || memcmp(found.uidByte, uid.uidByte, uid.size) != 0) {
+		found.uidSize = uid.size;
+		memcpy(found.uidByte, uid.uidByte, uid.size);
+		for (byte sector = 0; sector < MFRC522_KEYSEARCH_SECTORS; sector++) {
+			found.key[sector] = KEY_UNKNOWN;
+		}
+	}
+	_cache[0] = found;
+	return &_cache[0];
+} // End entry()
+
+/**
+ * Authenticates a sector with a key of the dictionary. After a failure the PICC is selected again.
+ *
+ * @return STATUS_OK on success, STATUS_TIMEOUT for a wrong key, STATUS_ERROR if the PICC could not be selected again.
+ */
+MFRC522::StatusCode MFRC522KeySearch::tryKey(	byte sector,	///< The sector
+												uint16_t key	///< Dictionary index | KEY_TYPE_B
+											) {
+	byte command;
+	MFRC522::MIFARE_Key mifareKey;
+	loadKey(key, &command, &mifareKey);
+	_attempts++;
+	MFRC522::StatusCode status = _reader.PCD_Authenticate(command, MFRC522::MIFARE_FirstBlock(sector), &mifareKey, &_reader.uid);
+	if (status == MFRC522::STATUS_OK) {
+		return status;
+	}
+
+	// The PICC went to IDLE. Wake it and select it by its UID, without anticollision.
+	status = _reader.PICC_Reactivate(&_reader.uid);
+	return status == MFRC522::STATUS_OK ? MFRC522::STATUS_TIMEOUT : MFRC522::STATUS_ERROR;
+} // End tryKey()
+
+/**
+ * Copies a key from the dictionary in flash.
+ */
+void MFRC522KeySearch::loadKey(	uint16_t key,					///< Dictionary index | KEY_TYPE_B
+								byte *command,					///< Out: PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+								MFRC522::MIFARE_Key *mifareKey	///< Out: The key
+							) {
+	*command = (key & KEY_TYPE_B) ? MFRC522::PICC_CMD_MF_AUTH_KEY_B : MFRC522::PICC_CMD_MF_AUTH_KEY_A;
+	const byte *source = &_dictionary[(key & ~KEY_TYPE_B) * MFRC522::MF_KEY_SIZE];
+	for (byte i = 0; i < MFRC522::MF_KEY_SIZE; i++) {
+		mifareKey->keyByte[i] = pgm_read_byte(&source[i]);
+	}
+} // End loadKey()
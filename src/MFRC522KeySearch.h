@@ -0,0 +1,79 @@
+/**
+ * Key dictionary search for MIFARE Classic PICCs, with a cache of the keys found per UID.
+ *
+ * The dictionary is an array of 6 byte keys in flash:
+ * 		const byte keys[][MFRC522::MF_KEY_SIZE] PROGMEM = {
+ * 			{0xff, 0xff, 0xff, 0xff, 0xff, 0xff},
+ * 			{0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5},
+ * 			...
+ * 		};
+ * 		MFRC522KeySearch search(mfrc522, keys[0], sizeof(keys) / MFRC522::MF_KEY_SIZE);
+ * 		...
+ * 		if (mfrc522.PICC_IsNewCardPresent() && mfrc522.PICC_ReadCardSerial()) {
+ * 			if (search.authenticate(sector) == MFRC522::STATUS_OK) {
+ * 				mfrc522.MIFARE_Read(...);				// The sector is authenticated
+ * 			}
+ * 			mfrc522.PICC_HaltA();
+ * 			mfrc522.PCD_StopCrypto1();
+ * 		}
+ *
+ * A failed authentication leaves the PICC in state IDLE. Before the next key is tried it is brought back with
+ * MFRC522::PICC_Reactivate(), which costs two frames instead of a full anticollision. Keys that opened other
+ * sectors of the PICC are tried first, since cards are usually keyed with few distinct keys.
+ *
+ * The key and key type found for each sector, and the sectors no key opened, are remembered for the last
+ * MFRC522_KEYSEARCH_CACHE UIDs. A repeat tap authenticates with the cached key at once. The least recently used
+ * UID is dropped when the cache is full. Each entry takes 11 + 2 * MFRC522_KEYSEARCH_SECTORS bytes of RAM.
+ */
+#ifndef MFRC522KeySearch_h
+#define MFRC522KeySearch_h
+
+#include "MFRC522.h"
+
+#ifndef MFRC522_KEYSEARCH_CACHE
+#define MFRC522_KEYSEARCH_CACHE 4				// Number of UIDs the found keys are cached for
+#endif
+#ifndef MFRC522_KEYSEARCH_SECTORS
+#define MFRC522_KEYSEARCH_SECTORS 16			// Sectors cached per UID, 40 for MIFARE Classic 4K
+#endif
+
+class MFRC522KeySearch {
+public:
+	enum KeyTypes : byte {
+		KEY_A					= 0x01,		// Try the keys as key A
+		KEY_B					= 0x02,		// Try the keys as key B
+		KEY_AB					= 0x03		// Try each key as key A, then as key B
+	};
+	static constexpr uint16_t KEY_UNKNOWN = 0xFFFF;		// The sector was not searched
+	static constexpr uint16_t KEY_NOT_FOUND = 0xFFFE;	// No key of the dictionary opened the sector
+	static constexpr uint16_t KEY_TYPE_B = 0x8000;		// Flag of keyIndex(): the key opened the sector as key B
+
+	MFRC522KeySearch(MFRC522 &reader, const byte *dictionary, uint16_t keyCount, KeyTypes keyTypes = KEY_A);
+
+	MFRC522::StatusCode authenticate(byte sector);
+	MFRC522::StatusCode searchCard(byte sectorCount);
+	bool knownKey(byte sector, byte *command, MFRC522::MIFARE_Key *key);
+	uint16_t keyIndex(byte sector);
+	void clearCache();
+	uint32_t attempts() const { return _attempts; };	// Authentications tried since clearCache()
+
+protected:
+	typedef struct {
+		byte uidSize;							// 0 for an unused entry
+		byte uidByte[10];
+		uint16_t key[MFRC522_KEYSEARCH_SECTORS];	// Dictionary index | KEY_TYPE_B, or KEY_UNKNOWN, KEY_NOT_FOUND
+	} Entry;
+
+	MFRC522 &_reader;
+	const byte *_dictionary;				// keyCount * MF_KEY_SIZE bytes in flash
+	uint16_t _keyCount;
+	KeyTypes _keyTypes;
+	uint32_t _attempts;
+	Entry _cache[MFRC522_KEYSEARCH_CACHE];	// Most recently used first
+
+	Entry *entry();
+	MFRC522::StatusCode tryKey(byte sector, uint16_t key);
+	void loadKey(uint16_t key, byte *command, MFRC522::MIFARE_Key *mifareKey);
+};
+
+#endif
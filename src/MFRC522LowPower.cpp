@@ -0,0 +1,138 @@
+/*
+ * Duty-cycled card detection on an MFRC522, with the chip in soft power-down between polls.
+ */
+#include "MFRC522LowPower.h"
+
+/**
+ * Constructor.
+ */
+MFRC522LowPower::MFRC522LowPower(	MFRC522 &reader,		///< The reader, initialised with PCD_Init() before begin()
+									uint32_t minInterval,	///< Poll interval in ms after a detection
+									uint32_t maxInterval	///< Poll interval in ms the back off stops at
+								) : _reader(reader) {
+	_interval = 0;
+	setIntervals(minInterval, maxInterval);
+	_state = STATE_ACTIVE;
+	_wakeUpTime = 0;
+	_lastPoll = 0;
+	_stateStart = 0;
+	memset(&_stats, 0, sizeof(_stats));
+} // End constructor
+
+/**
+ * Powers the chip down and makes the first poll due at once. Call it after PCD_Init().
+ */
+void MFRC522LowPower::begin() {
+	_stateStart = _reader.PCD_Bus().now();
+	resetStats();
+	_interval = _minInterval;
+	_lastPoll = _stateStart - _interval;
+	sleep();
+} // End begin()
+
+/**
+ * Sets the range of the poll interval. The current interval is clipped to it.
+ */
+void MFRC522LowPower::setIntervals(	uint32_t minInterval,	///< Poll interval in ms after a detection, at least 1
+									uint32_t maxInterval	///< Poll interval in ms the back off stops at
+								) {
+	_minInterval = (minInterval ? minInterval : 1) * 1000;
+	_maxInterval = maxInterval * 1000;
+	if (_maxInterval < _minInterval) {
+		_maxInterval = _minInterval;
+	}
+	if (_interval < _minInterval) {
+		_interval = _minInterval;
+	}
+	if (_interval > _maxInterval) {
+		_interval = _maxInterval;
+	}
+} // End setIntervals()
+
+/**
+ * Polls the field if the poll is due. Call it periodically, at least every minInterval.
+ * After a detection the chip stays powered up and the PICC answered with ATQA, like after PICC_IsNewCardPresent().
+ * The next update() powers the chip down again and schedules the next poll minInterval after this one.
+ *
+ * @return true if a PICC was found.
+ */
+bool MFRC522LowPower::update() {
+	MFRC522Bus &bus = _reader.PCD_Bus();
+	if (_state == STATE_ACTIVE) {
+		sleep();
+	}
+
+	// Wake up early by the wake up time measured last, so the poll itself starts on schedule.
+	uint32_t elapsed = bus.now() - _lastPoll;
+	if (elapsed + _wakeUpTime < _interval) {
+		return false;
+	}
+
+	enter(STATE_WAKE_UP);
+	uint32_t wakeUpTime;
+	if (_reader.PCD_SoftPowerUp(&wakeUpTime) != MFRC522::STATUS_OK) {
+		_lastPoll = bus.now();
+		sleep();
+		return false;
+	}
+	_wakeUpTime = wakeUpTime;
+	if (_wakeUpTime > _stats.wakeUpMax) {
+		_stats.wakeUpMax = _wakeUpTime;
+	}
+
+	enter(STATE_POLL);
+	_lastPoll = bus.now();
+	_stats.polls++;
+	if (_reader.PICC_PollPresence()) {
+		_stats.detections++;
+		_interval = _minInterval;
+		enter(STATE_ACTIVE);
+		return true;
+	}
+
+	// Empty field: back off.
+	_interval += _interval / 2;
+	if (_interval > _maxInterval) {
+		_interval = _maxInterval;
+	}
+	sleep();
+	return false;
+} // End update()
+
+/**
+ * Returns the time in ms until update() polls next, 0 if the poll is due.
+ * The MCU can sleep this long between calls to update().
+ */
+uint32_t MFRC522LowPower::timeToNextPoll() {
+	if (_state == STATE_ACTIVE) {
+		return 0;
+	}
+	uint32_t elapsed = _reader.PCD_Bus().now() - _lastPoll + _wakeUpTime;
+	return elapsed < _interval ? (_interval - elapsed) / 1000 : 0;
+} // End timeToNextPoll()
+
+/**
+ * Clears the statistics. The time in the current state is counted from now on.
+ */
+void MFRC522LowPower::resetStats() {
+	memset(&_stats, 0, sizeof(_stats));
+	_stateStart = _reader.PCD_Bus().now();
+} // End resetStats()
+
+/**
+ * Adds the time since the last state change to the current state and switches to the given state.
+ */
+void MFRC522LowPower::enter(State state) {
+	uint32_t now = _reader.PCD_Bus().now();
+	_stats.time[_state] += now - _stateStart;
+	_stateStart = now;
+	_state = state;
+} // End enter()
+
+/**
+ * Switches the field off and puts the chip into soft power-down.
+ */
+void MFRC522LowPower::sleep() {
+	_reader.PCD_SoftPowerDown();
+	enter(STATE_POWER_DOWN);
+} // End sleep()
@@ -0,0 +1,74 @@
+/**
+ * Duty-cycled card detection on an MFRC522, with the chip in soft power-down between polls.
+ *
+ * Call update() from the main loop; it returns true when a PICC answered a poll:
+ * 		MFRC522 mfrc522(SS_PIN, RST_PIN);
+ * 		MFRC522LowPower lowPower(mfrc522, 100, 1000);	// Poll every 100ms after a tap, back off to 1s
+ * 		...
+ * 		mfrc522.PCD_Init();
+ * 		lowPower.begin();
+ * 		...
+ * 		if (lowPower.update() && mfrc522.PICC_ReadCardSerial()) {
+ * 			...											// The chip stays powered up until the next update()
+ * 		}
+ * 		sleepFor(lowPower.timeToNextPoll());			// Put the MCU to sleep in the meantime
+ *
+ * The poll interval starts at minInterval. Every poll that finds the field empty makes it 1.5 times longer, up to
+ * maxInterval, and a detection sets it back to minInterval. The wake-up time of the oscillator is measured on every
+ * poll and the chip is woken that much earlier, so the polls stay on schedule.
+ *
+ * stats() reports the time spent in each state, to balance the supply current against the time to detect.
+ * The supply current of the MFRC522 is about 10mA in STATE_POLL and STATE_ACTIVE, a few mA in STATE_WAKE_UP and
+ * below 10μA in STATE_POWER_DOWN, see section 8.6 of the datasheet.
+ */
+#ifndef MFRC522LowPower_h
+#define MFRC522LowPower_h
+
+#include "MFRC522.h"
+
+class MFRC522LowPower {
+public:
+	enum State : byte {
+		STATE_POWER_DOWN,			// Soft power-down between polls
+		STATE_WAKE_UP,				// Waiting for the oscillator
+		STATE_POLL,					// Looking for a PICC with the field on
+		STATE_ACTIVE,				// A PICC was found, the caller talks to it
+		STATE_COUNT
+	};
+
+	// Time spent in each state and poll results since the last resetStats()
+	typedef struct {
+		uint32_t time[STATE_COUNT];	// μs in each state, wraps after 71 minutes
+		uint32_t polls;				// Polls done
+		uint32_t detections;		// Polls that found a PICC
+		uint32_t wakeUpMax;			// Longest wake up in μs
+	} Stats;
+
+	MFRC522LowPower(MFRC522 &reader, uint32_t minInterval = 100, uint32_t maxInterval = 1000);
+
+	void begin();
+	bool update();
+	void setIntervals(uint32_t minInterval, uint32_t maxInterval);
+	uint32_t interval() const { return _interval / 1000; };	// Current poll interval in ms
+	uint32_t timeToNextPoll();
+	uint32_t wakeUpTime() const { return _wakeUpTime; };		// Last measured wake up in μs
+	State state() const { return _state; };
+	const Stats &stats() { enter(_state); return _stats; };	// Includes the time in the current state
+	void resetStats();
+
+protected:
+	MFRC522 &_reader;
+	State _state;
+	Stats _stats;
+	uint32_t _minInterval;			// All times in μs
+	uint32_t _maxInterval;
+	uint32_t _interval;
+	uint32_t _wakeUpTime;
+	uint32_t _lastPoll;				// Start of the last poll, the schedule is kept relative to it
+	uint32_t _stateStart;
+
+	void enter(State state);
+	void sleep();
+};
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Presence tracking of the PICC on an MFRC522, with debounced arrival and removal events.
+ */
+#include "MFRC522Tracker.h"
+
+/**
+ * Constructor.
+ */
+MFRC522Tracker::MFRC522Tracker(	MFRC522 &reader,	///< The reader, initialised with PCD_Init() before the first update()
+								byte arriveHits,	///< Number of probes in a row that must see a new PICC before CARD_ARRIVED
+								byte removeMisses	///< Number of probes in a row that must miss the PICC before CARD_REMOVED
+							) : _reader(reader) {
+	setHysteresis(arriveHits, removeMisses);
+	reset();
+} // End constructor
+
+/**
+ * Sets the debounce counts. Both are at least 1.
+ */
+void MFRC522Tracker::setHysteresis(byte arriveHits, byte removeMisses) {
+	_arriveHits = arriveHits ? arriveHits : 1;
+	_removeMisses = removeMisses ? removeMisses : 1;
+} // End setHysteresis()
+
+/**
+ * Forgets the tracked PICC without reporting its removal.
+ */
+void MFRC522Tracker::reset() {
+	_present = false;
+	_hits = 0;
+	_misses = 0;
+	_uid.size = 0;
+} // End reset()
+
+/**
+ * Looks for a PICC or probes the tracked one. Call it periodically.
+ * After CARD_ARRIVED and CARD_STILL_PRESENT the PICC, if it answered, is in state ACTIVE and its UID in the
+ * reader's uid member, so it can be authenticated and read at once.
+ *
+ * @return the event of this update.
+ */
+MFRC522Tracker::Event MFRC522Tracker::update() {
+	if (_present) {
+		if (probe()) {
+			_misses = 0;
+			return CARD_STILL_PRESENT;
+		}
+		if (++_misses < _removeMisses) {
+			return CARD_STILL_PRESENT;		// Not yet debounced
+		}
+		_present = false;
+		_hits = 0;
+		return CARD_REMOVED;
+	}
+
+	// A candidate seen before is probed like a tracked PICC, anything else is searched with REQA.
+	if (_hits && probe()) {
+		_hits++;
+	}
+	else if (_reader.PICC_PollPresence() && _reader.PICC_ReadCardSerial()) {
+		_hits = sameCard(&_reader.uid) ? _hits + 1 : 1;
+		_uid = _reader.uid;
+	}
+	else {
+		_hits = 0;
+		return EVENT_NONE;
+	}
+	if (_hits < _arriveHits) {
+		return EVENT_NONE;
+	}
+	_present = true;
+	_misses = 0;
+	return CARD_ARRIVED;
+} // End update()
+
+/**
+ * Checks that the tracked PICC is in the field and leaves it in state ACTIVE.
+ *
+ * @return true if it answered.
+ */
+bool MFRC522Tracker::probe() {
+	// READ of block/page 0: MIFARE Ultralight and NTAG answer and stay ACTIVE.
+	byte command[4] = {MFRC522::PICC_CMD_MF_READ, 0x00};
+	byte buffer[18];
+	byte length = sizeof(buffer);
+	byte validBits = 0;
+	if (_reader.PCD_CalculateCRC(command, 2, &command[2]) != MFRC522::STATUS_OK) {
+		return false;
+	}
+	// The answer starts after the frame delay time, so the short REQA timeout is enough.
+	if (_reader.PCD_TransceiveData(command, sizeof(command), buffer, &length, &validBits, 0, true, MFRC522::TIMEOUT_REQA) == MFRC522::STATUS_OK) {
+		_reader.uid = _uid;
+		return true;
+	}
+
+	// NAK or no answer: the PICC is in IDLE or HALT now, or gone. Wake it and select it by its UID.
+	MFRC522::Uid uid = _uid;
+	if (_reader.PICC_SelectKnown(&uid) != MFRC522::STATUS_OK) {
+		return false;
+	}
+	if (!sameCard(&uid)) {
+		_reader.PICC_HaltA();		// The full cascade selected another PICC, do not leave it ACTIVE
+		return false;
+	}
+	_uid.sak = uid.sak;
+	_reader.uid = _uid;
+	return true;
+} // End probe()
+
+bool MFRC522Tracker::sameCard(const MFRC522::Uid *uid) const {
+	return uid->size == _uid.size && memcmp(uid->uidByte, _uid.uidByte, _uid.size) == 0;
+} // End sameCard()
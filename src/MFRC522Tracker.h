@@ -0,0 +1,58 @@
+/**
+ * Presence tracking of the PICC on an MFRC522, with debounced arrival and removal events.
+ *
+ * Call update() periodically instead of PICC_IsNewCardPresent() and PICC_ReadCardSerial():
+ * 		MFRC522 mfrc522(SS_PIN, RST_PIN);
+ * 		MFRC522Tracker tracker(mfrc522);
+ * 		...
+ * 		switch (tracker.update()) {
+ * 			case MFRC522Tracker::CARD_ARRIVED:			// mfrc522.uid is the new PICC, it is in state ACTIVE
+ * 			case MFRC522Tracker::CARD_STILL_PRESENT:	// The same PICC is still there, in state ACTIVE
+ * 			case MFRC522Tracker::CARD_REMOVED:			// tracker.uid() is the PICC that left
+ * 			case MFRC522Tracker::EVENT_NONE:			// No PICC
+ * 		}
+ *
+ * While no PICC is tracked the field is polled with PICC_PollPresence(). A tracked PICC is probed with a READ of
+ * block/page 0, which MIFARE Ultralight and NTAG answer without leaving state ACTIVE. A PICC that answers with NAK
+ * or not at all, like MIFARE Classic without authentication, is woken with WUPA and selected by its UID with
+ * PICC_SelectKnown(). No anticollision is run for a PICC that stays on the reader.
+ *
+ * Call update() between transactions, after PCD_StopCrypto1(). ISO/IEC 14443-4 PICCs must be deselected first,
+ * they only answer T=CL blocks after RATS.
+ */
+#ifndef MFRC522Tracker_h
+#define MFRC522Tracker_h
+
+#include "MFRC522.h"
+
+class MFRC522Tracker {
+public:
+	enum Event : byte {
+		EVENT_NONE,					// No PICC is tracked
+		CARD_ARRIVED,				// A PICC was seen arriveHits times in a row
+		CARD_STILL_PRESENT,			// The tracked PICC is there, or missed fewer than removeMisses probes
+		CARD_REMOVED				// The tracked PICC missed removeMisses probes in a row
+	};
+
+	MFRC522Tracker(MFRC522 &reader, byte arriveHits = 1, byte removeMisses = 2);
+
+	Event update();
+	void setHysteresis(byte arriveHits, byte removeMisses);
+	void reset();
+	bool isPresent() const { return _present; };
+	const MFRC522::Uid &uid() const { return _uid; };	// The tracked PICC, or the PICC removed last
+
+protected:
+	MFRC522 &_reader;
+	MFRC522::Uid _uid;
+	bool _present;					// An arrival was reported and no removal yet
+	byte _arriveHits;
+	byte _removeMisses;
+	byte _hits;						// Consecutive probes that saw the candidate before its arrival
+	byte _misses;					// Consecutive probes that missed the tracked PICC
+
+	bool probe();
+	bool sameCard(const MFRC522::Uid *uid) const;
+};
+
+#endif
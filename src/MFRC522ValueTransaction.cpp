@@ -0,0 +1,234 @@
+/*
+ * Batch of MIFARE Classic value block operations and block writes in one sector, run with one authentication.
+ */
+#include "MFRC522ValueTransaction.h"
+
+/**
+ * Constructor.
+ */
+MFRC522ValueTransaction::MFRC522ValueTransaction(	MFRC522 &reader	///< The reader
+												) : _reader(reader) {
+	clear();
+} // End constructor
+
+/**
+ * Drops the queued operations and the expected value.
+ */
+void MFRC522ValueTransaction::clear() {
+	_count = 0;
+	_sector = NO_BLOCK;
+	_verifyBlock = NO_BLOCK;
+	_expected = false;
+} // End clear()
+
+/**
+ * Queues an INCREMENT of a value block, stored by TRANSFER into transferBlock.
+ * The last value operation also selects the block commit() verifies, unless expect() was called.
+ *
+ * @return false if the queue is full or the block is in another sector than the operations queued before.
+ */
+bool MFRC522ValueTransaction::increment(	byte blockAddr,		///< The value block
+											int32_t delta,		///< The amount to add
+											byte transferBlock	///< The block to store the result in, NO_BLOCK for blockAddr
+										) {
+	return queue(MFRC522::PICC_CMD_MF_INCREMENT, blockAddr, transferBlock, nullptr, delta);
+} // End increment()
+
+/**
+ * Queues a DECREMENT of a value block, stored by TRANSFER into transferBlock. See increment().
+ *
+ * @return false if the queue is full or the block is in another sector than the operations queued before.
+ */
+bool MFRC522ValueTransaction::decrement(	byte blockAddr,		///< The value block
+											int32_t delta,		///< The amount to subtract
+											byte transferBlock	///< The block to store the result in, NO_BLOCK for blockAddr
+										) {
+	return queue(MFRC522::PICC_CMD_MF_DECREMENT, blockAddr, transferBlock, nullptr, delta);
+} // End decrement()
+
+/**
+ * Queues a RESTORE of a value block, stored by TRANSFER into transferBlock, ie a copy of the value block.
+ *
+ * @return false if the queue is full or the block is in another sector than the operations queued before.
+ */
+bool MFRC522ValueTransaction::restore(	byte blockAddr,		///< The value block
+										byte transferBlock	///< The block to copy it to
+									) {
+	return queue(MFRC522::PICC_CMD_MF_RESTORE, blockAddr, transferBlock, nullptr, 0);
+} // End restore()
+
+/**
+ * Queues a WRITE that formats a block as value block with the given value, see MFRC522::MIFARE_SetValue().
+ *
+ * @return false if the queue is full or the block is in another sector than the operations queued before.
+ */
+bool MFRC522ValueTransaction::setValue(	byte blockAddr,	///< The block
+										int32_t value	///< The value
+									) {
+	return queue(MFRC522::PICC_CMD_MF_WRITE, blockAddr, blockAddr, nullptr, value);
+} // End setValue()
+
+/**
+ * Queues a WRITE of a data block. The data is not copied, it must stay valid until commit().
+ *
+ * @return false if the queue is full or the block is in another sector than the operations queued before.
+ */
+bool MFRC522ValueTransaction::write(	byte blockAddr,		///< The block
+										const byte *data	///< The 16 bytes to write
+									) {
+	return data != nullptr && queue(MFRC522::PICC_CMD_MF_WRITE, blockAddr, NO_BLOCK, data, 0);
+} // End write()
+
+/**
+ * Sets the block commit() reads back and the value it must hold after the transaction.
+ *
+ * @return false if the block is in another sector than the operations queued before.
+ */
+bool MFRC522ValueTransaction::expect(	byte blockAddr,	///< The value block to verify
+										int32_t value	///< Its expected value
+									) {
+	byte sector = MFRC522::MIFARE_SectorOf(blockAddr);
+	if (_sector != NO_BLOCK && sector != _sector) {
+		return false;
+	}
+	_sector = sector;
+	_verifyBlock = blockAddr;
+	_expected = true;
+	_expectedValue = value;
+	return true;
+} // End expect()
+
+/**
+ * Authenticates the sector and runs the queued operations, then reads back the verify block.
+ * The PICC must be selected - ie in state ACTIVE. The queue is cleared.
+ * Remember to call PCD_StopCrypto1() after communicating with the authenticated PICC.
+ *
+ * @return STATUS_OK if all operations completed and the verification passed, STATUS_ERROR if only the
+ * 		verification failed, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522ValueTransaction::commit(	byte command,				///< PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+														MFRC522::MIFARE_Key *key,	///< The key of the sector
+														MFRC522::Uid *uid,			///< Pointer to Uid struct of the PICC
+														Result *result				///< Out: The outcome. nullptr if not needed.
+													) {
+	Result outcome = {MFRC522::STATUS_OK, 0, false, 0};
+	MFRC522::StatusCode status = MFRC522::STATUS_OK;
+	if (_sector == NO_BLOCK) {
+		status = MFRC522::STATUS_INVALID;		// Nothing queued
+	}
+	else {
+		status = _reader.PCD_Authenticate(command, MFRC522::MIFARE_FirstBlock(_sector), key, uid);
+	}
+	for (byte i = 0; status == MFRC522::STATUS_OK && i < _count; i++) {
+		status = run(&_operations[i]);
+		if (status == MFRC522::STATUS_OK) {
+			outcome.completed += _operations[i].merged;
+		}
+	}
+
+	// Read back the value. Value operations check the format themselves, a broken block already failed above.
+	bool active = (status == MFRC522::STATUS_OK);	// A NAK or a timeout sends the PICC to IDLE
+	if (active && _verifyBlock != NO_BLOCK) {
+		byte buffer[18];
+		byte size = sizeof(buffer);
+		status = _reader.MIFARE_Read(_verifyBlock, buffer, &size);
+		active = (status == MFRC522::STATUS_OK);
+		if (active) {
+			bool valid = true;
+			for (byte i = 0; i < 4; i++) {
+				valid &= (buffer[i] == buffer[i + 8]) && (buffer[i] == (byte)~buffer[i + 4]);
+			}
+			valid &= (buffer[12] == buffer[14]) && (buffer[13] == buffer[15]) && (buffer[12] == (byte)~buffer[13]);
+			outcome.value = (int32_t(buffer[3])<<24) | (int32_t(buffer[2])<<16) | (int32_t(buffer[1])<<8) | int32_t(buffer[0]);
+			outcome.verified = valid && (!_expected || outcome.value == _expectedValue);
+			if (!outcome.verified) {
+				status = MFRC522::STATUS_ERROR;
+			}
+		}
+	}
+	if (!active && _sector != NO_BLOCK) {
+		_reader.PICC_Reactivate(uid);
+	}
+	clear();
+	outcome.status = status;
+	if (result != nullptr) {
+		*result = outcome;
+	}
+	return status;
+} // End commit()
+
+/**
+ * Adds an operation to the queue, or merges it into the last one.
+ */
+bool MFRC522ValueTransaction::queue(	byte command,		///< PICC_CMD_MF_INCREMENT, _DECREMENT, _RESTORE or _WRITE
+										byte blockAddr,		///< The block
+										byte transferBlock,	///< The destination of a value operation, NO_BLOCK for blockAddr
+										const byte *data,	///< The data of a write, nullptr for a value block
+										int32_t value		///< Delta or value
+									) {
+	const byte sector = MFRC522::MIFARE_SectorOf(blockAddr);
+	if (transferBlock == NO_BLOCK) {
+		transferBlock = blockAddr;
+	}
+	if ((_sector != NO_BLOCK && sector != _sector) || MFRC522::MIFARE_SectorOf(transferBlock) != sector) {
+		return false;
+	}
+	if (command != MFRC522::PICC_CMD_MF_WRITE && !_expected) {
+		_verifyBlock = transferBlock;
+	}
+
+	// Increments or decrements of one block into one destination add up. Only the same command is merged,
+	// the access bits of a debit-only block allow DECREMENT but not INCREMENT.
+	Operation *last = _count > 0 ? &_operations[_count - 1] : nullptr;
+	if (last != nullptr && command == last->command && blockAddr == last->blockAddr && transferBlock == last->transferBlock
+			&& (command == MFRC522::PICC_CMD_MF_INCREMENT || command == MFRC522::PICC_CMD_MF_DECREMENT)) {
+		last->value += value;
+		last->merged++;
+		return true;
+	}
+	if (_count >= MFRC522_VALUE_OPERATIONS) {
+		return false;
+	}
+	_sector = sector;
+	Operation *operation = &_operations[_count++];
+	operation->command = command;
+	operation->blockAddr = blockAddr;
+	operation->transferBlock = transferBlock;
+	operation->merged = 1;
+	operation->data = data;
+	operation->value = value;
+	return true;
+} // End queue()
+
+/**
+ * Sends one operation to the PICC.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+MFRC522::StatusCode MFRC522ValueTransaction::run(Operation *operation	///< The operation
+												) {
+	MFRC522::StatusCode status;
+	switch (operation->command) {
+		case MFRC522::PICC_CMD_MF_WRITE:
+			if (operation->data == nullptr) {
+				return _reader.MIFARE_SetValue(operation->blockAddr, operation->value);
+			}
+			return _reader.MIFARE_Write(operation->blockAddr, (byte *)operation->data, 16);
+
+		case MFRC522::PICC_CMD_MF_INCREMENT:
+			status = _reader.MIFARE_Increment(operation->blockAddr, operation->value);
+			break;
+
+		case MFRC522::PICC_CMD_MF_DECREMENT:
+			status = _reader.MIFARE_Decrement(operation->blockAddr, operation->value);
+			break;
+
+		default:
+			status = _reader.MIFARE_Restore(operation->blockAddr);
+			break;
+	}
+	if (status != MFRC522::STATUS_OK) {
+		return status;
+	}
+	return _reader.MIFARE_Transfer(operation->transferBlock);
+} // End run()
@@ -0,0 +1,78 @@
+/**
+ * Batch of MIFARE Classic value block operations and block writes in one sector, run with one authentication.
+ *
+ * Queue the operations, then commit them:
+ * 		MFRC522ValueTransaction transaction(mfrc522);
+ * 		...
+ * 		transaction.decrement(5, price);			// Debit block 5
+ * 		transaction.restore(5, 6);					// Copy the new balance to backup block 6
+ * 		transaction.write(4, logEntry);				// logEntry must stay valid until commit()
+ * 		transaction.expect(5, balance - price);
+ * 		if (transaction.commit(MFRC522::PICC_CMD_MF_AUTH_KEY_A, &key, &mfrc522.uid, &result) == MFRC522::STATUS_OK) {
+ * 			...										// result.value is the balance read back
+ * 		}
+ *
+ * Each value operation is sent as its command, its data and a TRANSFER. The data part has no ACK; the short
+ * TIMEOUT_VALUE_DATA is waited for a NAK instead of the read/write timeout. Consecutive increments or decrements
+ * of the same block into the same destination are merged into one operation. At the end the verify block is read
+ * once, checked for the value block format and, if expect() was called, compared with the expected value.
+ *
+ * After a failure the remaining operations are not run and the PICC is brought back with PICC_Reactivate().
+ * result.completed says how many of the queued operations took effect.
+ */
+#ifndef MFRC522ValueTransaction_h
+#define MFRC522ValueTransaction_h
+
+#include "MFRC522.h"
+
+#ifndef MFRC522_VALUE_OPERATIONS
+#define MFRC522_VALUE_OPERATIONS 8				// Operations a transaction can queue
+#endif
+
+class MFRC522ValueTransaction {
+public:
+	static constexpr byte NO_BLOCK = 0xFF;
+
+	// Outcome of commit()
+	typedef struct {
+		MFRC522::StatusCode status;		// As returned by commit()
+		byte completed;					// Queued operations that took effect, in queue order
+		bool verified;					// The verify block is a valid value block, with the expected value if set
+		int32_t value;					// Value of the verify block read back
+	} Result;
+
+	MFRC522ValueTransaction(MFRC522 &reader);
+
+	void clear();
+	bool increment(byte blockAddr, int32_t delta, byte transferBlock = NO_BLOCK);
+	bool decrement(byte blockAddr, int32_t delta, byte transferBlock = NO_BLOCK);
+	bool restore(byte blockAddr, byte transferBlock);
+	bool setValue(byte blockAddr, int32_t value);
+	bool write(byte blockAddr, const byte *data);
+	bool expect(byte blockAddr, int32_t value);
+	MFRC522::StatusCode commit(byte command, MFRC522::MIFARE_Key *key, MFRC522::Uid *uid, Result *result = nullptr);
+	byte count() const { return _count; };	// Operations queued, after merging
+
+protected:
+	typedef struct {
+		byte command;					// PICC_CMD_MF_INCREMENT, _DECREMENT, _RESTORE or _WRITE
+		byte blockAddr;
+		byte transferBlock;				// Destination of a value operation
+		byte merged;					// Queued operations this one stands for
+		const byte *data;				// PICC_CMD_MF_WRITE: the 16 bytes, nullptr to write value as a value block
+		int32_t value;					// Delta, or the value of a value block
+	} Operation;
+
+	MFRC522 &_reader;
+	Operation _operations[MFRC522_VALUE_OPERATIONS];
+	byte _count;
+	byte _sector;						// Sector of the queued operations, NO_BLOCK if none
+	byte _verifyBlock;					// Block read back by commit(), NO_BLOCK if none
+	bool _expected;						// _expectedValue is set
+	int32_t _expectedValue;
+
+	bool queue(byte command, byte blockAddr, byte transferBlock, const byte *data, int32_t value);
+	MFRC522::StatusCode run(Operation *operation);
+};
+
+#endif